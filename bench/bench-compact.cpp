@@ -0,0 +1,223 @@
+#include "benchmark.h"
+#include "chibi.h"
+
+#include <random>
+#include <set>
+#include <string>
+#include <string.h>
+#include <vector>
+
+// measures how long cmake takes to configure and generate the build files written by chibi, with and without
+// -compact. the workspace has 1,000 libraries with 10 sources, 10 headers, 3 header paths, 5 compile definitions and
+// up to 3 library dependencies each, and 100 apps which depend on up to 5 libraries each. cmake must be in the path.
+// the number of commands executed and the time spent configuring are taken from cmake's profiling output
+
+static const int kNumLibraries = 1000;
+static const int kNumApps = 100;
+static const int kNumRuns = 3;
+
+static void create_directory(const std::string & path)
+{
+	if (!chibi_filesystem::create_directories(path.c_str()))
+	{
+		printf("failed to create directory: %s\n", path.c_str());
+		exit(1);
+	}
+}
+
+static void generate_workspace(const std::string & path)
+{
+	std::mt19937 random(1);
+	
+	std::string root_text;
+	
+	for (int i = 0; i < kNumLibraries; ++i)
+		root_text += "add l" + std::to_string(i) + "\n";
+	for (int i = 0; i < kNumApps; ++i)
+		root_text += "add a" + std::to_string(i) + "\n";
+	
+	for (int i = 0; i < kNumLibraries; ++i)
+	{
+		const std::string name = "l" + std::to_string(i);
+		const std::string library_path = path + "/" + name;
+		
+		create_directory(library_path + "/include");
+		create_directory(library_path + "/private");
+		
+		std::string text = "library " + name + "\n";
+		
+		text += "\tadd_files";
+		for (int j = 0; j < 10; ++j)
+			text += " s" + std::to_string(j) + ".cpp";
+		for (int j = 0; j < 10; ++j)
+			text += " h" + std::to_string(j) + ".h";
+		text += "\n";
+		
+		for (int j = 0; j < 10; ++j)
+		{
+			write_data_file(library_path + "/s" + std::to_string(j) + ".cpp",
+				"int " + name + "_f" + std::to_string(j) + "() { return " + std::to_string(j) + "; }\n");
+			write_data_file(library_path + "/h" + std::to_string(j) + ".h", "");
+		}
+		
+		text += "\theader_path . expose\n";
+		text += "\theader_path include expose\n";
+		text += "\theader_path private\n";
+		
+		const std::string upper_name = "L" + std::to_string(i);
+		
+		text += "\tcompile_definition " + upper_name + "_API 1 expose\n";
+		text += "\tcompile_definition " + upper_name + "_INTERNAL *\n";
+		text += "\tcompile_definition " + upper_name + "_DEBUG 1 config Debug config RelWithDebInfo\n";
+		text += "\tcompile_definition " + upper_name + "_MSVC 1 toolchain msvc\n";
+		text += "\tcompile_definition " + upper_name + "_VERSION 3 expose\n";
+		
+		text += "\tdepend_package Threads\n";
+		text += "\tdepend_library m find\n";
+		text += "\tdepend_library dl find\n";
+		
+		std::set<int> dependencies;
+		for (int j = 0; j < 3 && i > 0; ++j)
+			dependencies.insert(random() % i);
+		for (auto dependency : dependencies)
+			text += "\tdepend_library l" + std::to_string(dependency) + "\n";
+		
+		write_data_file(library_path + "/chibi.txt", text);
+	}
+	
+	for (int i = 0; i < kNumApps; ++i)
+	{
+		const std::string name = "a" + std::to_string(i);
+		const std::string app_path = path + "/" + name;
+		
+		create_directory(app_path);
+		
+		write_data_file(app_path + "/main.cpp", "int main() { return 0; }\n");
+		write_data_file(app_path + "/app.h", "");
+		
+		std::string text = "app " + name + "\n";
+		text += "\tadd_files main.cpp app.h\n";
+		text += "\tcompile_definition APP_" + std::to_string(i) + " 1\n";
+		
+		std::set<int> dependencies;
+		for (int j = 0; j < 5; ++j)
+			dependencies.insert(random() % kNumLibraries);
+		for (auto dependency : dependencies)
+			text += "\tdepend_library l" + std::to_string(dependency) + "\n";
+		
+		write_data_file(app_path + "/chibi.txt", text);
+	}
+	
+	write_data_file(path + "/chibi-root.txt", root_text);
+}
+
+static void run_cmake(const std::string & output_path, const std::string & build_path, const char * extra_arguments)
+{
+	const std::string command =
+		"cmake -S \"" + output_path + "\" -B \"" + build_path + "\" " + extra_arguments + " > /dev/null 2>&1";
+	
+	if (system(command.c_str()) != 0)
+	{
+		printf("failed to run cmake for: %s\n", output_path.c_str());
+		exit(1);
+	}
+}
+
+// reads a cmake profile in the google trace format. each command executed has a begin event, and the time between the
+// first and the last event is the time spent configuring
+static void read_profile(const std::string & profile_filename, int & num_commands, double & configure_time)
+{
+	std::vector<char> text;
+	
+	if (!chibi_filesystem::read_file(profile_filename.c_str(), text))
+	{
+		printf("failed to read profile: %s\n", profile_filename.c_str());
+		exit(1);
+	}
+	
+	text.push_back(0);
+	
+	num_commands = 0;
+	
+	long long first_timestamp = -1;
+	long long last_timestamp = -1;
+	
+	for (const char * p = text.data(); *p != 0; ++p)
+	{
+		if (strncmp(p, "\"ph\" : \"B\"", 10) == 0)
+			num_commands++;
+		else if (strncmp(p, "\"ts\" : ", 7) == 0)
+		{
+			const long long timestamp = strtoll(p + 7, nullptr, 10);
+			
+			if (first_timestamp == -1 || timestamp < first_timestamp)
+				first_timestamp = timestamp;
+			if (last_timestamp == -1 || timestamp > last_timestamp)
+				last_timestamp = timestamp;
+		}
+	}
+	
+	configure_time = (last_timestamp - first_timestamp) / 1000.0; // note : timestamps are in microseconds
+}
+
+static std::string run(const int argc, const char * argv[], const std::string & path, const char * name, const bool compact)
+{
+	const std::string output_path = get_data_path(argc, argv, name);
+	const std::string build_path = get_data_path(argc, argv, (std::string(name) + "-build").c_str());
+	const std::string profile_filename = build_path + "/profile.json";
+	
+	ChibiOptions options;
+	options.use_cache = false;
+	options.compact = compact;
+	
+	if (!chibi_generate(nullptr, path.c_str(), output_path.c_str(), nullptr, 0, nullptr, options))
+	{
+		printf("failed to generate build files for: %s\n", path.c_str());
+		exit(1);
+	}
+	
+	// note : the first configure creates the cache and runs the compiler checks. it isn't part of the measurement
+	
+	run_cmake(output_path, build_path, "");
+	
+	int num_commands = 0;
+	double configure_time = 0.0;
+	
+	for (int i = 0; i < kNumRuns; ++i)
+	{
+		run_cmake(output_path, build_path, ("--profiling-format=google-trace --profiling-output=\"" + profile_filename + "\"").c_str());
+		
+		double run_configure_time;
+		read_profile(profile_filename, num_commands, run_configure_time);
+		
+		if (i == 0 || run_configure_time < configure_time)
+			configure_time = run_configure_time;
+	}
+	
+	const double time = measure_best(kNumRuns, [&]()
+		{
+			run_cmake(output_path, build_path, "");
+		});
+	
+	char line[256];
+	snprintf(line, sizeof(line), "%-8s commands executed: %6d, configure: %6.0f ms, configure + generate: %6.0f ms\n",
+		name, num_commands, configure_time, time);
+	return line;
+}
+
+int main(int argc, const char * argv[])
+{
+	const std::string path = get_data_path(argc, argv, "compact-workspace");
+	
+	generate_workspace(path);
+	
+	std::string results;
+	results += run(argc, argv, path, "default", false);
+	results += run(argc, argv, path, "compact", true);
+	
+	// note : chibi_generate prints its progress, so the results are printed together at the end
+	
+	printf("\n%s", results.c_str());
+	
+	return 0;
+}
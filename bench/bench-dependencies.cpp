@@ -0,0 +1,91 @@
+#include "benchmark.h"
+#include "chibi.h"
+
+#include <random>
+#include <string>
+
+// measures how the time to generate the build files scales with the number of targets. each workspace has a single
+// add_files per target, and up to three dependencies per target on earlier libraries. every tenth target is an app.
+// the entire run is measured, with caching disabled
+
+static const int kNumRuns = 3;
+
+static std::string generate_workspace(const std::string & path, const int num_targets)
+{
+	std::mt19937 random(1);
+	
+	std::string root_text;
+	
+	for (int i = 0; i < num_targets; ++i)
+	{
+		const std::string name = "t" + std::to_string(i);
+		const bool is_app = (i % 10) == 9;
+		
+		root_text += "add " + name + "\n";
+		
+		std::string text = (is_app ? "app " : "library ") + name + "\n";
+		text += "\tadd_files main.cpp\n";
+		
+		for (int j = 0; j < 3 && i >= 10; ++j)
+		{
+			// note : apps can't be depended upon. the target before an app is always a library
+			
+			int dependency = random() % i;
+			
+			if ((dependency % 10) == 9)
+				dependency--;
+			
+			text += "\tdepend_library t" + std::to_string(dependency) + "\n";
+		}
+		
+		const std::string target_path = path + "/" + name;
+		
+		if (!chibi_filesystem::create_directories(target_path.c_str()))
+		{
+			printf("failed to create directory: %s\n", target_path.c_str());
+			exit(1);
+		}
+		
+		write_data_file(target_path + "/chibi.txt", text);
+		write_data_file(target_path + "/main.cpp", "int " + name + "_function() { return 0; }\n");
+	}
+	
+	write_data_file(path + "/chibi-root.txt", root_text);
+	
+	return path;
+}
+
+int main(int argc, const char * argv[])
+{
+	std::string results;
+	
+	for (const int num_targets : { 100, 1000, 3000, 10000 })
+	{
+		const std::string name = "dependencies-" + std::to_string(num_targets);
+		
+		const std::string path = generate_workspace(get_data_path(argc, argv, name.c_str()), num_targets);
+		const std::string output_path = get_data_path(argc, argv, (name + "-output").c_str());
+		
+		ChibiOptions options;
+		options.use_cache = false;
+		
+		const double time = measure_best(kNumRuns, [&]()
+			{
+				if (!chibi_generate(nullptr, path.c_str(), output_path.c_str(), nullptr, 0, nullptr, options))
+				{
+					printf("failed to generate build files for: %s\n", path.c_str());
+					exit(1);
+				}
+			});
+		
+		char line[128];
+		snprintf(line, sizeof(line), "%6d targets: %9.1f ms\n", num_targets, time);
+		results += line;
+	}
+	
+	// note : chibi_generate prints its progress, so the results are printed together at the end
+	
+	printf("\n%s", results.c_str());
+	
+	return 0;
+}
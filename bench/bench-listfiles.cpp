@@ -0,0 +1,49 @@
+#include "benchmark.h"
+#include "filesystem.h"
+#include "threadpool.h"
+
+#include <string>
+#include <vector>
+
+// measures how fast a directory tree is listed, using listFiles with traversal on a tree of 200k files spread over
+// 4,000 leaf directories. the tree is listed once before measuring, so the file system caches are hot
+
+using namespace chibi_filesystem;
+
+static const int kNumDirectories = 40;
+static const int kNumSubdirectories = 100;
+static const int kNumFiles = 50;
+static const int kNumRuns = 5;
+
+int main(int argc, const char * argv[])
+{
+	const std::string path = get_data_path(argc, argv, "listfiles");
+	
+	for (int i = 0; i < kNumDirectories; ++i)
+	{
+		for (int j = 0; j < kNumSubdirectories; ++j)
+		{
+			const std::string directory = path + "/d" + std::to_string(i) + "/s" + std::to_string(j);
+			
+			if (!create_directories(directory.c_str()))
+			{
+				printf("failed to create directory: %s\n", directory.c_str());
+				return 1;
+			}
+			
+			for (int k = 0; k < kNumFiles; ++k)
+				write_data_file(directory + "/f" + std::to_string(k) + ".cpp", "");
+		}
+	}
+	
+	size_t num_files = listFiles(path.c_str(), true).size();
+	
+	const double time = measure_best(kNumRuns, [&]()
+		{
+			num_files = listFiles(path.c_str(), true).size();
+		});
+	
+	printf("listed %d files in %.1f ms, using %d threads\n", (int)num_files, time, chibi::get_thread_count());
+	
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "benchmark.h"
+#include "chibi.h"
+
+#include <string>
+#include <vector>
+
+// measures how fast chibi files are parsed, using list_chibi_targets on a single chibi-root.txt file with a
+// library definition of 100k lines. one file consists mostly of lines skipped by with_platform filters and comments,
+// the other of lines which add files, compile definitions and header paths
+
+static const int kNumLines = 100000;
+static const int kNumParses = 10;
+
+// note : the filters target platforms other than the one chibi runs on, so the lines are skipped
+static std::string generate_filtered_lines()
+{
+	std::string text = "library big\n";
+	
+	for (int i = 0; i < kNumLines - 1; ++i)
+	{
+		if (i % 3 == 0)
+			text += "\twith_platform macos add_files a" + std::to_string(i) + ".cpp b" + std::to_string(i) + ".cpp - group \"src files\"\n";
+		else if (i % 3 == 1)
+			text += "\twith_platform windows compile_definition FOO_" + std::to_string(i) + " 1 expose config Debug\n";
+		else
+			text += "\t# a comment about things " + std::to_string(i) + "\n";
+	}
+	
+	return text;
+}
+
+static std::string generate_keyword_lines()
+{
+	std::string text = "library big\n";
+	
+	for (int i = 0; i < kNumLines - 1; ++i)
+	{
+		const std::string index = std::to_string(i / 5);
+		
+		if (i % 5 == 0)
+			text += "\tadd_files a" + index + ".cpp b" + index + ".cpp - group \"src files\"\n";
+		else if (i % 5 == 1)
+			text += "\twith_platform linux compile_definition FOO_" + index + " 1 expose config Debug\n";
+		else if (i % 5 == 2)
+			text += "\twith_platform macos depend_library pthread global\n";
+		else if (i % 5 == 3)
+			text += "\t# a comment\n";
+		else
+			text += "\theader_path include" + index + "\n";
+	}
+	
+	return text;
+}
+
+static void run(const char * name, const std::string & path, const std::string & text)
+{
+	const std::string build_root = path + "/chibi-root.txt";
+	
+	write_data_file(build_root, text);
+	
+	// note : the first parse warms up the file cache
+	
+	std::vector<std::string> library_targets;
+	std::vector<std::string> app_targets;
+	
+	if (!list_chibi_targets(build_root.c_str(), library_targets, app_targets))
+	{
+		printf("failed to parse: %s\n", build_root.c_str());
+		exit(1);
+	}
+	
+	const double time = measure_best(1, [&]()
+		{
+			for (int i = 0; i < kNumParses; ++i)
+			{
+				library_targets.clear();
+				app_targets.clear();
+				
+				list_chibi_targets(build_root.c_str(), library_targets, app_targets);
+			}
+		}) / kNumParses;
+	
+	printf("%-10s %8.1f ms per parse, %6.2fM lines/s\n", name, time, kNumLines / time / 1000.0);
+}
+
+int main(int argc, const char * argv[])
+{
+	run("filtered", get_data_path(argc, argv, "parse-filtered"), generate_filtered_lines());
+	run("keywords", get_data_path(argc, argv, "parse-keywords"), generate_keyword_lines());
+	
+	return 0;
+}
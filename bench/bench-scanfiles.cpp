@@ -0,0 +1,125 @@
+#include "benchmark.h"
+#include "chibi.h"
+
+#include <atomic>
+#include <new>
+#include <string>
+
+#if !defined(_MSC_VER)
+	#include <sys/resource.h>
+#endif
+
+// measures the memory used when generating the build files for a workspace with many files. the workspace has 30
+// libraries of 10,000 files each, half of which are part of a conglomerate. the number of allocations and the peak
+// resident set size are reported along with the time, for a single run with caching disabled
+
+static const int kNumLibraries = 30;
+static const int kNumDirectories = 100;
+static const int kNumFiles = 50;
+
+static std::atomic<int64_t> s_num_allocations(0);
+
+void * operator new(size_t size)
+{
+	s_num_allocations++;
+	
+	void * result = malloc(size == 0 ? 1 : size);
+	
+	if (result == nullptr)
+		throw std::bad_alloc();
+	
+	return result;
+}
+
+void operator delete(void * p) noexcept
+{
+	free(p);
+}
+
+// returns the peak resident set size in megabytes, or -1 when unknown
+static double get_peak_memory_usage()
+{
+#if defined(_MSC_VER)
+	return -1.0;
+#else
+	struct rusage usage;
+	
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1.0;
+	
+	#if defined(__APPLE__)
+		return usage.ru_maxrss / (1024.0 * 1024.0); // in bytes
+	#else
+		return usage.ru_maxrss / 1024.0; // in kilobytes
+	#endif
+#endif
+}
+
+static void generate_files(const std::string & path)
+{
+	for (int i = 0; i < kNumDirectories; ++i)
+	{
+		const std::string directory = path + "/d" + std::to_string(i);
+		
+		if (!chibi_filesystem::create_directories(directory.c_str()))
+		{
+			printf("failed to create directory: %s\n", directory.c_str());
+			exit(1);
+		}
+		
+		for (int j = 0; j < kNumFiles; ++j)
+			write_data_file(directory + "/f" + std::to_string(j) + ".cpp", "");
+	}
+}
+
+static void generate_workspace(const std::string & path)
+{
+	std::string root_text;
+	
+	for (int i = 0; i < kNumLibraries; ++i)
+	{
+		const std::string name = "l" + std::to_string(i);
+		
+		root_text += "add " + name + "\n";
+		
+		const std::string library_path = path + "/" + name;
+		
+		generate_files(library_path + "/src");
+		generate_files(library_path + "/unity");
+		
+		write_data_file(library_path + "/chibi.txt",
+			"library " + name + "\n"
+			"\tscan_files cpp path src traverse group src\n"
+			"\tscan_files cpp path unity traverse group unity conglomerate unity-" + name + ".cpp\n");
+	}
+	
+	write_data_file(path + "/chibi-root.txt", root_text);
+}
+
+int main(int argc, const char * argv[])
+{
+	const std::string path = get_data_path(argc, argv, "scanfiles");
+	const std::string output_path = get_data_path(argc, argv, "scanfiles-output");
+	
+	generate_workspace(path);
+	
+	ChibiOptions options;
+	options.use_cache = false;
+	
+	const int64_t num_allocations = s_num_allocations;
+	
+	const double time = measure_best(1, [&]()
+		{
+			if (!chibi_generate(nullptr, path.c_str(), output_path.c_str(), nullptr, 0, nullptr, options))
+			{
+				printf("failed to generate build files for: %s\n", path.c_str());
+				exit(1);
+			}
+		});
+	
+	printf("\ntime: %.1f ms\n", time);
+	printf("allocations: %lld\n", (long long)(s_num_allocations - num_allocations));
+	printf("peak memory usage: %.1f MB\n", get_peak_memory_usage());
+	
+	return 0;
+}
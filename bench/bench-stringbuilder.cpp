@@ -0,0 +1,75 @@
+#include "benchmark.h"
+#include "stringbuilder.h"
+
+#include <string>
+
+// measures how fast text is formatted into a StringBuilder, by writing 2,000 add_library sections of 100 files each,
+// formatted the way the cmake writer does, and by formatting 200k short strings using a temporary builder each. also
+// checks that a single long line is formatted in full
+
+using namespace chibi;
+
+static const int kNumLibraries = 2000;
+static const int kNumFiles = 100;
+static const int kNumTemporaries = 200000;
+static const int kNumRuns = 5;
+
+static void write_libraries(StringBuilder & sb)
+{
+	for (int i = 0; i < kNumLibraries; ++i)
+	{
+		sb.AppendFormat("add_library(library%d STATIC\n", i);
+		
+		for (int j = 0; j < kNumFiles; ++j)
+			sb.AppendFormat("\t\"${CMAKE_CURRENT_SOURCE_DIR}/libraries/library%d/source/subdirectory/file%d.cpp\"\n", i, j);
+		
+		sb.Append(")\n");
+		sb.Append("\n");
+		
+		sb.AppendFormat("target_compile_definitions(library%d PUBLIC LIBRARY%d_ENABLED=1)\n", i, i);
+		sb.Append("\n");
+	}
+}
+
+int main()
+{
+	size_t size = 0;
+	
+	const double time = measure_best(kNumRuns, [&]()
+		{
+			StringBuilder sb;
+			write_libraries(sb);
+			
+			size = sb.text.size();
+		});
+	
+	printf("formatted %.1f MB in %.1f ms, %.0f MB/s\n", size / 1000000.0, time, size / 1000.0 / time);
+	
+	// the writers use many small builders for things like quoted paths and option lists
+	
+	const double temporaries_time = measure_best(kNumRuns, [&]()
+		{
+			size = 0;
+			
+			for (int i = 0; i < kNumTemporaries; ++i)
+			{
+				StringBuilder sb;
+				sb.AppendFormat("\"${CMAKE_CURRENT_SOURCE_DIR}/file%d.cpp\"", i);
+				
+				size += sb.text.size();
+			}
+		});
+	
+	printf("formatted %d temporaries in %.1f ms\n", kNumTemporaries, temporaries_time);
+	
+	// a single line which used to be cut off at 4 KB
+	
+	const std::string long_text(10000, 'x');
+	
+	StringBuilder sb;
+	sb.AppendFormat("set(LONG_LINE \"%s\")\n", long_text.c_str());
+	
+	printf("a line with %d characters of text formatted to %d characters\n", (int)long_text.size(), (int)sb.text.size());
+	
+	return 0;
+}
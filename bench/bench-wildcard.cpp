@@ -0,0 +1,66 @@
+#include "benchmark.h"
+#include "wildcard.h"
+
+#include <string>
+#include <vector>
+
+// measures how fast compiled wildcard patterns are matched against 200k paths, a third of which don't match the
+// extension patterns. the patterns cover the ';' separated lists used by scan_files, the extension sets used for
+// scanning source files, and a pattern which needs the general matcher
+
+using namespace chibi;
+
+static const int kNumPaths = 200000;
+static const int kNumRuns = 5;
+
+static std::vector<std::string> generate_paths()
+{
+	const char * extensions[] = { "cpp", "mm", "c", "cpp", "h", "txt" };
+	
+	std::vector<std::string> paths;
+	
+	for (int i = 0; i < kNumPaths; ++i)
+	{
+		paths.push_back(
+			"root/a" + std::to_string(i % 37) +
+			"/b" + std::to_string(i % 11) +
+			"/file" + std::to_string(i) + "." + extensions[i % 6]);
+	}
+	
+	return paths;
+}
+
+static void run(const char * name, const WildcardPattern & pattern, const std::vector<std::string> & paths)
+{
+	int num_matches = 0;
+	
+	const double time = measure_best(kNumRuns, [&]()
+		{
+			num_matches = 0;
+			
+			for (auto & path : paths)
+				if (pattern.match(path.c_str()))
+					num_matches++;
+		});
+	
+	printf("%-22s %7.2f ms, %d matches\n", name, time, num_matches);
+}
+
+int main()
+{
+	const std::vector<std::string> paths = generate_paths();
+	
+	WildcardPattern list_pattern;
+	list_pattern.add("*.cpp;*.mm;*.c", ';');
+	run("*.cpp;*.mm;*.c", list_pattern, paths);
+	
+	WildcardPattern extension_pattern;
+	extension_pattern.set_extensions("cpp|mm|c", '|');
+	run("cpp|mm|c", extension_pattern, paths);
+	
+	WildcardPattern glob_pattern;
+	glob_pattern.add("**/a1*/**/*.[cm]*", ';');
+	run("**/a1*/**/*.[cm]*", glob_pattern, paths);
+	
+	return 0;
+}
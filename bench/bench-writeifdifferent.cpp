@@ -0,0 +1,79 @@
+#include "benchmark.h"
+#include "filesystem.h"
+
+#include <string>
+#include <vector>
+
+// measures how fast write_if_different checks 2,000 generated files of 16 KB each. the common case is that none of
+// the files changed, which only compares the files. the files are also written with their last character changed,
+// which compares the files all the way to the end before writing them
+
+using namespace chibi_filesystem;
+
+static const int kNumFiles = 2000;
+static const int kFileSize = 16 * 1024;
+static const int kNumRuns = 5;
+
+static std::string generate_text(const int index)
+{
+	std::string text;
+	
+	while (text.size() < kFileSize)
+		text += "\t\"${CMAKE_CURRENT_SOURCE_DIR}/source/file" + std::to_string(index) + ".cpp\"\n";
+	
+	text.resize(kFileSize - 1);
+	text += "\n";
+	
+	return text;
+}
+
+static void write_files(const std::vector<std::string> & filenames, const std::vector<std::string> & texts)
+{
+	for (size_t i = 0; i < filenames.size(); ++i)
+	{
+		if (!write_if_different(texts[i].c_str(), filenames[i].c_str()))
+		{
+			printf("failed to write file: %s\n", filenames[i].c_str());
+			exit(1);
+		}
+	}
+}
+
+int main(int argc, const char * argv[])
+{
+	const std::string path = get_data_path(argc, argv, "writeifdifferent");
+	
+	std::vector<std::string> filenames;
+	std::vector<std::string> texts;
+	std::vector<std::string> changed_texts;
+	
+	for (int i = 0; i < kNumFiles; ++i)
+	{
+		filenames.push_back(path + "/file" + std::to_string(i) + ".txt");
+		texts.push_back(generate_text(i));
+		
+		changed_texts.push_back(texts.back());
+		changed_texts.back().back() = '\t';
+	}
+	
+	write_files(filenames, texts);
+	
+	const double unchanged_time = measure_best(kNumRuns, [&]()
+		{
+			write_files(filenames, texts);
+		});
+	
+	// note : alternate between the two versions, so every run has to write all of the files
+	
+	int num_changed_runs = 0;
+	
+	const double changed_time = measure_best(kNumRuns, [&]()
+		{
+			write_files(filenames, (num_changed_runs++ % 2) == 0 ? changed_texts : texts);
+		});
+	
+	printf("%d files of %d KB, unchanged: %.1f ms\n", kNumFiles, kFileSize / 1024, unchanged_time);
+	printf("%d files of %d KB, last character changed: %.1f ms\n", kNumFiles, kFileSize / 1024, changed_time);
+	
+	return 0;
+}
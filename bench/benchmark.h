@@ -0,0 +1,59 @@
+#pragma once
+
+#include "filesystem.h"
+
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+// each benchmark is an executable of its own, which generates its inputs inside the directory passed on the command
+// line (bench-data by default), and prints its measurements. build with -DCHIBI_BUILD_BENCHMARKS=ON and a release
+// configuration. to compare against a previous version, check it out and run the same benchmark against it
+
+static std::string get_data_path(const int argc, const char * argv[], const char * name)
+{
+	const std::string base_path = argc >= 2 ? argv[1] : "bench-data";
+	
+	const std::string path = base_path + "/" + name;
+	
+	if (!chibi_filesystem::create_directories(path.c_str()))
+	{
+		printf("failed to create directory: %s\n", path.c_str());
+		exit(1);
+	}
+	
+	return path;
+}
+
+static void write_data_file(const std::string & filename, const std::string & text)
+{
+	if (!chibi_filesystem::write_if_different(text.c_str(), filename.c_str()))
+	{
+		printf("failed to write file: %s\n", filename.c_str());
+		exit(1);
+	}
+}
+
+// runs the function num_runs times, and returns the fastest time in milliseconds
+static double measure_best(const int num_runs, const std::function<void()> & function)
+{
+	double best_time = 0.0;
+	
+	for (int i = 0; i < num_runs; ++i)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		
+		function();
+		
+		const auto end = std::chrono::steady_clock::now();
+		
+		const double time = std::chrono::duration<double, std::milli>(end - begin).count();
+		
+		if (i == 0 || time < best_time)
+			best_time = time;
+	}
+	
+	return best_time;
+}
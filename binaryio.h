@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <string.h>
+#include <vector>
+
+namespace chibi
+{
+	struct BinaryWriter
+	{
+		std::vector<char> data;
+		
+		void write_bytes(const void * bytes, const size_t size)
+		{
+			data.insert(data.end(), (const char*)bytes, (const char*)bytes + size);
+		}
+		
+		void write_bool(const bool value)
+		{
+			data.push_back(value ? 1 : 0);
+		}
+		
+		void write_int32(const int32_t value)
+		{
+			write_bytes(&value, sizeof(value));
+		}
+		
+		void write_int64(const int64_t value)
+		{
+			write_bytes(&value, sizeof(value));
+		}
+		
+		void write_string(const std::string & value)
+		{
+			write_int32((int32_t)value.size());
+			write_bytes(value.data(), value.size());
+		}
+		
+		void write_strings(const std::vector<std::string> & values)
+		{
+			write_int32((int32_t)values.size());
+			for (auto & value : values)
+				write_string(value);
+		}
+	};
+	
+	/**
+	 * Reads values written using BinaryWriter. Reading past the end of the data sets the error flag,
+	 * after which all reads return default values. Callers check the error flag once when done.
+	 */
+	struct BinaryReader
+	{
+		const char * ptr;
+		const char * end;
+		
+		bool error = false;
+		
+		BinaryReader(const char * in_data, const size_t size)
+			: ptr(in_data)
+			, end(in_data + size)
+		{
+		}
+		
+		bool read_bytes(void * bytes, const size_t size)
+		{
+			if (error || size_t(end - ptr) < size)
+			{
+				error = true;
+				return false;
+			}
+			
+			memcpy(bytes, ptr, size);
+			ptr += size;
+			
+			return true;
+		}
+		
+		bool read_bool()
+		{
+			char value = 0;
+			read_bytes(&value, 1);
+			return value != 0;
+		}
+		
+		int32_t read_int32()
+		{
+			int32_t value = 0;
+			read_bytes(&value, sizeof(value));
+			return value;
+		}
+		
+		int64_t read_int64()
+		{
+			int64_t value = 0;
+			read_bytes(&value, sizeof(value));
+			return value;
+		}
+		
+		// reads the number of elements of an array, checking the count is plausible given the remaining data
+		int32_t read_count()
+		{
+			const int32_t count = read_int32();
+			
+			if (count < 0 || count > end - ptr)
+			{
+				error = true;
+				return 0;
+			}
+			
+			return count;
+		}
+		
+		void read_string(std::string & value)
+		{
+			const int32_t size = read_count();
+			
+			value.assign(ptr, size);
+			ptr += size;
+		}
+		
+		void read_strings(std::vector<std::string> & values)
+		{
+			const int32_t count = read_count();
+			
+			values.resize(count);
+			
+			for (auto & value : values)
+				read_string(value);
+		}
+	};
+}
@@ -0,0 +1,168 @@
+#include "buildlog.h"
+#include "filesystem.h"
+#include "stringhelpers.h"
+
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace chibi_filesystem;
+
+namespace chibi
+{
+	// extracts the target and source path from the name of an object file, as generated by cmake:
+	// CMakeFiles/<target>.dir/<source path>.o. returns false for anything other than an object file
+	static bool parse_object_filename(const std::string & output, std::string & target, std::string & source)
+	{
+		size_t length;
+		
+		if (string_ends_with(output, ".o"))
+			length = output.size() - 2;
+		else if (string_ends_with(output, ".obj"))
+			length = output.size() - 4;
+		else
+			return false;
+		
+		const size_t target_begin = output.find("CMakeFiles/");
+		
+		if (target_begin == std::string::npos)
+			return false;
+		
+		const size_t target_end = output.find(".dir/", target_begin);
+		
+		if (target_end == std::string::npos)
+			return false;
+		
+		target = output.substr(target_begin + 11, target_end - target_begin - 11);
+		source = output.substr(target_end + 5, length - target_end - 5);
+		
+		// note : cmake replaces the colon following drive letters on Windows with an underscore
+		
+		if (source.size() >= 3 && isalpha(source[0]) && source[1] == '_' && source[2] == '/')
+			source[1] = ':';
+		
+		return target.empty() == false && source.empty() == false;
+	}
+	
+	bool BuildLog::load(const char * path)
+	{
+		entries.clear();
+		
+		std::vector<char> contents;
+		
+		if (!read_file(path, contents))
+		{
+			// check if the path is a build directory instead
+			
+			const std::string filename = std::string(path) + "/.ninja_log";
+			
+			if (!read_file(filename.c_str(), contents))
+				return false;
+		}
+		
+		contents.push_back(0);
+		
+		char * line = contents.data();
+		
+		// header
+		
+		if (strncmp(line, "# ninja log v5\n", 15) != 0 &&
+			strncmp(line, "# ninja log v6\n", 15) != 0)
+		{
+			return false;
+		}
+		
+		line += 15;
+		
+		// entries. each line lists: start time, end time, modification time, output, and command hash, separated by
+		// tabs. ninja appends a new line each time an output is built, so only the last one is current. an output
+		// built again moves to the end of the list, which keeps the entries ordered by the time they were built
+		
+		std::map<std::string, size_t> entry_indices;
+		
+		std::vector<bool> is_superseded;
+		
+		while (line[0] != 0)
+		{
+			char * end = strchr(line, '\n');
+			
+			if (end != nullptr)
+				*end = 0;
+			
+			char * fields[5];
+			int num_fields = 0;
+			
+			for (char * field = line; num_fields < 5; )
+			{
+				fields[num_fields++] = field;
+				
+				char * separator = strchr(field, '\t');
+				
+				if (separator == nullptr)
+					break;
+				
+				*separator = 0;
+				field = separator + 1;
+			}
+			
+			if (num_fields == 5)
+			{
+				const std::string output = fields[3];
+				
+				Entry entry;
+				
+				if (parse_object_filename(output, entry.target, entry.source))
+				{
+					entry.duration = strtoll(fields[1], nullptr, 10) - strtoll(fields[0], nullptr, 10);
+					
+					auto entry_index_itr = entry_indices.find(output);
+					
+					if (entry_index_itr != entry_indices.end())
+						is_superseded[entry_index_itr->second] = true;
+					
+					entry_indices[output] = entries.size();
+					entries.push_back(entry);
+					is_superseded.push_back(false);
+				}
+			}
+			
+			if (end == nullptr)
+				break;
+			
+			line = end + 1;
+		}
+		
+		size_t num_entries = 0;
+		
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			if (is_superseded[i])
+				continue;
+			
+			// note : entries which stay in place are left alone, as moving a string onto itself empties it
+			
+			if (num_entries != i)
+				entries[num_entries] = std::move(entries[i]);
+			
+			num_entries++;
+		}
+		
+		entries.resize(num_entries);
+		
+		return true;
+	}
+	
+	bool BuildLog::source_matches(const std::string & filename, const std::string & source)
+	{
+		// note : cmake uses the path relative to the source or build directory when the file is located inside
+		//        either of them, and the absolute path without its root otherwise. in both cases it is a trailing
+		//        part of the source file's path
+		
+		if (string_ends_with(filename, source) == false)
+			return false;
+		
+		return
+			filename.size() == source.size() ||
+			filename[filename.size() - source.size() - 1] == '/';
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace chibi
+{
+	/**
+	 * The compile times measured during a previous build, as read from the .ninja_log file Ninja writes to the
+	 * build directory.
+	 */
+	struct BuildLog
+	{
+		struct Entry
+		{
+			std::string target; // the cmake target the object file belongs to
+			std::string source; // the path of the source file, as cmake derives the object file name from it
+			
+			int64_t duration = 0; // in milliseconds
+		};
+		
+		std::vector<Entry> entries; // the most recent entry for each object file, ordered by the time they were built
+		
+		/**
+		 * Reads the build log. Log versions 5 and 6 are supported.
+		 * @param path A .ninja_log file, or a build directory containing one.
+		 */
+		bool load(const char * path);
+		
+		/**
+		 * Checks whether the given source file matches the source path of a log entry. Object file names only contain
+		 * a part of the source path, depending on its location relative to the build files.
+		 */
+		static bool source_matches(const std::string & filename, const std::string & source);
+	};
+}
@@ -3,21 +3,62 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "dependencygraph.h"
 #include "stringhelpers.h" // todo : move to cpp file
+#include "stringpool.h"
+#include "wildcard.h"
 
 #define ENABLE_PKGCONFIG 0 // todo : pkgconfig shouldn't be used in chibi.txt files. but it would be nice to define libraries using pkgconfig externally, as a sort of aliases, which can be used in a normalized fashion as a regular library
 
+struct ChibiLibrary;
+
 struct ChibiLibraryFile
 {
 	std::string filename;
 	
-	std::string group;
+	chibi::InternedString group; // note : group and conglomerate names are interned, as they repeat for many files
 	
-	std::string conglomerate_filename;
+	chibi::InternedString conglomerate_filename;
 	
 	bool compile = true;
+	
+	bool auto_conglomerate = false; // compile the file as part of an automatically partitioned conglomerate
+	
+	bool is_modified = false; // the file differs from the git index. in adaptive mode it's compiled by itself, rather than as part of its conglomerate
+	
+	bool use_precompiled_header = true; // false for files which can't use the precompiled header of their target, such as generated translation unit linkage files
+};
+
+enum ChibiScanSource
+{
+	kScanSource_Filesystem, // list the files inside the directory
+	kScanSource_Git // list the files tracked by the git repository containing the directory
+};
+
+/**
+ * A scan_files operation. Scans are run after parsing, and only for the libraries which are part of the build.
+ */
+struct ChibiFileScan
+{
+	std::string path; // the directory to scan
+	std::string extensions; // extensions or wildcard pattern
+	
+	bool traverse = false;
+	
+	ChibiScanSource source = kScanSource_Filesystem;
+	
+	std::vector<std::string> excluded_paths;
+	std::vector<std::string> excluded_files; // files removed using exclude_files after the scan
+	
+	std::string group;
+	std::string conglomerate_filename;
+	
+	bool auto_conglomerate = false;
+	
+	size_t file_index = 0; // the location within the library's files where the scanned files are inserted
 };
 
 struct ChibiLibraryDependency
@@ -37,6 +78,8 @@ struct ChibiLibraryDependency
 	Type type = kType_Undefined;
 	
 	bool embed_framework = false;
+	
+	ChibiLibrary * library = nullptr; // the library target for generated dependencies. set by ChibiInfo::resolve_library_dependencies
 };
 
 struct ChibiPackageDependency
@@ -80,6 +123,8 @@ struct ChibiCompileDefinition
 
 struct ChibiLibrary
 {
+	int id = -1; // index into ChibiInfo::libraries, used as the node id in the dependency graph
+	
 	std::string name;
 	std::string path;
 	std::string group_name;
@@ -92,8 +137,13 @@ struct ChibiLibrary
 	
 	bool isExecutable = false;
 	
+	bool auto_conglomerate = false; // partition all of the source files into automatically generated conglomerates
+	int auto_conglomerate_size = 0; // the amount of source code to put into each automatically generated conglomerate, in bytes. zero for the default
+	
 	std::vector<ChibiLibraryFile> files;
 	
+	std::vector<ChibiFileScan> file_scans; // pending scan_files operations
+	
 	std::vector<ChibiLibraryDependency> library_dependencies;
 	
 	std::vector<ChibiPackageDependency> package_dependencies;
@@ -113,6 +163,17 @@ struct ChibiLibrary
 
 	std::vector<std::string> link_translation_unit_using_function_calls;
 	
+	std::string precompiled_header; // the header to precompile and include into each c++ file. empty when not set
+	bool precompiled_header_expose = false; // use the precompiled header for dependents without a precompiled header of their own
+	
+	ChibiLibrary() = default;
+	
+	// libraries may hold many thousands of files. make sure they are moved rather than copied
+	ChibiLibrary(const ChibiLibrary &) = delete;
+	ChibiLibrary(ChibiLibrary &&) = default;
+	ChibiLibrary & operator=(const ChibiLibrary &) = delete;
+	ChibiLibrary & operator=(ChibiLibrary &&) = default;
+	
 	void dump_info() const
 	{
 		printf("%s: %s\n", isExecutable ? "app" : "library", name.c_str());
@@ -139,34 +200,72 @@ struct ChibiInfo
 {
 	std::set<std::string> build_targets;
 	
+	chibi::WildcardPattern build_target_pattern; // the build targets, compiled into a single pattern
+	
 	std::vector<ChibiLibrary*> libraries;
 	
+	std::unordered_map<std::string, ChibiLibrary*> libraries_by_name;
+	
 	std::vector<std::string> cmake_module_paths;
 	
+	chibi::DependencyGraph dependency_graph; // built after the library dependencies are resolved
+	
+	std::vector<std::string> input_paths; // the chibi files read and the directories and git indices scanned for files. the build files need to be generated again when one of these changes
+	
+	std::vector<std::string> fingerprint_paths; // files which affect the output, but which aren't worth configuring again for as soon as they change. they're only recorded in the fingerprint, and checked the next time chibi runs
+	
 	~ChibiInfo()
 	{
 		for (auto * library : libraries)
 			delete library;
 	}
 	
-	bool library_exists(const char * name) const
+	// adds the library and takes ownership of it. fails when a library with the same name already exists
+	bool add_library(ChibiLibrary * library)
 	{
-		for (auto & library : libraries)
-		{
-			if (library->name == name)
-				return true;
-		}
+		if (libraries_by_name.emplace(library->name, library).second == false)
+			return false;
+		
+		library->id = (int)libraries.size();
 		
-		return false;
+		libraries.push_back(library);
+		
+		return true;
+	}
+	
+	bool library_exists(const char * name) const
+	{
+		return libraries_by_name.count(name) != 0;
 	}
 	
 	ChibiLibrary * find_library(const char * name) const
 	{
-		for (auto & library : libraries)
-			if (library->name == name)
-				return library;
+		auto i = libraries_by_name.find(name);
 		
-		return nullptr;
+		if (i == libraries_by_name.end())
+			return nullptr;
+		else
+			return i->second;
+	}
+	
+	// resolves generated library dependencies to the library targets they refer to, so later passes can walk the
+	// dependency graph without looking up libraries by name. dependencies on unknown libraries are left unresolved
+	void resolve_library_dependencies()
+	{
+		for (auto * library : libraries)
+		{
+			for (auto & library_dependency : library->library_dependencies)
+			{
+				if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
+					library_dependency.library = find_library(library_dependency.name.c_str());
+			}
+		}
+	}
+	
+	void add_build_target(const char * name)
+	{
+		if (build_targets.insert(name).second)
+			build_target_pattern.add(name, ';');
 	}
 	
 	bool should_build_target(const char * name) const
@@ -176,13 +275,7 @@ struct ChibiInfo
 		else if (build_targets.count(name) != 0)
 			return true;
 		else
-		{
-			for (auto & build_target : build_targets)
-				if (chibi::match_wildcard(name, build_target.c_str(), ';'))
-					return true;
-		}
-		
-		return false;
+			return build_target_pattern.match(name);
 	}
 	
 	void dump_info() const
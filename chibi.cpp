@@ -1,11 +1,19 @@
+#include "chibi.h"
 #include "chibi-internal.h"
 #include "filesystem.h"
+#include "fingerprint.h"
+#include "gitindex.h"
+#include "parsecache.h"
 #include "stringhelpers.h"
+#include "threadpool.h"
+#include "wildcard.h"
 
 #include <algorithm> // std::remove_if, std::replace
 #include <assert.h>
 #include <limits.h> // PATH_MAX
+#include <memory> // std::unique_ptr
 #include <stdarg.h>
+#include <stdint.h>
 #include <string>
 #include <string.h>
 #include <vector>
@@ -17,9 +25,9 @@ using namespace chibi_filesystem;
 
 namespace chibi
 {
-	bool write_cmake_file(const ChibiInfo & chibi_info, const char * platform, const char * output_filename);
+	bool write_cmake_file(const ChibiInfo & chibi_info, const char * platform, const char * output_filename, const ChibiOptions & options, const std::vector<std::string> & regenerate_command, const char * regenerate_working_directory, std::vector<std::string> & input_paths, std::vector<std::string> & output_paths);
 	
-	bool write_gradle_files(const ChibiInfo & chibi_info, const char * output_path);
+	bool write_gradle_files(const ChibiInfo & chibi_info, const char * output_path, std::vector<std::string> & output_paths);
 }
 
 // todo : create library targets which are an alias for an existing system library, such as libusb, libsdl2, etc -> will allow to normalize library names, and to use either the system version or compile from source version interchangable
@@ -95,8 +103,6 @@ namespace chibi
 	#define sscanf_s sscanf
 #endif
 
-static thread_local ssize_t s_current_line_length = 0;
-
 static bool file_exist(const char * path)
 {
 	FILE * f = fopen(path, "rb");
@@ -112,59 +118,190 @@ static bool file_exist(const char * path)
 	}
 }
 
-static std::vector<std::string> s_currentFile; // fixme : make safe for concurrent use of library version of chibi
-
-struct ChibiFileScope
+/**
+ * A token inside a chibi file. Tokens point directly into the text buffer of the chibi file.
+ */
+struct ChibiToken
 {
-	ChibiFileScope(const char * filename)
+	const char * text;
+	
+	int length;
+	
+	bool equals(const char * word) const
 	{
-		s_currentFile.push_back(filename);
+		return strncmp(text, word, length) == 0 && word[length] == 0;
 	}
+};
+
+static bool is_separator(const char c)
+{
+	// note : we avoid isspace here, as it's relatively slow and we look at every character of every chibi file
+	
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
 
-	~ChibiFileScope()
+/**
+ * A single line of a chibi file. Tokens are extracted on demand, so the remainder of a line which is
+ * filtered out by a platform filter is never looked at. Tokens are zero-terminated in-place, which is
+ * safe as the terminator always replaces a separator or closing quote which isn't part of any token.
+ */
+struct ChibiLine
+{
+	char * begin = nullptr;
+	char * end = nullptr;
+	
+	char * ptr = nullptr;
+	
+	// extracts the next token. quoted strings are supported and are stored without quotes
+	bool next_token(ChibiToken & token)
+	{
+		while (ptr < end && is_separator(*ptr))
+			ptr++;
+		
+		if (ptr == end)
+			return false;
+		
+		if (*ptr == '"')
+		{
+			ptr++;
+			
+			token.text = ptr;
+			
+			while (ptr < end && *ptr != '"')
+				ptr++;
+		}
+		else
+		{
+			token.text = ptr;
+			
+			while (ptr < end && is_separator(*ptr) == false)
+				ptr++;
+		}
+		
+		token.length = int(ptr - token.text);
+		
+		if (ptr < end)
+			*ptr++ = 0;
+		
+		return true;
+	}
+	
+	// eats the next token and stores the result in 'word'
+	bool eat_word(const char *& word)
 	{
-		s_currentFile.pop_back();
+		ChibiToken token;
+		
+		if (!next_token(token))
+			return false;
+		
+		word = token.text;
+		
+		return true;
 	}
 };
 
-static void report_error(const char * line, const char * format, ...)
+static bool read_text_file(const char * filename, std::vector<char> & text)
+{
+	if (!read_file(filename, text))
+		return false;
+	
+	// note : we append a zero terminator, so the last line is terminated just like all of the others
+	
+	text.push_back(0);
+	
+	return true;
+}
+
+/**
+ * Finds the next line of text, and advances the text pointer to the start of the line after it.
+ * @return False when the end of the text is reached.
+ */
+static bool next_line(char *& text, char * text_end, ChibiLine & line)
+{
+	if (text == text_end)
+		return false;
+	
+	char * end = (char*)memchr(text, '\n', text_end - text);
+	
+	if (end == nullptr)
+		end = text_end;
+	
+	line.begin = text;
+	line.end = end;
+	line.ptr = text;
+	
+	text = end == text_end ? end : end + 1;
+	
+	// terminate the line, so the last token on it is terminated too
+	
+	*end = 0;
+	
+	return true;
+}
+
+static void report_error_in_file(const char * filename, const ChibiLine * line, const char * format, va_list ap)
 {
 	char text[1024];
-	va_list ap;
-	va_start(ap, format);
 	vsprintf_s(text, sizeof(text), format, ap);
-	va_end(ap);
 	
-	//
+	// note : chibi files are parsed concurrently. we build the complete message first and print it in one go, so
+	//        messages from different threads do not get interleaved
+	
+	std::string message;
 	
 	if (line != nullptr)
 	{
-		printf(">>");
+		message.append(">>");
 		
-		for (int i = 0; i < s_current_line_length; )
+		// note : tokens which have been processed are zero-terminated. we print them separated by spaces
+		
+		for (const char * ptr = line->begin; ptr < line->end; )
 		{
-			while (is_whitespace(line[i]))
-				i++;
+			while (ptr < line->end && (*ptr == 0 || is_separator(*ptr)))
+				ptr++;
 			
-			if (i < s_current_line_length)
+			if (ptr < line->end)
 			{
-				printf(" %s", line + i);
-			
-				while (line[i] != 0)
-					i++;
-			
-				i++;
+				message.push_back(' ');
+				message.append(ptr);
+				
+				ptr += strlen(ptr);
 			}
 		}
 		
-		printf("\n");
+		message.push_back('\n');
 	}
 	
 	//
 	
-	printf("error: %s\n", text);
-	if (!s_currentFile.empty())
-		printf("in file: %s\n", s_currentFile.back().c_str());
+	message.append("error: ");
+	message.append(text);
+	message.push_back('\n');
+	
+	if (filename != nullptr)
+	{
+		message.append("in file: ");
+		message.append(filename);
+		message.push_back('\n');
+	}
+	
+	fputs(message.c_str(), stdout);
+}
+
+static void report_error(const char * format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	report_error_in_file(nullptr, nullptr, format, ap);
+	va_end(ap);
+}
+
+static void report_error_in_file(const char * filename, const char * format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	report_error_in_file(filename, nullptr, format, ap);
+	va_end(ap);
 }
 
 static bool is_absolute_path(const char * path)
@@ -181,32 +318,177 @@ static bool is_absolute_path(const char * path)
 #endif
 }
 
-// fixme : make all of these safe for concurrent use of library version of chibi
-
-static ChibiLibrary * s_currentLibrary = nullptr;
-
-static std::string s_platform;
-static std::string s_platform_full;
-
-static bool is_platform(const char * platform)
+/**
+ * The state shared by all of the chibi files parsed during a single run.
+ */
+struct ChibiParseContext
 {
-	if (match_element(s_platform.c_str(), platform, '|'))
-		return true;
-	else if (s_platform_full.empty() == false && match_element(s_platform_full.c_str(), platform, '|'))
-		return true;
-	else
-		return false;
-}
+	std::string platform;
+	std::string platform_full;
+	
+	bool skip_file_scan = false;
+	
+	bool adaptive_conglomerates = false; // compile files which differ from the git index by themselves, rather than as part of a conglomerate
+	
+	TaskGroup * task_group = nullptr;
+	
+	bool use_parse_cache = false;
+	
+	int64_t start_time = 0; // the time at which chibi started reading its inputs
+	
+	ParseCache parse_cache; // parse results from the previous run
+	
+	DirectoryCache * directory_cache = nullptr; // directory listings shared by all of the scan_files operations
+	
+	GitIndexCache * git_index_cache = nullptr; // git indices shared by all of the scan_files operations
+	
+	ParseCache new_parse_cache; // parse results from the current run, to be saved when done
+	
+	bool parse_cache_changed = false;
+	
+	int num_chibi_files = 0;
+	int num_cached_chibi_files = 0;
+	
+	std::string get_parse_cache_key(const char * filename, const std::string & group, const ChibiScanSource scan_source) const
+	{
+		std::string key;
+		key.reserve(strlen(filename) + group.size() + platform.size() + platform_full.size() + 5);
+		key.append(filename);
+		key.push_back('\n');
+		key.append(group);
+		key.push_back('\n');
+		key.push_back('0' + scan_source);
+		key.push_back('\n');
+		key.append(platform);
+		key.push_back('\n');
+		key.append(platform_full);
+		return key;
+	}
+	
+	bool is_platform(const char * name) const
+	{
+		if (match_element(platform.c_str(), name, '|'))
+			return true;
+		else if (platform_full.empty() == false && match_element(platform_full.c_str(), name, '|'))
+			return true;
+		else
+			return false;
+	}
+
+	bool is_platform_full(const char * name) const
+	{
+		auto & full =
+			platform_full.empty()
+			? platform
+			: platform_full;
+			
+		return match_element(full.c_str(), name, '|');
+	}
+};
 
-static bool is_platform_full(const char * platform)
+/**
+ * The result of parsing a single chibi file. Files are parsed independently and concurrently. The results
+ * are merged into ChibiInfo afterwards, in the order in which libraries and files appear in the chibi files.
+ */
+struct ChibiFileResult
 {
-	auto & platform_full =
-		s_platform_full.empty()
-		? s_platform
-		: s_platform_full;
+	enum EntryType
+	{
+		kEntryType_Library,
+		kEntryType_CMakeModulePath,
+		kEntryType_ChibiFile
+	};
+	
+	struct Entry
+	{
+		EntryType type;
 		
-	return match_element(platform_full.c_str(), platform, '|');
-}
+		size_t index;
+	};
+	
+	std::string filename;
+	
+	std::string group; // the group name active at the point where the file was added
+	
+	ChibiScanSource scan_source = kScanSource_Filesystem; // the scan source active at the point where the file was added
+	
+	bool success = false;
+	
+	// information for the parse cache. set when parse caching is enabled
+	
+	int64_t mtime = -1;
+	int64_t size = 0;
+	uint64_t content_hash = 0;
+	
+	std::vector<ParseCacheDependency> dependencies;
+	
+	const ParseCacheEntry * cache_entry = nullptr; // set when the result was loaded from the parse cache
+	
+	std::vector<Entry> entries;
+	
+	std::vector<ChibiLibrary*> libraries;
+	
+	std::vector<std::string> cmake_module_paths;
+	
+	std::vector<std::unique_ptr<ChibiFileResult>> chibi_files;
+	
+	~ChibiFileResult()
+	{
+		for (auto * library : libraries)
+			delete library;
+	}
+	
+	void add_library(ChibiLibrary * library)
+	{
+		Entry entry;
+		entry.type = kEntryType_Library;
+		entry.index = libraries.size();
+		entries.push_back(entry);
+		
+		libraries.push_back(library);
+	}
+	
+	void add_cmake_module_path(const char * path)
+	{
+		Entry entry;
+		entry.type = kEntryType_CMakeModulePath;
+		entry.index = cmake_module_paths.size();
+		entries.push_back(entry);
+		
+		cmake_module_paths.push_back(path);
+	}
+	
+	ChibiFileResult * add_chibi_file(const char * filename, const std::string & group, const ChibiScanSource scan_source)
+	{
+		ChibiFileResult * chibi_file = new ChibiFileResult();
+		
+		chibi_file->filename = filename;
+		chibi_file->group = group;
+		chibi_file->scan_source = scan_source;
+		
+		Entry entry;
+		entry.type = kEntryType_ChibiFile;
+		entry.index = chibi_files.size();
+		entries.push_back(entry);
+		
+		chibi_files.emplace_back(chibi_file);
+		
+		return chibi_file;
+	}
+	
+	void add_dependency(const char * path)
+	{
+		ParseCacheDependency dependency;
+		dependency.path = path;
+		
+		int64_t size;
+		
+		if (!get_file_info(path, dependency.mtime, size))
+			dependency.mtime = -1;
+		
+		dependencies.push_back(dependency);
+	}
+};
 
 static void show_syntax_elem(const char * format, const char * description)
 {
@@ -220,6 +502,7 @@ void show_chibi_syntax()
 	show_syntax_elem("add_root <path>", "adds a chibi-root file to the workspace");
 	show_syntax_elem("push_group <name>", "pushes a group name. libraries and apps will be grouped by this name. push_group must be followed by a matching pop_group");
 	show_syntax_elem("pop_group", "restored the group name");
+	show_syntax_elem("scan_source <git | filesystem>", "sets the default source for scan_files, for the current file and all of the chibi files added after it. when set to git, scan_files lists the files tracked by the git repository, by reading its index file, instead of listing the contents of directories. defaults to filesystem");
 
 	printf("chibi syntax (global):\n");
 	show_syntax_elem("app <app_name>", "adds an app target with the given name");
@@ -230,7 +513,7 @@ void show_chibi_syntax()
 	printf("\n");
 	printf("chibi syntax (within app or library context):\n");
 	show_syntax_elem("add_dist_files <file>..", "adds one or more files to to be bundled with the application, when the build type is set to distribution");
-	show_syntax_elem("add_files <file>.. [- [conglomerate <conglomerate_file>]]", "adds one or more files to compile. the list of files may optionally be terminated by '-', after which further options may be specified");
+	show_syntax_elem("add_files <file>.. [- [conglomerate <conglomerate_file>] [auto_conglomerate]]", "adds one or more files to compile. the list of files may optionally be terminated by '-', after which further options may be specified. see auto_conglomerate for [auto_conglomerate]");
 	show_syntax_elem("compile_definition <name> <value> [expose]", "adds a compile definition. when <value> is set to *, the compile definition is merely defined, without a value. when <expose> is set, the compile_definition is visible to all targets that depends on the current target");
 	show_syntax_elem("depend_library <library_name> [local | global | find]", "adds a target dependency. <library_name> may refer to a chibi library target, or to a pre-built library or system library. when [local] is set, the file is interpreted as a pre-built library to be found at the given location, relative to the current chibi file. When [global] is set, the system-global library is used. When [find] is set, the library will be searched for on the system");
 	show_syntax_elem("depend_package <package_name>", "depends on a package, to be found using one of cmake's find_package scripts. <package_name> defines the name of the cmake package script");
@@ -239,1189 +522,1801 @@ void show_chibi_syntax()
 	show_syntax_elem("header_path <path> [expose]", "specify a header search path. when [expose] is set, the search path will be propagated to all dependent targets");
 	show_syntax_elem("resource_path <path>", "specify the resource_path. CHIBI_RESOURCE_PATH will be set appropriately to the given path for debug and release builds. for the distribution build type, files located at resource_path will be bundled with the app and CHIBI_RESOURCE_PATH will be set to the relative search path within the bundle");
 	show_syntax_elem("license_file <path>", "specify license file(s) for a library");
-	show_syntax_elem("scan_files <extension_or_wildcard> [path <path>].. [traverse] [group <group_name>] [conglomerate <conglomerate_file>]", "adds files by scanning the given path or the path of the current chibi file. files will be filtered using the extension or wildcard pattern provided. [path] can be used to specify a specific folder to look inside. [traverse] may be set to recursively look for files down the directory hierarchy. when [group] is specified, files found through the scan operation will be grouped by this name in generated ide project files. when [conglomerate] is set, the files will be concatenated into this files, and the generated file will be added instead. [conglomerate] may be used to speed up compile times by compiling a set of files in one go");
+	show_syntax_elem("scan_files <extension_or_wildcard> [path <path>].. [traverse] [group <group_name>] [conglomerate <conglomerate_file>] [auto_conglomerate] [source <git | filesystem>]", "adds files by scanning the given path or the path of the current chibi file. files will be filtered using the extension or wildcard pattern provided. multiple extensions may be separated by '|' and multiple wildcard patterns by ';'. wildcard patterns support '*' (within a directory), '**' (across directories), '?' and character classes like [a-z]. [path] can be used to specify a specific folder to look inside. [traverse] may be set to recursively look for files down the directory hierarchy. when [group] is specified, files found through the scan operation will be grouped by this name in generated ide project files. when [conglomerate] is set, the files will be concatenated into this files, and the generated file will be added instead. [conglomerate] may be used to speed up compile times by compiling a set of files in one go. when [auto_conglomerate] is set, the files are partitioned into conglomerates automatically. see auto_conglomerate. [source] overrides the scan source set using scan_source. when the source is git and the path isn't part of a git repository, the file system is scanned instead");
 	show_syntax_elem("push_conglomerate <name>", "pushes a conglomerate file. files will automatically be added to the given conglomerate file. push_conglomerate must be followed by a matching pop_conglomerate");
+	show_syntax_elem("auto_conglomerate [size <kilobytes>]", "partitions the source files of the library which aren't part of a conglomerate already into automatically generated conglomerates, of roughly [size] kilobytes of source code each (256 by default). the partitions are balanced by size, so the conglomerates still compile in parallel, and a file being added or removed only changes the conglomerates next to it, so most of them don't need to be compiled again. files added using add_files or scan_files with the [auto_conglomerate] option are partitioned the same way, even when the library itself doesn't use auto_conglomerate. when chibi is invoked with -build-log, the partitions are balanced by the compile times measured during the previous build instead");
 	show_syntax_elem("link_translation_unit_using_function_call <function_name>", "adds a function to be called at the app level to ensure the translation unit in a dependent (static) library doesn't get stripped away by the linker");
+	show_syntax_elem("precompiled_header <file> [expose]", "precompiles the given header, and includes it into each c++ file of the target, so the headers it includes are parsed once rather than for each file. conglomerates include it once for all of their files. when [expose] is set, dependent targets without a precompiled header of their own use it too. libraries compiled with the same compile definitions reuse the precompiled header of the target exposing it, others precompile the header themselves. requires cmake 3.16 or later, and is ignored otherwise");
 }
 
-static bool process_chibi_root_file(ChibiInfo & chibi_info, const char * filename, const std::string & current_group, const bool skip_file_scan);
-static bool process_chibi_file(ChibiInfo & chibi_info, const char * filename, const std::string & current_group, const bool skip_file_scan);
+/**
+ * The per-file state used while parsing a chibi file.
+ */
+struct ChibiFileParser
+{
+	const ChibiParseContext & context;
+	
+	ChibiFileResult & result;
+	
+	ChibiLibrary * current_library = nullptr;
+	
+	char chibi_path[PATH_MAX];
+	
+	std::vector<std::string> group_stack;
+	
+	std::vector<std::string> conglomerate_stack;
+	
+	ChibiScanSource scan_source = kScanSource_Filesystem;
+	
+	ChibiFileParser(const ChibiParseContext & in_context, ChibiFileResult & in_result)
+		: context(in_context)
+		, result(in_result)
+	{
+	}
+	
+	void report_error(const ChibiLine * line, const char * format, ...) const
+	{
+		va_list ap;
+		va_start(ap, format);
+		report_error_in_file(result.filename.c_str(), line, format, ap);
+		va_end(ap);
+	}
+	
+	void report_error(const ChibiLine & line, const char * format, ...) const
+	{
+		va_list ap;
+		va_start(ap, format);
+		report_error_in_file(result.filename.c_str(), &line, format, ap);
+		va_end(ap);
+	}
+	
+	void add_chibi_file(const char * filename, const std::string & group);
+	
+	bool parse();
+	
+	bool handle_add(ChibiLine & line);
+	bool handle_push_group(ChibiLine & line);
+	bool handle_pop_group(ChibiLine & line);
+	bool handle_add_root(ChibiLine & line);
+	bool handle_scan_source(ChibiLine & line);
+	bool handle_library(ChibiLine & line);
+	bool handle_app(ChibiLine & line);
+	bool handle_cmake_module_path(ChibiLine & line);
+	bool handle_add_files(ChibiLine & line);
+	bool handle_scan_files(ChibiLine & line);
+	bool handle_exclude_files(ChibiLine & line);
+	bool handle_depend_package(ChibiLine & line);
+	bool handle_depend_library(ChibiLine & line);
+	bool handle_header_path(ChibiLine & line);
+	bool handle_compile_definition(ChibiLine & line);
+	bool handle_resource_path(ChibiLine & line);
+	bool handle_license_file(ChibiLine & line);
+	bool handle_group(ChibiLine & line);
+	bool handle_add_dist_files(ChibiLine & line);
+	bool handle_push_conglomerate(ChibiLine & line);
+	bool handle_pop_conglomerate(ChibiLine & line);
+	bool handle_auto_conglomerate(ChibiLine & line);
+	bool handle_link_translation_unit_using_function_call(ChibiLine & line);
+	bool handle_precompiled_header(ChibiLine & line);
+};
+
+static void process_chibi_file(const ChibiParseContext & context, ChibiFileResult & result);
 
-static bool process_chibi_root_file(ChibiInfo & chibi_info, const char * filename, const std::string & current_group, const bool skip_file_scan)
+static void schedule_chibi_file(const ChibiParseContext & context, ChibiFileResult * chibi_file)
 {
-	return process_chibi_file(chibi_info, filename, current_group, skip_file_scan);
+	// parse the chibi file on one of the worker threads. the result is merged later, in the order in which files are added
+	
+	context.task_group->add([&context, chibi_file]()
+		{
+			process_chibi_file(context, *chibi_file);
+		});
 }
 
-static bool process_chibi_file(ChibiInfo & chibi_info, const char * filename, const std::string & current_group, const bool skip_file_scan)
+static void write_chibi_file_result(BinaryWriter & writer, const ChibiFileResult & result)
 {
-	ChibiFileScope chibi_scope(filename);
-
-	s_currentLibrary = nullptr;
+	writer.write_int32((int32_t)result.entries.size());
 	
-	std::vector<std::string> group_stack;
-	group_stack.push_back(current_group);
+	for (auto & entry : result.entries)
+	{
+		writer.write_int32(entry.type);
+		
+		if (entry.type == ChibiFileResult::kEntryType_Library)
+		{
+			write_library(writer, *result.libraries[entry.index]);
+		}
+		else if (entry.type == ChibiFileResult::kEntryType_CMakeModulePath)
+		{
+			writer.write_string(result.cmake_module_paths[entry.index]);
+		}
+		else if (entry.type == ChibiFileResult::kEntryType_ChibiFile)
+		{
+			auto & chibi_file = *result.chibi_files[entry.index];
+			
+			writer.write_string(chibi_file.filename);
+			writer.write_string(chibi_file.group);
+			writer.write_int32(chibi_file.scan_source);
+		}
+	}
+}
+
+static bool read_chibi_file_result(BinaryReader & reader, ChibiFileResult & result)
+{
+	const int32_t num_entries = reader.read_count();
 	
-	std::vector<std::string> conglomerate_stack;
+	for (int32_t i = 0; i < num_entries && reader.error == false; ++i)
+	{
+		const int32_t type = reader.read_int32();
+		
+		if (type == ChibiFileResult::kEntryType_Library)
+		{
+			ChibiLibrary * library = new ChibiLibrary();
+			
+			result.add_library(library);
+			
+			if (!read_library(reader, *library))
+				return false;
+		}
+		else if (type == ChibiFileResult::kEntryType_CMakeModulePath)
+		{
+			std::string path;
+			reader.read_string(path);
+			
+			result.add_cmake_module_path(path.c_str());
+		}
+		else if (type == ChibiFileResult::kEntryType_ChibiFile)
+		{
+			std::string filename;
+			std::string group;
+			reader.read_string(filename);
+			reader.read_string(group);
+			const ChibiScanSource scan_source = (ChibiScanSource)reader.read_int32();
+			
+			result.add_chibi_file(filename.c_str(), group, scan_source);
+		}
+		else
+		{
+			return false;
+		}
+	}
 	
-	char chibi_path[PATH_MAX];
+	return reader.error == false;
+}
 
-	if (!get_path_from_filename(filename, chibi_path, PATH_MAX))
+static bool load_chibi_file_result_from_cache(const ChibiParseContext & context, ChibiFileResult & result)
+{
+	const ParseCacheEntry * entry = context.parse_cache.find(context.get_parse_cache_key(result.filename.c_str(), result.group, result.scan_source));
+	
+	if (entry == nullptr)
+		return false;
+	
+	int64_t mtime;
+	
+	if (!validate_parse_cache_entry(*entry, result.filename.c_str(), mtime))
+		return false;
+	
+	BinaryReader reader(entry->data.data(), entry->data.size());
+	
+	if (!read_chibi_file_result(reader, result))
 	{
-		report_error(nullptr, "failed to get path from chibi filename: %s", filename);
+		// the cache entry is corrupt. discard whatever we read so far, so the file can be parsed normally
+		
+		for (auto * library : result.libraries)
+			delete library;
+		result.libraries.clear();
+		result.cmake_module_paths.clear();
+		result.chibi_files.clear();
+		result.entries.clear();
+		
 		return false;
 	}
 	
-	//
+	result.mtime = mtime;
+	result.size = entry->size;
+	result.content_hash = entry->content_hash;
+	result.dependencies = entry->dependencies;
+	result.cache_entry = entry;
 	
-	FileHandle f(filename, "rt");
+	return true;
+}
 
-	if (f == nullptr)
+static void process_chibi_file(const ChibiParseContext & context, ChibiFileResult & result)
+{
+	if (context.use_parse_cache && load_chibi_file_result_from_cache(context, result))
 	{
-		report_error(nullptr, "failed to open %s", filename);
+		result.success = true;
+		
+		for (auto & chibi_file : result.chibi_files)
+			schedule_chibi_file(context, chibi_file.get());
+		
+		return;
+	}
+	
+	ChibiFileParser parser(context, result);
+	
+	result.success = parser.parse();
+}
+
+void ChibiFileParser::add_chibi_file(const char * filename, const std::string & group)
+{
+	ChibiFileResult * chibi_file = result.add_chibi_file(filename, group, scan_source);
+	
+	schedule_chibi_file(context, chibi_file);
+}
+
+bool ChibiFileParser::handle_add(ChibiLine & line)
+{
+	const char * location;
+	
+	if (!line.eat_word(location))
+	{
+		report_error(line, "missing location");
 		return false;
 	}
 	else
 	{
-		char * line = nullptr;
-		size_t lineSize = 0;
-
-		for (;;)
+		char chibi_file[PATH_MAX];
+		
+		if (!concat(chibi_file, sizeof(chibi_file), chibi_path, "/", location, "/chibi.txt"))
 		{
-			ssize_t r = my_getline(&line, &lineSize, f);
-
-			if (r < 0)
-			{
-				s_current_line_length = 0;
-				break;
-			}
-			else
+			report_error(line, "failed to create absolute path");
+			return false;
+		}
+		
+		add_chibi_file(chibi_file, group_stack.back());
+		
+		current_library = nullptr;
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_push_group(ChibiLine & line)
+{
+	const char * name;
+	
+	if (!line.eat_word(name))
+	{
+		report_error(line, "missing group name");
+		return false;
+	}
+	
+	group_stack.push_back(name);
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_pop_group(ChibiLine & line)
+{
+	if (group_stack.size() == 1)
+	{
+		report_error(line, "no group left to pop");
+		return false;
+	}
+
+	group_stack.pop_back();
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_add_root(ChibiLine & line)
+{
+	const char * location;
+	
+	if (!line.eat_word(location))
+	{
+		report_error(line, "missing location");
+		return false;
+	}
+	else
+	{
+		char chibi_file[PATH_MAX];
+		
+		if (!concat(chibi_file, sizeof(chibi_file), chibi_path, "/", location, "/chibi-root.txt"))
+		{
+			report_error(line, "failed to create absolute path");
+			return false;
+		}
+		
+		add_chibi_file(chibi_file, group_stack.back());
+		
+		current_library = nullptr;
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_scan_source(ChibiLine & line)
+{
+	const char * name;
+	
+	if (!line.eat_word(name))
+	{
+		report_error(line, "missing scan source");
+		return false;
+	}
+	
+	if (!strcmp(name, "git"))
+		scan_source = kScanSource_Git;
+	else if (!strcmp(name, "filesystem"))
+		scan_source = kScanSource_Filesystem;
+	else
+	{
+		report_error(line, "unknown scan source: %s", name);
+		return false;
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_library(ChibiLine & line)
+{
+	current_library = nullptr;
+	
+	const char * name;
+	bool shared = false;
+	bool prebuilt = false;
+	bool objc_arc = false;
+	
+	if (!line.eat_word(name))
+	{
+		report_error(line, "missing name");
+		return false;
+	}
+	
+	for (;;)
+	{
+		const char * option;
+		
+		if (line.eat_word(option) == false)
+			break;
+		
+		if (!strcmp(option, "shared"))
+			shared = true;
+		else if (!strcmp(option, "prebuilt"))
+			prebuilt = true;
+		else if (!strcmp(option, "objc-arc"))
+			objc_arc = true;
+		else
+		{
+			report_error(line, "unknown option: %s", option);
+			return false;
+		}
+	}
+	
+	ChibiLibrary * library = new ChibiLibrary();
+	
+	library->name = name;
+	library->path = chibi_path;
+	library->chibi_file = result.filename;
+	
+	if (group_stack.back().empty() == false)
+		library->group_name = group_stack.back();
+	
+	library->shared = shared;
+	library->prebuilt = prebuilt;
+	library->objc_arc = objc_arc;
+	
+	result.add_library(library);
+	
+	current_library = library;
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_app(ChibiLine & line)
+{
+	current_library = nullptr;
+	
+	const char * name;
+	
+	if (!line.eat_word(name))
+	{
+		report_error(line, "missing name");
+		return false;
+	}
+	
+	ChibiLibrary * library = new ChibiLibrary();
+	
+	library->name = name;
+	library->path = chibi_path;
+	library->chibi_file = result.filename;
+	
+	if (group_stack.back().empty() == false)
+		library->group_name = group_stack.back();
+	
+	library->isExecutable = true;
+	
+	result.add_library(library);
+	
+	current_library = library;
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_cmake_module_path(ChibiLine & line)
+{
+	const char * path;
+	
+	if (!line.eat_word(path))
+	{
+		report_error(line, "cmake_module_path without path");
+		return false;
+	}
+	
+	char full_path[PATH_MAX];
+	if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
+	{
+		report_error(line, "failed to create absolute path");
+		return false;
+	}
+	
+	result.add_cmake_module_path(full_path);
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_add_files(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "add_files without a target");
+		return false;
+	}
+	else
+	{
+		std::vector<ChibiLibraryFile> library_files;
+		
+		const char * group = nullptr;
+		
+		const char * conglomerate =
+			conglomerate_stack.empty()
+			? nullptr
+			: conglomerate_stack.back().c_str();
+		
+		bool absolute = false;
+		
+		bool auto_conglomerate = false;
+		
+		bool done = false;
+		
+		// parse file list
+		
+		for (;;)
+		{
+			const char * filename;
+			
+			if (!line.eat_word(filename))
 			{
-				//printf("%s\n", line);
-				
-				s_current_line_length = r;
-				
-				if (is_comment_or_whitespace(line))
-					continue;
-				
-				char * linePtr = line;
-				
-				if (eat_word(linePtr, "with_platform"))
-				{
-					const char * platform;
-					
-					if (!eat_word_v2(linePtr, platform))
-					{
-						report_error(line, "with_platform without platform");
-						return false;
-					}
-					
-					if (is_platform(platform) == false)
-						continue;
-				}
+				done = true;
+				break;
+			}
+			
+			if (!strcmp(filename, "-"))
+				break;
+			
+			ChibiLibraryFile file;
+			
+			file.filename = filename;
+			
+			library_files.push_back(std::move(file));
+		}
+		
+		// parse options
+		
+		if (done == false)
+		{
+			for (;;)
+			{
+				const char * option;
 				
-				if (eat_word(linePtr, "with_platform_full"))
+				if (!line.eat_word(option))
 				{
-					const char * platform;
-					
-					if (!eat_word_v2(linePtr, platform))
-					{
-						report_error(line, "with_platform_full without platform");
-						return false;
-					}
-					
-					if (is_platform_full(platform) == false)
-						continue;
+					done = true;
+					break;
 				}
 				
-				//
-				
-				if (eat_word(linePtr, "add"))
-				{
-					const char * location;
-					
-					if (!eat_word_v2(linePtr, location))
-					{
-						report_error(line, "missing location");
-						return false;
-					}
-					else
-					{
-						char chibi_file[PATH_MAX];
-						
-						if (!concat(chibi_file, sizeof(chibi_file), chibi_path, "/", location, "/chibi.txt"))
-						{
-							report_error(line, "failed to create absolute path");
-							return false;
-						}
-						
-						const int length = s_current_line_length;
-						
-						const bool success = process_chibi_file(chibi_info, chibi_file, group_stack.back(), skip_file_scan);
-						
-						s_currentLibrary = nullptr;
-						
-						s_current_line_length = length;
-						
-						if (success == false)
-						{
-							report_error(line, "failed to process chibi file: %s", chibi_file);
-							return false;
-						}
-					}
-				}
-				else if (eat_word(linePtr, "push_group"))
+				if (!strcmp(option, "group"))
 				{
-					const char * name;
-					
-					if (!eat_word_v2(linePtr, name))
+					if (!line.eat_word(group))
 					{
 						report_error(line, "missing group name");
 						return false;
 					}
-					
-					group_stack.push_back(name);
-				}
-				else if (eat_word(linePtr, "pop_group"))
-				{
-					if (group_stack.size() == 1)
-					{
-						report_error(line, "no group left to pop");
-						return false;
-					}
-
-					group_stack.pop_back();
-				}
-				else if (eat_word(linePtr, "add_root"))
-				{
-					const char * location;
-					
-					if (!eat_word_v2(linePtr, location))
-					{
-						report_error(line, "missing location");
-						return false;
-					}
-					else
-					{
-						char chibi_file[PATH_MAX];
-						
-						if (!concat(chibi_file, sizeof(chibi_file), chibi_path, "/", location, "/chibi-root.txt"))
-						{
-							report_error(line, "failed to create absolute path");
-							return false;
-						}
-						
-						const int length = s_current_line_length;
-						
-						if (!process_chibi_root_file(chibi_info, chibi_file, group_stack.back(), skip_file_scan))
-							return false;
-						
-						s_current_line_length = length;
-					}
-				}
-				else if (eat_word(linePtr, "library"))
-				{
-					s_currentLibrary = nullptr;
-					
-					const char * name;
-					bool shared = false;
-					bool prebuilt = false;
-					bool objc_arc = false;
-					
-					if (!eat_word_v2(linePtr, name))
-					{
-						report_error(line, "missing name");
-						return false;
-					}
-					
-					for (;;)
-					{
-						const char * option;
-						
-						if (eat_word_v2(linePtr, option) == false)
-							break;
-						
-						if (!strcmp(option, "shared"))
-							shared = true;
-						else if (!strcmp(option, "prebuilt"))
-							prebuilt = true;
-						else if (!strcmp(option, "objc-arc"))
-							objc_arc = true;
-						else
-						{
-							report_error(line, "unknown option: %s", option);
-							return false;
-						}
-					}
-					
-					if (chibi_info.library_exists(name))
-					{
-						report_error(line, "library already exists");
-						return false;
-					}
-					
-					ChibiLibrary * library = new ChibiLibrary();
-					
-					library->name = name;
-					library->path = chibi_path;
-					library->chibi_file = s_currentFile.back();
-					
-					if (group_stack.back().empty() == false)
-						library->group_name = group_stack.back();
-					
-					library->shared = shared;
-					library->prebuilt = prebuilt;
-					library->objc_arc = objc_arc;
-					
-					chibi_info.libraries.push_back(library);
-					
-					s_currentLibrary = library;
 				}
-				else if (eat_word(linePtr, "app"))
+				else if (!strcmp(option, "conglomerate"))
 				{
-					s_currentLibrary = nullptr;
-					
-					const char * name;
-					
-					if (!eat_word_v2(linePtr, name))
-					{
-						report_error(line, "missing name");
-						return false;
-					}
-					
-					if (chibi_info.library_exists(name))
+					if (!line.eat_word(conglomerate))
 					{
-						report_error(line, "app already exists");
+						report_error(line, "missing conglomerate target");
 						return false;
 					}
-					
-					ChibiLibrary * library = new ChibiLibrary();
-					
-					library->name = name;
-					library->path = chibi_path;
-					library->chibi_file = s_currentFile.back();
-					
-					if (group_stack.back().empty() == false)
-						library->group_name = group_stack.back();
-					
-					library->isExecutable = true;
-					
-					chibi_info.libraries.push_back(library);
-					
-					s_currentLibrary = library;
 				}
-				else if (eat_word(linePtr, "cmake_module_path"))
+				else if (!strcmp(option, "auto_conglomerate"))
 				{
-					const char * path;
-					
-					if (!eat_word_v2(linePtr, path))
-					{
-						report_error(line, "cmake_module_path without path");
-						return false;
-					}
-					
-					char full_path[PATH_MAX];
-					if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
-					{
-						report_error(line, "failed to create absolute path");
-						return false;
-					}
-					
-					chibi_info.cmake_module_paths.push_back(full_path);
+					auto_conglomerate = true;
 				}
-				else if (eat_word(linePtr, "add_files"))
+				else if (!strcmp(option, "absolute"))
 				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "add_files without a target");
-						return false;
-					}
-					else
-					{
-						std::vector<ChibiLibraryFile> library_files;
-						
-						const char * group = nullptr;
-						
-						const char * conglomerate =
-							conglomerate_stack.empty()
-							? nullptr
-							: conglomerate_stack.back().c_str();
-						
-						bool absolute = false;
-						
-						bool done = false;
-						
-						// parse file list
-						
-						for (;;)
-						{
-							const char * filename;
-							
-							if (!eat_word_v2(linePtr, filename))
-							{
-								done = true;
-								break;
-							}
-							
-							if (!strcmp(filename, "-"))
-								break;
-							
-							ChibiLibraryFile file;
-							
-							file.filename = filename;
-							
-							library_files.push_back(file);
-						}
-						
-						// parse options
-						
-						if (done == false)
-						{
-							for (;;)
-							{
-								const char * option;
-								
-								if (!eat_word_v2(linePtr, option))
-								{
-									done = true;
-									break;
-								}
-								
-								if (!strcmp(option, "group"))
-								{
-									if (!eat_word_v2(linePtr, group))
-									{
-										report_error(line, "missing group name");
-										return false;
-									}
-								}
-								else if (!strcmp(option, "conglomerate"))
-								{
-									if (!eat_word_v2(linePtr, conglomerate))
-									{
-										report_error(line, "missing conglomerate target");
-										return false;
-									}
-								}
-								else if (!strcmp(option, "absolute"))
-								{
-									absolute = true;
-								}
-								else
-								{
-									report_error(line, "unknown option: %s", option);
-									return false;
-								}
-							}
-						}
-						
-						if (absolute == false)
-						{
-							for (auto & library_file : library_files)
-							{
-								char full_path[PATH_MAX];
-								if (!concat(full_path, sizeof(full_path), chibi_path, "/", library_file.filename.c_str()))
-								{
-									report_error(line, "failed to create absolute path");
-									return false;
-								}
-								
-								library_file.filename = full_path;
-							}
-						}
-						
-						if (group != nullptr)
-						{
-							for (auto & library_file : library_files)
-								library_file.group = group;
-						}
-						
-						if (conglomerate != nullptr)
-						{
-							char full_path[PATH_MAX];
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", conglomerate))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-							
-							for (auto & library_file : library_files)
-							{
-								library_file.conglomerate_filename = full_path;
-								library_file.compile = false;
-							}
-							
-							if (group != nullptr)
-							{
-								s_currentLibrary->conglomerate_groups[full_path] = group;
-							}
-						}
-						
-						s_currentLibrary->files.insert(
-							s_currentLibrary->files.end(),
-							library_files.begin(),
-							library_files.end());
-					}
+					absolute = true;
 				}
-				else if (eat_word(linePtr, "scan_files"))
+				else
 				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "scan_files without a target");
-						return false;
-					}
-					else
-					{
-						const char * extensions;
-						
-						if (!eat_word_v2(linePtr, extensions))
-						{
-							report_error(line, "missing extension");
-							return false;
-						}
-						
-						bool traverse = false;
-						
-						const char * platform = nullptr;
-						
-						const char * path = nullptr;
-						
-						std::vector<std::string> excluded_paths;
-						
-						const char * group = nullptr;
-						
-						const char * conglomerate =
-							conglomerate_stack.empty()
-							? nullptr
-							: conglomerate_stack.back().c_str();
-						
-						for (;;)
-						{
-							const char * option;
-							
-							if (eat_word_v2(linePtr, option) == false)
-								break;
-							
-							if (!strcmp(option, "traverse"))
-								traverse = true;
-							else if (!strcmp(option, "platform"))
-							{
-								if (!eat_word_v2(linePtr, platform))
-									report_error(line, "missing platform name");
-							}
-							else if (!strcmp(option, "path"))
-							{
-								if (!eat_word_v2(linePtr, path))
-									report_error(line, "missing path");
-							}
-							else if (!strcmp(option, "exclude_path"))
-							{
-								const char * excluded_path;
-								
-								if (!eat_word_v2(linePtr, excluded_path))
-								{
-									report_error(line, "exclude_path without a path");
-									return false;
-								}
-								
-								char full_path[PATH_MAX];
-								if (!concat(full_path, sizeof(full_path), chibi_path, "/", excluded_path))
-								{
-									report_error(line, "failed to create absolute path");
-									return false;
-								}
-								
-								excluded_paths.push_back(full_path);
-							}
-							else if (!strcmp(option, "group"))
-							{
-								if (!eat_word_v2(linePtr, group))
-								{
-									report_error(line, "missing group name");
-									return false;
-								}
-							}
-							else if (!strcmp(option, "conglomerate"))
-							{
-								if (!eat_word_v2(linePtr, conglomerate))
-								{
-									report_error(line, "missing conglomerate target");
-									return false;
-								}
-							}
-							else
-							{
-								report_error(line, "unknown option: %s", option);
-								return false;
-							}
-						}
-						
-						if (skip_file_scan)
-							continue;
-						
-						// scan files
-						
-						char search_path[PATH_MAX];
-						
-						if (path == nullptr)
-						{
-							if (!concat(search_path, sizeof(search_path), chibi_path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						else
-						{
-							if (!concat(search_path, sizeof(search_path), chibi_path, "/", path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						
-						auto filenames = listFiles(search_path, traverse);
-						
-						const bool is_wildcard = strchr(extensions, '*') != nullptr;
-						
-						auto end = std::remove_if(filenames.begin(), filenames.end(), [&](const std::string & filename) -> bool
-							{
-								if (is_wildcard)
-								{
-									if (match_wildcard(filename.c_str(), extensions, ';') == false)
-										return true;
-								}
-								else
-								{
-									const auto extension = get_path_extension(filename.c_str(), true);
-									
-									if (match_element(extension.c_str(), extensions, '|') == false)
-										return true;
-								}
-							
-								if (platform != nullptr && platform != s_platform)
-									return true;
-								
-								for (auto & excluded_path : excluded_paths)
-									if (string_starts_with(filename, excluded_path))
-										return true;
-								
-								return false;
-							});
-						
-						filenames.erase(end, filenames.end());
-						
-						std::vector<ChibiLibraryFile> library_files;
-						
-						for (auto & filename : filenames)
-						{
-							ChibiLibraryFile file;
-							
-							file.filename = filename;
-							
-							if (group != nullptr)
-								file.group = group;
-							
-							library_files.push_back(file);
-						}
-						
-						if (conglomerate != nullptr)
-						{
-							char full_path[PATH_MAX];
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", conglomerate))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-							
-							for (auto & library_file : library_files)
-							{
-								library_file.conglomerate_filename = full_path;
-								library_file.compile = false;
-							}
-							
-							if (group != nullptr)
-							{
-								s_currentLibrary->conglomerate_groups[full_path] = group;
-							}
-						}
-						
-						s_currentLibrary->files.insert(
-							s_currentLibrary->files.end(),
-							library_files.begin(),
-							library_files.end());
-					}
+					report_error(line, "unknown option: %s", option);
+					return false;
 				}
-				else if (eat_word(linePtr, "exclude_files"))
+			}
+		}
+		
+		if (absolute == false)
+		{
+			for (auto & library_file : library_files)
+			{
+				char full_path[PATH_MAX];
+				if (!concat(full_path, sizeof(full_path), chibi_path, "/", library_file.filename.c_str()))
 				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "exclude_files without a target");
-						return false;
-					}
-					else
-					{
-						for (;;)
-						{
-							const char * filename;
-							
-							if (!eat_word_v2(linePtr, filename))
-								break;
-							
-							char full_path[PATH_MAX];
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", filename))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-							
-							for (auto fileItr = s_currentLibrary->files.begin(); fileItr != s_currentLibrary->files.end(); )
-							{
-								auto & file = *fileItr;
-								
-								if (file.filename == full_path)
-									fileItr = s_currentLibrary->files.erase(fileItr);
-								else
-									fileItr++;
-							}
-						}
-					}
+					report_error(line, "failed to create absolute path");
+					return false;
 				}
-				else if (eat_word(linePtr, "depend_package"))
-				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "depend_package without a target");
-						return false;
-					}
-					else
-					{
-						const char * name;
-						ChibiPackageDependency::Type type = ChibiPackageDependency::kType_FindPackage;
-						
-						if (!eat_word_v2(linePtr, name))
-						{
-							report_error(line, "missing name");
-							return false;
-						}
-						
-						for (;;)
-						{
-							const char * option;
-							
-							if (!eat_word_v2(linePtr, option))
-								break;
-							
-						#if ENABLE_PKGCONFIG
-							if (!strcmp(option, "pkgconfig"))
-								type = ChibiPackageDependency::kType_PkgConfig;
-							else
-						#endif
-							{
-								report_error(line, "unknown option: %s", option);
-								return false;
-							}
-						}
-						
-						ChibiPackageDependency package_dependency;
-						package_dependency.name = name;
-						package_dependency.variable_name = name;
-						package_dependency.type = type;
-						
-						std::replace(package_dependency.variable_name.begin(), package_dependency.variable_name.end(), '-', '_');
-						std::replace(package_dependency.variable_name.begin(), package_dependency.variable_name.end(), '.', '_');
-						
-						s_currentLibrary->package_dependencies.push_back(package_dependency);
-					}
-				}
-				else if (eat_word(linePtr, "depend_library"))
-				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "depend_library without a target");
-						return false;
-					}
-					else
-					{
-						const char * name;
-						
-						ChibiLibraryDependency::Type type = ChibiLibraryDependency::kType_Generated;
-						
-						bool embed_framework = false;
-						
-						if (!eat_word_v2(linePtr, name))
-						{
-							report_error(line, "missing name");
-							return false;
-						}
-						
-						for (;;)
-						{
-							const char * option;
-							
-							if (!eat_word_v2(linePtr, option))
-								break;
-							
-							if (!strcmp(option, "local"))
-								type = ChibiLibraryDependency::kType_Local;
-							else if (!strcmp(option, "find"))
-								type = ChibiLibraryDependency::kType_Find;
-							else if (!strcmp(option, "global"))
-								type = ChibiLibraryDependency::kType_Global;
-							else if (!strcmp(option, "embed_framework"))
-								embed_framework = true;
-							else
-							{
-								report_error(line, "unknown option: %s", option);
-								return false;
-							}
-						}
-						
-						char full_path[PATH_MAX];
-						full_path[0] = 0;
-						
-						if (type == ChibiLibraryDependency::kType_Local)
-						{
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", name))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						
-						ChibiLibraryDependency library_dependency;
-						
-						library_dependency.name = name;
-						library_dependency.path = full_path;
-						library_dependency.type = type;
-						library_dependency.embed_framework = embed_framework;
-						
-						s_currentLibrary->library_dependencies.push_back(library_dependency);
-					}
-				}
-				else if (eat_word(linePtr, "header_path"))
-				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "header_path without a target");
-						return false;
-					}
-					else
-					{
-						const char * path;
-						
-						if (!eat_word_v2(linePtr, path))
-						{
-							report_error(line, "missing path");
-							return false;
-						}
-						
-						bool expose = false;
-						
-						const char * platform = nullptr;
-						
-						const char * alias_through_copy = nullptr;
-						
-						bool absolute = false;
-						
-						for (;;)
-						{
-							const char * option;
-							
-							if (!eat_word_v2(linePtr, option))
-								break;
-							
-							if (!strcmp(option, "expose"))
-								expose = true;
-							else if (!strcmp(option, "platform"))
-							{
-								if (!eat_word_v2(linePtr, platform))
-								{
-									report_error(line, "missing platform name");
-									return false;
-								}
-							}
-							else if (!strcmp(option, "alias_through_copy"))
-							{
-								if (!eat_word_v2(linePtr, alias_through_copy))
-								{
-									report_error(line, "missing alias location");
-									return false;
-								}
-							}
-							else if (!strcmp(option, "absolute"))
-							{
-								absolute = true;
-							}
-							else
-							{
-								report_error(line, "unknown option: %s", option);
-								return false;
-							}
-						}
-						
-						if (platform != nullptr && platform != s_platform)
-							continue;
-						
-						char full_path[PATH_MAX];
-						
-						if (absolute)
-						{
-							if (!concat(full_path, sizeof(full_path), path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						else if (strcmp(path, ".") == 0)
-						{
-							// the target just wants to include its own base path. use a more simplified full path
-							
-							if (!concat(full_path, sizeof(full_path), chibi_path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						else
-						{
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						
-						ChibiHeaderPath header_path;
-						header_path.path = full_path;
-						header_path.expose = expose;
-						if (alias_through_copy != nullptr)
-							header_path.alias_through_copy = alias_through_copy;
-						
-						s_currentLibrary->header_paths.push_back(header_path);
-					}
-				}
-				else if (eat_word(linePtr, "compile_definition"))
-				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "compile_definition without a target");
-						return false;
-					}
-					else
-					{
-						const char * name;
-						const char * value;
-						std::vector<std::string> configs;
-						
-						if (!eat_word_v2(linePtr, name))
-						{
-							report_error(line, "missing name");
-							return false;
-						}
-						
-						if (!eat_word_v2(linePtr, value))
-						{
-							report_error(line, "missing value");
-							return false;
-						}
-						
-						if (!strcmp(value, "*"))
-							value = "";
-						
-						bool expose = false;
-						
-						const char * toolchain = "";
-						
-						for (;;)
-						{
-							const char * option;
-							
-							if (!eat_word_v2(linePtr, option))
-								break;
-							
-							if (!strcmp(option, "expose"))
-								expose = true;
-							else if (!strcmp(option, "toolchain"))
-							{
-								if (!eat_word_v2(linePtr, toolchain))
-								{
-									report_error(line, "missing name");
-									return false;
-								}
-							}
-							else if (!strcmp(option, "config"))
-							{
-								const char * config;
-								
-								if (!eat_word_v2(linePtr, config))
-								{
-									report_error(line, "missing config name");
-									return false;
-								}
-								
-								configs.push_back(config);
-							}
-							else
-							{
-								report_error(line, "unknown option: %s", option);
-								return false;
-							}
-						}
-						
-						ChibiCompileDefinition compile_definition;
-						
-						compile_definition.name = name;
-						compile_definition.value = value;
-						compile_definition.expose = expose;
-						compile_definition.toolchain = toolchain;
-						compile_definition.configs = configs;
-						
-						s_currentLibrary->compile_definitions.push_back(compile_definition);
-					}
-				}
-				else if (eat_word(linePtr, "resource_path"))
-				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "resource_path without a target");
-						return false;
-					}
-					else
-					{
-						const char * path;
-						std::vector<std::string> excludes;
-						
-						if (!eat_word_v2(linePtr, path))
-						{
-							report_error(line, "missing path");
-							return false;
-						}
-						
-						char full_path[PATH_MAX];
-
-						if (is_absolute_path(path))
-						{
-							if (!copy_string(full_path, sizeof(full_path), path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						else
-						{
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-
-						for (;;)
-						{
-							const char * option;
-							
-							if (!eat_word_v2(linePtr, option))
-								break;
-							
-							if (!strcmp(option, "exclude"))
-							{
-								const char * exclude;
-
-								if (!eat_word_v2(linePtr, exclude))
-								{
-									report_error(line, "missing exclude filename or pattern");
-									return false;
-								}
-
-								excludes.push_back(exclude);
-							}
-							else
-							{
-								report_error(line, "unknown option: %s", option);
-								return false;
-							}
-						}
-						
-						s_currentLibrary->resource_path = full_path;
-						s_currentLibrary->resource_excludes = excludes;
-					}
-				}
-				else if (eat_word(linePtr, "license_file"))
-				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "license_file without a target");
-						return false;
-					}
-					else if (s_currentLibrary->isExecutable)
-					{
-						report_error(line, "license_file target is not a library");
-						return false;
-					}
-					else
-					{
-						const char * path;
-						
-						if (!eat_word_v2(linePtr, path))
-						{
-							report_error(line, "missing path");
-							return false;
-						}
-						
-						char full_path[PATH_MAX];
-
-						if (is_absolute_path(path))
-						{
-							if (!copy_string(full_path, sizeof(full_path), path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-						else
-						{
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-						}
-
-						if (file_exist(full_path) == false)
-						{
-							report_error(line, "failed to find license file: %s", path);
-							return false;
-						}
-
-						s_currentLibrary->license_files.push_back(path);
-					}
-				}
-				else if (eat_word(linePtr, "group"))
+				
+				library_file.filename = full_path;
+			}
+		}
+		
+		if (group != nullptr)
+		{
+			const InternedString interned_group(group);
+			
+			for (auto & library_file : library_files)
+				library_file.group = interned_group;
+		}
+		
+		if (auto_conglomerate)
+		{
+			// note : automatic conglomerates take precedence over the conglomerate set using push_conglomerate
+			
+			conglomerate = nullptr;
+			
+			for (auto & library_file : library_files)
+				library_file.auto_conglomerate = true;
+		}
+		
+		if (conglomerate != nullptr)
+		{
+			char full_path[PATH_MAX];
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", conglomerate))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+			
+			const InternedString conglomerate_filename(full_path);
+			
+			for (auto & library_file : library_files)
+			{
+				library_file.conglomerate_filename = conglomerate_filename;
+				library_file.compile = false;
+			}
+			
+			if (group != nullptr)
+			{
+				current_library->conglomerate_groups[full_path] = group;
+			}
+		}
+		
+		current_library->files.insert(
+			current_library->files.end(),
+			std::make_move_iterator(library_files.begin()),
+			std::make_move_iterator(library_files.end()));
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_scan_files(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "scan_files without a target");
+		return false;
+	}
+	else
+	{
+		const char * extensions;
+		
+		if (!line.eat_word(extensions))
+		{
+			report_error(line, "missing extension");
+			return false;
+		}
+		
+		bool traverse = false;
+		
+		const char * platform = nullptr;
+		
+		const char * path = nullptr;
+		
+		std::vector<std::string> excluded_paths;
+		
+		const char * group = nullptr;
+		
+		ChibiScanSource source = scan_source;
+		
+		bool auto_conglomerate = false;
+		
+		const char * conglomerate =
+			conglomerate_stack.empty()
+			? nullptr
+			: conglomerate_stack.back().c_str();
+		
+		for (;;)
+		{
+			const char * option;
+			
+			if (line.eat_word(option) == false)
+				break;
+			
+			if (!strcmp(option, "traverse"))
+				traverse = true;
+			else if (!strcmp(option, "platform"))
+			{
+				if (!line.eat_word(platform))
+					report_error(line, "missing platform name");
+			}
+			else if (!strcmp(option, "path"))
+			{
+				if (!line.eat_word(path))
+					report_error(line, "missing path");
+			}
+			else if (!strcmp(option, "exclude_path"))
+			{
+				const char * excluded_path;
+				
+				if (!line.eat_word(excluded_path))
 				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "group without a target");
-						return false;
-					}
-					else
-					{
-						const char * name;
-						
-						if (!eat_word_v2(linePtr, name))
-						{
-							report_error(line, "missing group name");
-							return false;
-						}
-						
-						s_currentLibrary->group_name = name;
-					}
+					report_error(line, "exclude_path without a path");
+					return false;
 				}
-				else if (eat_word(linePtr, "add_dist_files"))
+				
+				char full_path[PATH_MAX];
+				if (!concat(full_path, sizeof(full_path), chibi_path, "/", excluded_path))
 				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "add_dist_files without a target");
-						return false;
-					}
-					else
-					{
-						for (;;)
-						{
-							const char * file;
-
-							if (!eat_word_v2(linePtr, file))
-								break;
-
-							char full_path[PATH_MAX];
-							if (!concat(full_path, sizeof(full_path), chibi_path, "/", file))
-							{
-								report_error(line, "failed to create absolute path");
-								return false;
-							}
-
-							s_currentLibrary->dist_files.push_back(full_path);
-						}
-					}
+					report_error(line, "failed to create absolute path");
+					return false;
 				}
-				else if (eat_word(linePtr, "push_conglomerate"))
+				
+				excluded_paths.push_back(full_path);
+			}
+			else if (!strcmp(option, "group"))
+			{
+				if (!line.eat_word(group))
 				{
-					const char * file;
-					
-					if (!eat_word_v2(linePtr, file))
-					{
-						report_error(line, "missing conglomerate file");
-						return false;
-					}
-					
-					conglomerate_stack.push_back(file);
+					report_error(line, "missing group name");
+					return false;
 				}
-				else if (eat_word(linePtr, "pop_conglomerate"))
+			}
+			else if (!strcmp(option, "conglomerate"))
+			{
+				if (!line.eat_word(conglomerate))
 				{
-					if (conglomerate_stack.empty())
-					{
-						report_error(line, "no conglomerate file left to pop");
-						return false;
-					}
-
-					conglomerate_stack.pop_back();
+					report_error(line, "missing conglomerate target");
+					return false;
 				}
-				else if (eat_word(linePtr, "link_translation_unit_using_function_call"))
+			}
+			else if (!strcmp(option, "auto_conglomerate"))
+			{
+				auto_conglomerate = true;
+			}
+			else if (!strcmp(option, "source"))
+			{
+				const char * name;
+				
+				if (!line.eat_word(name))
 				{
-					if (s_currentLibrary == nullptr)
-					{
-						report_error(line, "link_translation_unit_using_function_call without a target");
-						return false;
-					}
-					else
-					{
-						const char * function_name;
-							
-						if (!eat_word_v2(linePtr, function_name))
-						{
-							report_error(line, "missing function name");
-							return false;
-						}
-
-						s_currentLibrary->link_translation_unit_using_function_calls.push_back(function_name);
-					}
+					report_error(line, "missing scan source");
+					return false;
 				}
+				
+				if (!strcmp(name, "git"))
+					source = kScanSource_Git;
+				else if (!strcmp(name, "filesystem"))
+					source = kScanSource_Filesystem;
 				else
 				{
-					report_error(line, "syntax error");
+					report_error(line, "unknown scan source: %s", name);
 					return false;
 				}
+			}
+			else
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
+			}
+		}
+		
+		// note : the scan itself is deferred until we know which libraries are part of the build. see run_file_scans
+		
+		char search_path[PATH_MAX];
+		
+		if (path == nullptr)
+		{
+			if (!concat(search_path, sizeof(search_path), chibi_path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		else
+		{
+			if (!concat(search_path, sizeof(search_path), chibi_path, "/", path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		
+		ChibiFileScan file_scan;
+		
+		file_scan.path = search_path;
+		file_scan.extensions = extensions;
+		file_scan.traverse = traverse;
+		file_scan.source = source;
+		file_scan.excluded_paths = std::move(excluded_paths);
+		
+		if (group != nullptr)
+			file_scan.group = group;
+		
+		if (auto_conglomerate)
+		{
+			conglomerate = nullptr;
+			
+			file_scan.auto_conglomerate = true;
+		}
+		
+		if (conglomerate != nullptr)
+		{
+			char full_path[PATH_MAX];
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", conglomerate))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+			
+			file_scan.conglomerate_filename = full_path;
+			
+			if (group != nullptr)
+			{
+				current_library->conglomerate_groups[full_path] = group;
+			}
+		}
+		
+		file_scan.file_index = current_library->files.size();
+		
+		if (platform == nullptr || platform == context.platform)
+			current_library->file_scans.push_back(file_scan);
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_exclude_files(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "exclude_files without a target");
+		return false;
+	}
+	else
+	{
+		for (;;)
+		{
+			const char * filename;
+			
+			if (!line.eat_word(filename))
+				break;
+			
+			char full_path[PATH_MAX];
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", filename))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+			
+			for (auto fileItr = current_library->files.begin(); fileItr != current_library->files.end(); )
+			{
+				auto & file = *fileItr;
 				
-				// check we processed the entire line
-				
-				for (int i = 0; linePtr[i] != 0; ++i)
+				if (file.filename == full_path)
 				{
-					if (linePtr[i] != 0)
-					{
-						report_error(line, "unexpected text at end of line: %s", linePtr + i);
-						return false;
-					}
+					// keep the locations where pending scans insert their files in sync
+					
+					const size_t file_index = fileItr - current_library->files.begin();
+					
+					for (auto & file_scan : current_library->file_scans)
+						if (file_scan.file_index > file_index)
+							file_scan.file_index--;
+					
+					fileItr = current_library->files.erase(fileItr);
 				}
+				else
+					fileItr++;
+			}
+			
+			// the file may also be found by one of the pending scans
+			
+			for (auto & file_scan : current_library->file_scans)
+				file_scan.excluded_files.push_back(full_path);
+		}
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_depend_package(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "depend_package without a target");
+		return false;
+	}
+	else
+	{
+		const char * name;
+		ChibiPackageDependency::Type type = ChibiPackageDependency::kType_FindPackage;
+		
+		if (!line.eat_word(name))
+		{
+			report_error(line, "missing name");
+			return false;
+		}
+		
+		for (;;)
+		{
+			const char * option;
+			
+			if (!line.eat_word(option))
+				break;
+			
+		#if ENABLE_PKGCONFIG
+			if (!strcmp(option, "pkgconfig"))
+				type = ChibiPackageDependency::kType_PkgConfig;
+			else
+		#endif
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
 			}
 		}
 		
-		free(line);
-		line = nullptr;
-		lineSize = 0;
+		ChibiPackageDependency package_dependency;
+		package_dependency.name = name;
+		package_dependency.variable_name = name;
+		package_dependency.type = type;
+		
+		std::replace(package_dependency.variable_name.begin(), package_dependency.variable_name.end(), '-', '_');
+		std::replace(package_dependency.variable_name.begin(), package_dependency.variable_name.end(), '.', '_');
+		
+		current_library->package_dependencies.push_back(package_dependency);
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_depend_library(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "depend_library without a target");
+		return false;
+	}
+	else
+	{
+		const char * name;
+		
+		ChibiLibraryDependency::Type type = ChibiLibraryDependency::kType_Generated;
+		
+		bool embed_framework = false;
+		
+		if (!line.eat_word(name))
+		{
+			report_error(line, "missing name");
+			return false;
+		}
+		
+		for (;;)
+		{
+			const char * option;
+			
+			if (!line.eat_word(option))
+				break;
+			
+			if (!strcmp(option, "local"))
+				type = ChibiLibraryDependency::kType_Local;
+			else if (!strcmp(option, "find"))
+				type = ChibiLibraryDependency::kType_Find;
+			else if (!strcmp(option, "global"))
+				type = ChibiLibraryDependency::kType_Global;
+			else if (!strcmp(option, "embed_framework"))
+				embed_framework = true;
+			else
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
+			}
+		}
+		
+		char full_path[PATH_MAX];
+		full_path[0] = 0;
+		
+		if (type == ChibiLibraryDependency::kType_Local)
+		{
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", name))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		
+		ChibiLibraryDependency library_dependency;
+		
+		library_dependency.name = name;
+		library_dependency.path = full_path;
+		library_dependency.type = type;
+		library_dependency.embed_framework = embed_framework;
+		
+		current_library->library_dependencies.push_back(library_dependency);
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_header_path(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "header_path without a target");
+		return false;
+	}
+	else
+	{
+		const char * path;
+		
+		if (!line.eat_word(path))
+		{
+			report_error(line, "missing path");
+			return false;
+		}
+		
+		bool expose = false;
+		
+		const char * platform = nullptr;
+		
+		const char * alias_through_copy = nullptr;
+		
+		bool absolute = false;
+		
+		for (;;)
+		{
+			const char * option;
+			
+			if (!line.eat_word(option))
+				break;
+			
+			if (!strcmp(option, "expose"))
+				expose = true;
+			else if (!strcmp(option, "platform"))
+			{
+				if (!line.eat_word(platform))
+				{
+					report_error(line, "missing platform name");
+					return false;
+				}
+			}
+			else if (!strcmp(option, "alias_through_copy"))
+			{
+				if (!line.eat_word(alias_through_copy))
+				{
+					report_error(line, "missing alias location");
+					return false;
+				}
+			}
+			else if (!strcmp(option, "absolute"))
+			{
+				absolute = true;
+			}
+			else
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
+			}
+		}
+		
+		if (platform != nullptr && platform != context.platform)
+			return true;
+		
+		char full_path[PATH_MAX];
+		
+		if (absolute)
+		{
+			if (!concat(full_path, sizeof(full_path), path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		else if (strcmp(path, ".") == 0)
+		{
+			// the target just wants to include its own base path. use a more simplified full path
+			
+			if (!concat(full_path, sizeof(full_path), chibi_path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		else
+		{
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		
+		ChibiHeaderPath header_path;
+		header_path.path = full_path;
+		header_path.expose = expose;
+		if (alias_through_copy != nullptr)
+			header_path.alias_through_copy = alias_through_copy;
+		
+		current_library->header_paths.push_back(header_path);
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_compile_definition(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "compile_definition without a target");
+		return false;
+	}
+	else
+	{
+		const char * name;
+		const char * value;
+		std::vector<std::string> configs;
+		
+		if (!line.eat_word(name))
+		{
+			report_error(line, "missing name");
+			return false;
+		}
+		
+		if (!line.eat_word(value))
+		{
+			report_error(line, "missing value");
+			return false;
+		}
+		
+		if (!strcmp(value, "*"))
+			value = "";
+		
+		bool expose = false;
+		
+		const char * toolchain = "";
+		
+		for (;;)
+		{
+			const char * option;
+			
+			if (!line.eat_word(option))
+				break;
+			
+			if (!strcmp(option, "expose"))
+				expose = true;
+			else if (!strcmp(option, "toolchain"))
+			{
+				if (!line.eat_word(toolchain))
+				{
+					report_error(line, "missing name");
+					return false;
+				}
+			}
+			else if (!strcmp(option, "config"))
+			{
+				const char * config;
+				
+				if (!line.eat_word(config))
+				{
+					report_error(line, "missing config name");
+					return false;
+				}
+				
+				configs.push_back(config);
+			}
+			else
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
+			}
+		}
+		
+		ChibiCompileDefinition compile_definition;
+		
+		compile_definition.name = name;
+		compile_definition.value = value;
+		compile_definition.expose = expose;
+		compile_definition.toolchain = toolchain;
+		compile_definition.configs = configs;
+		
+		current_library->compile_definitions.push_back(compile_definition);
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_resource_path(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "resource_path without a target");
+		return false;
+	}
+	else
+	{
+		const char * path;
+		std::vector<std::string> excludes;
+		
+		if (!line.eat_word(path))
+		{
+			report_error(line, "missing path");
+			return false;
+		}
+		
+		char full_path[PATH_MAX];
+
+		if (is_absolute_path(path))
+		{
+			if (!copy_string(full_path, sizeof(full_path), path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		else
+		{
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+
+		for (;;)
+		{
+			const char * option;
+			
+			if (!line.eat_word(option))
+				break;
+			
+			if (!strcmp(option, "exclude"))
+			{
+				const char * exclude;
+
+				if (!line.eat_word(exclude))
+				{
+					report_error(line, "missing exclude filename or pattern");
+					return false;
+				}
+
+				excludes.push_back(exclude);
+			}
+			else
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
+			}
+		}
+		
+		current_library->resource_path = full_path;
+		current_library->resource_excludes = excludes;
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_license_file(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "license_file without a target");
+		return false;
+	}
+	else if (current_library->isExecutable)
+	{
+		report_error(line, "license_file target is not a library");
+		return false;
+	}
+	else
+	{
+		const char * path;
+		
+		if (!line.eat_word(path))
+		{
+			report_error(line, "missing path");
+			return false;
+		}
+		
+		char full_path[PATH_MAX];
+
+		if (is_absolute_path(path))
+		{
+			if (!copy_string(full_path, sizeof(full_path), path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		else
+		{
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+
+		if (file_exist(full_path) == false)
+		{
+			report_error(line, "failed to find license file: %s", path);
+			return false;
+		}
+		
+		if (context.use_parse_cache)
+			result.add_dependency(full_path);
+
+		current_library->license_files.push_back(path);
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_group(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "group without a target");
+		return false;
+	}
+	else
+	{
+		const char * name;
+		
+		if (!line.eat_word(name))
+		{
+			report_error(line, "missing group name");
+			return false;
+		}
+		
+		current_library->group_name = name;
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_add_dist_files(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "add_dist_files without a target");
+		return false;
+	}
+	else
+	{
+		for (;;)
+		{
+			const char * file;
+
+			if (!line.eat_word(file))
+				break;
+
+			char full_path[PATH_MAX];
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", file))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+
+			current_library->dist_files.push_back(full_path);
+		}
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_push_conglomerate(ChibiLine & line)
+{
+	const char * file;
+	
+	if (!line.eat_word(file))
+	{
+		report_error(line, "missing conglomerate file");
+		return false;
+	}
+	
+	conglomerate_stack.push_back(file);
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_pop_conglomerate(ChibiLine & line)
+{
+	if (conglomerate_stack.empty())
+	{
+		report_error(line, "no conglomerate file left to pop");
+		return false;
+	}
+
+	conglomerate_stack.pop_back();
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_auto_conglomerate(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "auto_conglomerate without a target");
+		return false;
+	}
+	else
+	{
+		current_library->auto_conglomerate = true;
+		
+		for (;;)
+		{
+			const char * option;
+			
+			if (!line.eat_word(option))
+				break;
+			
+			if (!strcmp(option, "size"))
+			{
+				const char * size_text;
+				int size;
+				
+				if (!line.eat_word(size_text) || sscanf_s(size_text, "%d", &size) != 1 || size <= 0 || size > 1024 * 1024)
+				{
+					report_error(line, "missing or invalid conglomerate size");
+					return false;
+				}
+				
+				current_library->auto_conglomerate_size = size * 1024;
+			}
+			else
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
+			}
+		}
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_link_translation_unit_using_function_call(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "link_translation_unit_using_function_call without a target");
+		return false;
+	}
+	else
+	{
+		const char * function_name;
+			
+		if (!line.eat_word(function_name))
+		{
+			report_error(line, "missing function name");
+			return false;
+		}
+
+		current_library->link_translation_unit_using_function_calls.push_back(function_name);
+	}
+	
+	return true;
+}
+
+bool ChibiFileParser::handle_precompiled_header(ChibiLine & line)
+{
+	if (current_library == nullptr)
+	{
+		report_error(line, "precompiled_header without a target");
+		return false;
+	}
+	else if (current_library->precompiled_header.empty() == false)
+	{
+		report_error(line, "precompiled_header is already set for this target");
+		return false;
+	}
+	else
+	{
+		const char * path;
+		
+		if (!line.eat_word(path))
+		{
+			report_error(line, "missing path");
+			return false;
+		}
+		
+		bool expose = false;
+		
+		for (;;)
+		{
+			const char * option;
+			
+			if (!line.eat_word(option))
+				break;
+			
+			if (!strcmp(option, "expose"))
+				expose = true;
+			else
+			{
+				report_error(line, "unknown option: %s", option);
+				return false;
+			}
+		}
+		
+		char full_path[PATH_MAX];
+		
+		if (is_absolute_path(path))
+		{
+			if (!copy_string(full_path, sizeof(full_path), path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		else
+		{
+			if (!concat(full_path, sizeof(full_path), chibi_path, "/", path))
+			{
+				report_error(line, "failed to create absolute path");
+				return false;
+			}
+		}
+		
+		if (file_exist(full_path) == false)
+		{
+			report_error(line, "failed to find precompiled header: %s", path);
+			return false;
+		}
+		
+		if (context.use_parse_cache)
+			result.add_dependency(full_path);
+		
+		current_library->precompiled_header = full_path;
+		current_library->precompiled_header_expose = expose;
+	}
+	
+	return true;
+}
+
+struct ChibiKeyword
+{
+	const char * name;
+	
+	bool (ChibiFileParser::*handler)(ChibiLine & line);
+};
+
+static const ChibiKeyword s_keywords[] =
+{
+	{ "add", &ChibiFileParser::handle_add },
+	{ "push_group", &ChibiFileParser::handle_push_group },
+	{ "pop_group", &ChibiFileParser::handle_pop_group },
+	{ "add_root", &ChibiFileParser::handle_add_root },
+	{ "scan_source", &ChibiFileParser::handle_scan_source },
+	{ "library", &ChibiFileParser::handle_library },
+	{ "app", &ChibiFileParser::handle_app },
+	{ "cmake_module_path", &ChibiFileParser::handle_cmake_module_path },
+	{ "add_files", &ChibiFileParser::handle_add_files },
+	{ "scan_files", &ChibiFileParser::handle_scan_files },
+	{ "exclude_files", &ChibiFileParser::handle_exclude_files },
+	{ "depend_package", &ChibiFileParser::handle_depend_package },
+	{ "depend_library", &ChibiFileParser::handle_depend_library },
+	{ "header_path", &ChibiFileParser::handle_header_path },
+	{ "compile_definition", &ChibiFileParser::handle_compile_definition },
+	{ "resource_path", &ChibiFileParser::handle_resource_path },
+	{ "license_file", &ChibiFileParser::handle_license_file },
+	{ "group", &ChibiFileParser::handle_group },
+	{ "add_dist_files", &ChibiFileParser::handle_add_dist_files },
+	{ "push_conglomerate", &ChibiFileParser::handle_push_conglomerate },
+	{ "pop_conglomerate", &ChibiFileParser::handle_pop_conglomerate },
+	{ "auto_conglomerate", &ChibiFileParser::handle_auto_conglomerate },
+	{ "link_translation_unit_using_function_call", &ChibiFileParser::handle_link_translation_unit_using_function_call },
+	{ "precompiled_header", &ChibiFileParser::handle_precompiled_header },
+};
+
+struct ChibiKeywordTable
+{
+	// an open addressing hash table with the keyword handlers. the table is a power of two in size and is
+	// kept sparse, so finding the handler for a line typically involves just a single string comparison
+	
+	static const int kTableSize = 128;
+	
+	const ChibiKeyword * table[kTableSize];
+	
+	static uint32_t hash(const char * text, const int length)
+	{
+		// FNV-1a
+		
+		uint32_t result = 2166136261u;
+		
+		for (int i = 0; i < length; ++i)
+		{
+			result ^= (uint8_t)text[i];
+			result *= 16777619u;
+		}
+		
+		return result;
+	}
+	
+	ChibiKeywordTable()
+	{
+		for (auto & elem : table)
+			elem = nullptr;
+		
+		for (auto & keyword : s_keywords)
+		{
+			uint32_t index = hash(keyword.name, (int)strlen(keyword.name)) & (kTableSize - 1);
+			
+			while (table[index] != nullptr)
+				index = (index + 1) & (kTableSize - 1);
+			
+			table[index] = &keyword;
+		}
+	}
+	
+	const ChibiKeyword * find(const ChibiToken & token) const
+	{
+		uint32_t index = hash(token.text, token.length) & (kTableSize - 1);
+		
+		while (table[index] != nullptr)
+		{
+			const ChibiKeyword * keyword = table[index];
+			
+			if (token.equals(keyword->name))
+				return keyword;
+			
+			index = (index + 1) & (kTableSize - 1);
+		}
+		
+		return nullptr;
+	}
+};
+
+static const ChibiKeyword * find_keyword(const ChibiToken & token)
+{
+	static const ChibiKeywordTable keyword_table;
+	
+	return keyword_table.find(token);
+}
+
+bool ChibiFileParser::parse()
+{
+	const char * filename = result.filename.c_str();
+	
+	group_stack.push_back(result.group);
+	
+	scan_source = result.scan_source;
+	
+	if (!get_path_from_filename(filename, chibi_path, PATH_MAX))
+	{
+		report_error(nullptr, "failed to get path from chibi filename: %s", filename);
+		return false;
+	}
+	
+	// read the entire file in one go. the tokenizer produces tokens pointing directly into this buffer
+	
+	std::vector<char> text;
+	
+	if (context.use_parse_cache)
+	{
+		// note : we get the modification time before reading the file. if the file changes while we read it, the
+		//        cache entry will be invalidated next time around
+		
+		int64_t size;
+		
+		if (!get_file_info(filename, result.mtime, size))
+			result.mtime = -1;
+	}
+	
+	if (!read_text_file(filename, text))
+	{
+		report_error(nullptr, "failed to open %s", filename);
+		return false;
+	}
+	
+	if (context.use_parse_cache)
+	{
+		result.size = int64_t(text.size() - 1);
+		result.content_hash = compute_content_hash(text.data(), text.size() - 1);
+	}
+	
+	char * text_ptr = text.data();
+	char * text_end = text.data() + text.size() - 1;
+	
+	ChibiLine line;
+	
+	while (next_line(text_ptr, text_end, line))
+	{
+		ChibiToken token;
+		
+		if (!line.next_token(token) || token.text[0] == '#')
+			continue;
+		
+		// lines may be prefixed by one or more platform filters
+		
+		bool skip_line = false;
+		
+		for (;;)
+		{
+			bool (ChibiParseContext::*filter)(const char * name) const = nullptr;
+			
+			if (token.equals("with_platform"))
+				filter = &ChibiParseContext::is_platform;
+			else if (token.equals("with_platform_full"))
+				filter = &ChibiParseContext::is_platform_full;
+			else
+				break;
+			
+			const char * platform;
+			
+			if (!line.eat_word(platform))
+			{
+				report_error(line, "%s without platform", token.text);
+				return false;
+			}
+			
+			if ((context.*filter)(platform) == false)
+			{
+				skip_line = true;
+				break;
+			}
+			
+			if (!line.next_token(token))
+			{
+				report_error(line, "syntax error");
+				return false;
+			}
+		}
+		
+		if (skip_line)
+			continue;
+		
+		// find and invoke the handler for this line's keyword
+		
+		const ChibiKeyword * keyword = find_keyword(token);
+		
+		if (keyword == nullptr)
+		{
+			report_error(line, "syntax error");
+			return false;
+		}
+		
+		if (!(this->*keyword->handler)(line))
+			return false;
 		
-		f.close();
+		// check we processed the entire line
 		
-		if (group_stack.size() > 1)
+		if (line.next_token(token))
 		{
-			char temp[512];
-			temp[0] = 0;
-			for (size_t i = 1; i < group_stack.size(); ++i)
-				concat(temp, sizeof(temp), group_stack[i].c_str(), " ");
-			report_error(nullptr, "missing one or more 'pop_group'. groups still active: %s", temp);
+			report_error(line, "unexpected text at end of line: %s", token.text);
 			return false;
 		}
+	}
+	
+	if (group_stack.size() > 1)
+	{
+		char temp[512];
+		temp[0] = 0;
+		for (size_t i = 1; i < group_stack.size(); ++i)
+			concat(temp, sizeof(temp), group_stack[i].c_str(), " ");
+		report_error(nullptr, "missing one or more 'pop_group'. groups still active: %s", temp);
+		return false;
+	}
+	
+	return true;
+}
+
+static void gather_chibi_files(const ChibiFileResult & result, std::vector<std::string> & filenames)
+{
+	filenames.push_back(result.filename);
+	
+	for (auto & chibi_file : result.chibi_files)
+		gather_chibi_files(*chibi_file, filenames);
+}
+
+static void update_parse_cache(ChibiParseContext & context, const ChibiFileResult & result)
+{
+	const std::string key = context.get_parse_cache_key(result.filename.c_str(), result.group, result.scan_source);
+	
+	ParseCacheEntry & entry = context.new_parse_cache.entries[key];
+	
+	set_parse_cache_entry_mtime(entry, result.mtime, context.start_time);
+	entry.size = result.size;
+	entry.content_hash = result.content_hash;
+	entry.dependencies = result.dependencies;
+	
+	if (result.cache_entry != nullptr)
+	{
+		entry.data = result.cache_entry->data;
 		
-		return true;
+		if (entry.mtime != result.cache_entry->mtime)
+			context.parse_cache_changed = true;
+		
+		context.num_cached_chibi_files++;
+	}
+	else
+	{
+		BinaryWriter writer;
+		write_chibi_file_result(writer, result);
+		entry.data = std::move(writer.data);
+		
+		context.parse_cache_changed = true;
+	}
+	
+	context.num_chibi_files++;
+	
+	for (auto & chibi_file : result.chibi_files)
+		update_parse_cache(context, *chibi_file);
+}
+
+static bool merge_chibi_file_result(ChibiInfo & chibi_info, ChibiFileResult & result)
+{
+	if (result.success == false)
+		return false;
+	
+	for (auto & entry : result.entries)
+	{
+		if (entry.type == ChibiFileResult::kEntryType_Library)
+		{
+			ChibiLibrary *& library = result.libraries[entry.index];
+			
+			if (chibi_info.add_library(library) == false)
+			{
+				report_error_in_file(result.filename.c_str(), "%s already exists: %s",
+					library->isExecutable ? "app" : "library",
+					library->name.c_str());
+				return false;
+			}
+			
+			// ownership of the library has been transferred to chibi_info
+			library = nullptr;
+		}
+		else if (entry.type == ChibiFileResult::kEntryType_CMakeModulePath)
+		{
+			chibi_info.cmake_module_paths.push_back(result.cmake_module_paths[entry.index]);
+		}
+		else if (entry.type == ChibiFileResult::kEntryType_ChibiFile)
+		{
+			auto & chibi_file = *result.chibi_files[entry.index];
+			
+			if (!merge_chibi_file_result(chibi_info, chibi_file))
+			{
+				report_error_in_file(result.filename.c_str(), "failed to process chibi file: %s", chibi_file.filename.c_str());
+				return false;
+			}
+		}
+		else
+		{
+			report_error("internal error: unknown chibi file entry type");
+			return false;
+		}
 	}
+	
+	return true;
 }
 
 bool find_chibi_build_root(const char * source_path, char * build_root, const int build_root_size)
@@ -1431,7 +2326,7 @@ bool find_chibi_build_root(const char * source_path, char * build_root, const in
 	char current_path[PATH_MAX];
 	if (!copy_string(current_path, sizeof(current_path), source_path))
 	{
-		report_error(nullptr, "failed to copy path");
+		report_error("failed to copy path");
 		return false;
 	}
 	
@@ -1443,7 +2338,7 @@ bool find_chibi_build_root(const char * source_path, char * build_root, const in
 		char root_path[PATH_MAX];
 		if (!concat(root_path, sizeof(root_path), current_path, "/chibi-root.txt"))
 		{
-			report_error(nullptr, "failed to create absolute path");
+			report_error("failed to create absolute path");
 			return false;
 		}
 
@@ -1451,7 +2346,7 @@ bool find_chibi_build_root(const char * source_path, char * build_root, const in
 		{
 			if (!copy_string(build_root, build_root_size, root_path))
 			{
-				report_error(nullptr, "failed to copy path");
+				report_error("failed to copy path");
 				return false;
 			}
 		}
@@ -1520,7 +2415,245 @@ static bool get_current_working_directory(char * out_cwd, const int out_cwd_size
 	return true;
 }
 
-static bool chibi_process(ChibiInfo & chibi_info, const char * build_root, const bool skip_file_scan, const char * platform)
+static bool list_git_files(const ChibiParseContext & context, const char * search_path, const bool traverse, std::vector<std::string> & filenames, std::vector<std::string> & input_paths)
+{
+	const GitIndex * index = context.git_index_cache->find_index(search_path);
+	
+	if (index == nullptr)
+		return false;
+	
+	// note : the index is rewritten by git whenever files are added to or removed from the working tree
+	
+	input_paths.push_back(index->index_filename);
+	
+	// determine the location of the search path within the working tree
+	
+	const std::string path = normalize_path(search_path);
+	
+	std::string relative_path;
+	
+	if (path.size() > index->worktree_path.size())
+	{
+		if (!string_starts_with(path, index->worktree_path) || path[index->worktree_path.size()] != '/')
+			return false;
+		
+		relative_path = path.substr(index->worktree_path.size() + 1);
+	}
+	
+	index->list_files(relative_path, traverse, search_path, filenames);
+	
+	return true;
+}
+
+static void run_file_scan(const ChibiParseContext & context, const ChibiFileScan & file_scan, std::vector<ChibiLibraryFile> & library_files, std::vector<std::string> & input_paths)
+{
+	std::vector<std::string> filenames;
+	
+	bool listed = false;
+	
+	if (file_scan.source == kScanSource_Git)
+		listed = list_git_files(context, file_scan.path.c_str(), file_scan.traverse, filenames, input_paths);
+	
+	if (listed == false)
+		filenames = listFiles(file_scan.path.c_str(), file_scan.traverse, context.directory_cache, &input_paths);
+	
+	// compile the pattern once, as it's matched against every file found
+	
+	const char * extensions = file_scan.extensions.c_str();
+	
+	WildcardPattern pattern;
+	
+	if (strpbrk(extensions, "*?[") != nullptr)
+		pattern.add(extensions, ';');
+	else
+		pattern.set_extensions(extensions, '|');
+	
+	auto end = std::remove_if(filenames.begin(), filenames.end(), [&](const std::string & filename) -> bool
+		{
+			if (pattern.match(filename) == false)
+				return true;
+			
+			for (auto & excluded_path : file_scan.excluded_paths)
+				if (string_starts_with(filename, excluded_path))
+					return true;
+			
+			for (auto & excluded_file : file_scan.excluded_files)
+				if (filename == excluded_file)
+					return true;
+			
+			return false;
+		});
+	
+	filenames.erase(end, filenames.end());
+	
+	const InternedString group(file_scan.group);
+	const InternedString conglomerate_filename(file_scan.conglomerate_filename);
+	
+	library_files.reserve(filenames.size());
+	
+	for (auto & filename : filenames)
+	{
+		ChibiLibraryFile file;
+		
+		file.filename = std::move(filename);
+		file.group = group;
+		file.auto_conglomerate = file_scan.auto_conglomerate;
+		
+		if (conglomerate_filename.empty() == false)
+		{
+			file.conglomerate_filename = conglomerate_filename;
+			file.compile = false;
+		}
+		
+		library_files.push_back(std::move(file));
+	}
+}
+
+// gathers the libraries which are part of the build: the build targets and the libraries they depend on
+static void gather_build_libraries(const ChibiInfo & chibi_info, chibi::LibrarySet & libraries)
+{
+	libraries.resize(chibi_info.libraries.size());
+	
+	for (auto * library : chibi_info.libraries)
+	{
+		if (chibi_info.should_build_target(library->name.c_str()))
+		{
+			libraries.insert(library->id);
+			libraries.insert(chibi_info.dependency_graph.nodes[library->id].closure);
+		}
+	}
+}
+
+/**
+ * Runs the pending scan_files operations for the libraries which are part of the build: the selected targets and
+ * all of the libraries they depend on. Libraries outside of the build are dropped by the writers, so scanning for
+ * their files would be wasted effort.
+ */
+static void run_file_scans(const ChibiParseContext & context, ChibiInfo & chibi_info)
+{
+	chibi::LibrarySet libraries;
+	gather_build_libraries(chibi_info, libraries);
+	
+	// scan for files concurrently
+	
+	struct Scan
+	{
+		ChibiLibrary * library;
+		
+		const ChibiFileScan * file_scan;
+		
+		std::vector<ChibiLibraryFile> library_files;
+		
+		std::vector<std::string> input_paths; // the directories or git index read
+	};
+	
+	std::vector<Scan> scans;
+	
+	for (auto * library : chibi_info.libraries)
+	{
+		if (libraries.contains(library->id) == false)
+			continue;
+		
+		for (auto & file_scan : library->file_scans)
+		{
+			Scan scan;
+			scan.library = library;
+			scan.file_scan = &file_scan;
+			
+			scans.push_back(scan);
+		}
+	}
+	
+	TaskGroup task_group;
+	
+	for (auto & scan : scans)
+	{
+		task_group.add([&context, &scan]()
+			{
+				run_file_scan(context, *scan.file_scan, scan.library_files, scan.input_paths);
+			});
+	}
+	
+	task_group.wait();
+	
+	// remember the directories and git indices read. scans often overlap, so we list each of them only once
+	
+	std::set<std::string> input_paths;
+	
+	for (auto & scan : scans)
+		for (auto & input_path : scan.input_paths)
+			if (input_paths.insert(input_path).second)
+				chibi_info.input_paths.push_back(input_path);
+	
+	// add the files to the libraries. we go back to front, so the locations of the remaining scans stay valid
+	
+	for (auto scan = scans.rbegin(); scan != scans.rend(); ++scan)
+	{
+		auto & files = scan->library->files;
+		
+		files.insert(
+			files.begin() + scan->file_scan->file_index,
+			std::make_move_iterator(scan->library_files.begin()),
+			std::make_move_iterator(scan->library_files.end()));
+	}
+	
+	for (auto * library : chibi_info.libraries)
+		if (libraries.contains(library->id))
+			library->file_scans.clear();
+}
+
+// marks the files which would be compiled as part of a conglomerate, but differ from the git index, so they are
+// compiled by themselves instead. these are the files being worked on, which are likely to change again
+static void mark_modified_files(const ChibiParseContext & context, ChibiInfo & chibi_info)
+{
+	chibi::LibrarySet libraries;
+	gather_build_libraries(chibi_info, libraries);
+	
+	std::set<std::string> index_filenames;
+	
+	for (auto * library : chibi_info.libraries)
+	{
+		if (libraries.contains(library->id) == false)
+			continue;
+		
+		for (auto & library_file : library->files)
+		{
+			// note : files which are part of a conglomerate are marked as not to be compiled already
+			
+			const bool is_conglomerated =
+				library_file.conglomerate_filename.empty() == false ||
+				(library_file.compile && (library_file.auto_conglomerate || library->auto_conglomerate));
+			
+			if (is_conglomerated == false)
+				continue;
+			
+			// note : files are looked up by their directory, so the repository is searched for once per directory.
+			//        files outside of a git repository are left alone, as there's nothing to compare them against
+			
+			const std::string directory = library_file.filename.substr(0, library_file.filename.find_last_of('/'));
+			
+			const GitIndex * index = context.git_index_cache->find_index(directory.c_str());
+			
+			if (index == nullptr)
+				continue;
+			
+			if (index_filenames.insert(index->index_filename).second)
+				chibi_info.input_paths.push_back(index->index_filename);
+			
+			library_file.is_modified = index->is_modified(library_file.filename.c_str());
+			
+			// note : an unmodified file is pulled out of its conglomerate when it changes, the next time chibi runs. we
+			//        don't make it a configure dependency, as the build files would list every file twice. the index
+			//        is, so cmake configures again when files are staged or committed. modified files remain modified
+			//        until the index changes
+			
+			if (library_file.is_modified == false)
+				chibi_info.fingerprint_paths.push_back(library_file.filename);
+		}
+	}
+}
+
+static bool chibi_process(ChibiInfo & chibi_info, const char * build_root, const char * platform, ChibiParseContext & context)
 {
 	// set the platform name
 	
@@ -1530,25 +2663,25 @@ static bool chibi_process(ChibiInfo & chibi_info, const char * build_root, const
 		
 		if (separator == nullptr)
 		{
-			s_platform = platform;
-			s_platform_full.clear();
+			context.platform = platform;
+			context.platform_full.clear();
 		}
 		else
 		{
-			s_platform = std::string(platform).substr(0, separator - platform);
-			s_platform_full = platform;
+			context.platform = std::string(platform).substr(0, separator - platform);
+			context.platform_full = platform;
 		}
 	}
 	else
 	{
 	#if defined(MACOS)
-		s_platform = "macos";
+		context.platform = "macos";
 	#elif defined(LINUX)
-		s_platform = "linux";
+		context.platform = "linux";
 	#elif defined(WINDOWS)
-		s_platform = "windows";
+		context.platform = "windows";
 	#elif defined(ANDROID)
-		s_platform = "android";
+		context.platform = "android";
 	#else
 		#error unknown platform
 	#endif
@@ -1582,29 +2715,77 @@ static bool chibi_process(ChibiInfo & chibi_info, const char * build_root, const
 		}
 		
 		if (isRaspberryPi)
-			s_platform_full = "linux.raspberry-pi";
+			context.platform_full = "linux.raspberry-pi";
 	#endif
 	}
 
-	std::string current_group;
+	// parse the chibi root file and all of the chibi files it references. files are parsed concurrently
+	
+	TaskGroup task_group;
+	
+	context.task_group = &task_group;
+	
+	GitIndexCache git_index_cache;
+	
+	context.git_index_cache = &git_index_cache;
+	
+	ChibiFileResult root_file;
+	root_file.filename = build_root;
+	
+	task_group.add([&]()
+		{
+			process_chibi_file(context, root_file);
+		});
 	
-	if (!process_chibi_root_file(chibi_info, build_root, current_group, skip_file_scan))
+	task_group.wait();
+	
+	context.task_group = nullptr;
+	
+	// store the results in the parse cache before merging them, as merging moves the libraries into chibi_info
+	
+	if (context.use_parse_cache && root_file.success)
+	{
+		update_parse_cache(context, root_file);
+		
+		if (context.new_parse_cache.entries.size() != context.parse_cache.entries.size())
+			context.parse_cache_changed = true;
+	}
+	
+	gather_chibi_files(root_file, chibi_info.input_paths);
+	
+	// merge the results in the same order as they would have been processed sequentially
+	
+	if (!merge_chibi_file_result(chibi_info, root_file))
 	{
-		report_error(nullptr, "an error occured while scanning for chibi files");
+		report_error("an error occured while scanning for chibi files");
 		return false;
 	}
 	
+	chibi_info.resolve_library_dependencies();
+	
+	chibi_info.dependency_graph.build(chibi_info);
+	
+	// scan for the files of the libraries which are part of the build
+	
+	if (context.skip_file_scan == false)
+		run_file_scans(context, chibi_info);
+	
+	if (context.adaptive_conglomerates)
+		mark_modified_files(context, chibi_info);
+	
+	context.git_index_cache = nullptr;
+	
 	//s_chibiInfo.dump_info();
 	
 	return true;
 }
 
-bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst_path, const char ** targets, const int numTargets, const char * platform)
+bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst_path, const char ** targets, const int numTargets, const char * platform, const ChibiOptions & options)
 {
 	ChibiInfo chibi_info;
 	
 	for (int i = 0; i < numTargets; ++i)
-		chibi_info.build_targets.insert(targets[i]);
+		chibi_info.add_build_target(targets[i]);
 	
 	//
 	
@@ -1616,7 +2797,7 @@ bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst
 
 		if (get_current_working_directory(cwd, sizeof(cwd)) == false)
 		{
-			report_error(nullptr, "failed to get current working directory");
+			report_error("failed to get current working directory");
 			return false;
 		}
 	}
@@ -1624,7 +2805,7 @@ bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst
 	{
 		if (!copy_string(cwd, sizeof(cwd), in_cwd))
 		{
-			report_error(nullptr, "failed to copy cwd string");
+			report_error("failed to copy cwd string");
 			return false;
 		}
 	}
@@ -1635,7 +2816,7 @@ bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst
 	
 	if (create_absolute_path_given_cwd(cwd, src_path, source_path, sizeof(source_path)) == false)
 	{
-		report_error(nullptr, "failed to create absolute path");
+		report_error("failed to create absolute path");
 		return false;
 	}
 
@@ -1646,7 +2827,7 @@ bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst
 	
 	if (find_chibi_build_root(source_path, build_root, sizeof(build_root)) == false)
 	{
-		report_error(nullptr, "failed to find chibi-root.txt file");
+		report_error("failed to find chibi-root.txt file");
 		return false;
 	}
 	
@@ -1656,9 +2837,121 @@ bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst
 	printf("build_root: %s\n", build_root);
 #endif
 
-	if (chibi_process(chibi_info, build_root, false, platform) == false)
+	// the command line which generates the build files again. the generated build files use it to regenerate
+	// themselves, and it's part of the fingerprint, as different options may lead to different output
+	
+	std::vector<std::string> command;
+	
+	command.push_back(options.chibi_path);
+	command.push_back("-g");
+	command.push_back(source_path);
+	command.push_back(dst_path);
+	
+	for (auto & build_target : chibi_info.build_targets)
+	{
+		command.push_back("-target");
+		command.push_back(build_target);
+	}
+	
+	if (platform != nullptr)
+	{
+		command.push_back("-platform");
+		command.push_back(platform);
+	}
+	
+	if (options.use_cache == false)
+		command.push_back("-no-cache");
+	if (options.regenerate == false)
+		command.push_back("-no-regenerate");
+	if (options.split_targets)
+		command.push_back("-split-targets");
+	if (options.compact)
+		command.push_back("-compact");
+	if (options.adaptive_conglomerates)
+		command.push_back("-adaptive-conglomerates");
+	if (options.split_conglomerates)
+		command.push_back("-split-conglomerates");
+	if (options.build_log.empty() == false)
+	{
+		command.push_back("-build-log");
+		command.push_back(options.build_log);
+	}
+	
+	// check if anything changed since the previous run. if not, the build files are still up to date
+	
+	std::string arguments = cwd;
+	
+	for (auto & argument : command)
+		arguments += "\n" + argument;
+	
+	char fingerprint_filename[PATH_MAX];
+	
+	const int64_t start_time = get_current_time();
+	
+	if (options.use_cache)
+	{
+		if (!concat(fingerprint_filename, sizeof(fingerprint_filename), dst_path, "/", "chibi-fingerprint.bin"))
+		{
+			report_error("failed to create absolute path");
+			return false;
+		}
+		
+		// note : checking conglomerates reads the source files, which aren't part of the fingerprint
+		
+		Fingerprint fingerprint;
+		
+		if (options.check_conglomerates == false && fingerprint.load(fingerprint_filename) && fingerprint.is_up_to_date(arguments))
+		{
+			printf("build files are up to date\n");
+			return true;
+		}
+	}
+	
+	ChibiParseContext context;
+	context.adaptive_conglomerates = options.adaptive_conglomerates;
+	context.start_time = start_time;
+	
+	// load the parse results and directory listings from the previous run
+	
+	char parse_cache_filename[PATH_MAX];
+	char directory_cache_filename[PATH_MAX];
+	
+	DirectoryCache directory_cache;
+	
+	if (options.use_cache)
+	{
+		if (!concat(parse_cache_filename, sizeof(parse_cache_filename), dst_path, "/", "chibi-cache.bin") ||
+			!concat(directory_cache_filename, sizeof(directory_cache_filename), dst_path, "/", "chibi-dircache.bin"))
+		{
+			report_error("failed to create absolute path");
+			return false;
+		}
+		
+		context.use_parse_cache = true;
+		context.parse_cache.load(parse_cache_filename);
+		
+		context.directory_cache = &directory_cache;
+		directory_cache.load(directory_cache_filename);
+	}
+	
+	if (chibi_process(chibi_info, build_root, platform, context) == false)
 		return false;
 	
+	if (options.use_cache)
+	{
+		if (options.show_cache_stats)
+		{
+			printf("parse cache: reused %d of %d chibi files\n", context.num_cached_chibi_files, context.num_chibi_files);
+			printf("directory cache: %d hits, %d misses, %d directories read again\n", directory_cache.num_hits, directory_cache.num_misses, directory_cache.num_rereads);
+		}
+		
+		if (context.parse_cache_changed && !context.new_parse_cache.save(parse_cache_filename))
+			printf("warning: failed to save parse cache: %s\n", parse_cache_filename);
+		
+		if (directory_cache.has_changes() && !directory_cache.save(directory_cache_filename))
+			printf("warning: failed to save directory cache: %s\n", directory_cache_filename);
+	}
+	
 	int num_build_targets = 0;
 	for (auto * library : chibi_info.libraries)
 		if (chibi_info.should_build_target(library->name.c_str()))
@@ -1668,35 +2961,86 @@ bool chibi_generate(const char * in_cwd, const char * src_path, const char * dst
 	
 	// write cmake file
 	
+	std::vector<std::string> output_paths; // all of the files written
+	
 	char output_filename[PATH_MAX];
 	
 	if (!concat(output_filename, sizeof(output_filename), dst_path, "/", "CMakeLists.txt"))
 	{
-		report_error(nullptr, "failed to create absolute path");
+		report_error("failed to create absolute path");
 		return false;
 	}
 	
 	if (!write_cmake_file(
 		chibi_info,
-		!s_platform_full.empty()
-			? s_platform_full.c_str()
-			: s_platform.c_str(),
-		output_filename))
+		!context.platform_full.empty()
+			? context.platform_full.c_str()
+			: context.platform.c_str(),
+		output_filename,
+		options,
+		options.regenerate && options.chibi_path.empty() == false ? command : std::vector<std::string>(),
+		cwd,
+		chibi_info.input_paths,
+		output_paths))
 	{
-		report_error(nullptr, "an error occured while generating cmake file");
+		report_error("an error occured while generating cmake file");
 		return false;
 	}
 
 	// write gradle files
 	
-	if (is_platform("android"))
+	if (context.is_platform("android"))
 	{
-		if (!write_gradle_files(chibi_info, dst_path))
+		if (!write_gradle_files(chibi_info, dst_path, output_paths))
 		{
-			report_error(nullptr, "an error occured while generating gradle files");
+			report_error("an error occured while generating gradle files");
 			return false;
 		}
 	}
+	
+	// record the inputs and outputs, so the next run can tell whether anything changed
+	
+	if (options.use_cache)
+	{
+		Fingerprint fingerprint;
+		fingerprint.arguments = arguments;
+		
+		bool is_reliable = true;
+		
+		for (auto & input_path : chibi_info.input_paths)
+			if (!fingerprint.add_input(input_path.c_str(), start_time))
+				is_reliable = false;
+		for (auto & fingerprint_path : chibi_info.fingerprint_paths)
+			if (!fingerprint.add_input(fingerprint_path.c_str(), start_time))
+				is_reliable = false;
+		
+		// note : a new chibi executable may generate different output
+		if (options.chibi_path.find('/') != std::string::npos || options.chibi_path.find('\\') != std::string::npos)
+			if (!fingerprint.add_input(options.chibi_path.c_str(), start_time))
+				is_reliable = false;
+		
+		// note : the build log changes with each build, and leads to differently balanced conglomerates
+		if (options.build_log.empty() == false)
+		{
+			std::string build_log_filename = options.build_log + "/.ninja_log";
+			
+			int64_t mtime;
+			int64_t size;
+			if (!get_file_info(build_log_filename.c_str(), mtime, size))
+				build_log_filename = options.build_log;
+			
+			if (!fingerprint.add_input(build_log_filename.c_str(), start_time))
+				is_reliable = false;
+		}
+		
+		for (auto & output_path : output_paths)
+			fingerprint.add_output(output_path.c_str());
+		
+		if (is_reliable == false)
+			remove(fingerprint_filename);
+		else if (!fingerprint.save(fingerprint_filename))
+			printf("warning: failed to save fingerprint: %s\n", fingerprint_filename);
+	}
 
 	return true;
 }
@@ -1707,7 +3051,10 @@ bool list_chibi_targets(const char * build_root, std::vector<std::string> & libr
 	
 	//
 	
-	if (chibi_process(chibi_info, build_root, true, nullptr) == false)
+	ChibiParseContext context;
+	context.skip_file_scan = true;
+	
+	if (chibi_process(chibi_info, build_root, nullptr, context) == false)
 		return false;
 	
 	//
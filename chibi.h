@@ -18,6 +18,32 @@ void show_chibi_syntax();
  */
 bool find_chibi_build_root(const char * source_path, char * build_root, const int build_root_size);
 
+/**
+ * Options which affect how chibi goes about generating build files.
+ */
+struct ChibiOptions
+{
+	bool use_cache = true; // reuse parse results and directory listings from the previous run, for files and directories which didn't change. skip generation altogether when no input changed
+	
+	bool show_cache_stats = false; // print statistics about the effectiveness of the caches
+	
+	bool split_targets = false; // write each library and app to its own .cmake file, included from CMakeLists.txt
+	
+	bool compact = false; // batch commands into as few calls as possible, and list header files for IDE generators only, to reduce cmake configure time
+	
+	bool adaptive_conglomerates = false; // compile files which differ from the git index by themselves, rather than as part of a conglomerate, so editing them doesn't recompile the whole conglomerate
+	
+	bool check_conglomerates = false; // scan the files included into each conglomerate for file-local symbols and macros which collide, and fail when any are found
+	
+	bool split_conglomerates = false; // compile the files causing collisions by themselves, rather than as part of their conglomerate
+	
+	std::string build_log; // a .ninja_log file, or a build directory containing one. when set, automatically generated conglomerates are balanced using the compile times measured during the previous build
+	
+	std::string chibi_path; // the chibi executable. when set, the generated build files invoke it to generate themselves again when a chibi file or scanned directory changes
+	
+	bool regenerate = true; // let the generated build files invoke chibi to generate themselves again. disable when the build files are shared or moved across machines, as they contain the path to chibi and the working directory
+};
+
 /**
  * Generates a CMakeLists.txt file, using the build root found starting at src_path. Upon success, the generated file
  * will be written to dst_path. Optionally, one or more target filters can be specified to include only a specific
@@ -28,9 +54,10 @@ bool find_chibi_build_root(const char * source_path, char * build_root, const in
  * @param targets One or more optional target filters, to limit the scope of the generated CMakeLists.txt file.
  * @param num_targets The number of elements of the targets array. CMake apps and libraries will be generated for all targets when zero.
  * @param platform The platform for which to generate the CMakeLists.txt file. By default this is determined by the OS for which chibi is compiled.
+ * @param options Additional options. See ChibiOptions.
  * @return True if the CMakeLists.txt file was successfully generated. False otherwise.
  */
-bool chibi_generate(const char * cwd, const char * src_path, const char * dst_path, const char ** targets, const int numTargets, const char * platform = nullptr);
+bool chibi_generate(const char * cwd, const char * src_path, const char * dst_path, const char ** targets, const int numTargets, const char * platform = nullptr, const ChibiOptions & options = ChibiOptions());
 
 /**
  * Lists all of the app and library targets found by parsing the given build root.
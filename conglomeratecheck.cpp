@@ -0,0 +1,1173 @@
+#include "conglomeratecheck.h"
+#include "filesystem.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace chibi_filesystem;
+
+namespace chibi
+{
+	struct Token
+	{
+		enum Kind
+		{
+			kKind_Identifier,
+			kKind_Literal,
+			kKind_Punctuation
+		};
+		
+		Kind kind = kKind_Punctuation;
+		std::string text;
+		int line = 0;
+	};
+	
+	static bool is_identifier_begin(const char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (unsigned char)c >= 0x80;
+	}
+	
+	static bool is_identifier_char(const char c)
+	{
+		return is_identifier_begin(c) || (c >= '0' && c <= '9');
+	}
+	
+	static bool is_whitespace(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+	}
+	
+	// splits the source text into tokens, skipping comments. preprocessor directives don't produce tokens. the
+	// macro definitions and conditions they contain are recorded directly
+	struct Lexer
+	{
+		const char * p = nullptr;
+		int line = 1;
+		bool is_line_begin = true;
+		
+		std::string guard_name; // the macro tested by the previous directive, when it's #ifndef
+		
+		SourceSymbols * symbols = nullptr;
+		
+		void add_identifier(const std::string & name, const int line)
+		{
+			symbols->identifiers.insert(std::make_pair(name, line));
+		}
+		
+		void skip_block_comment()
+		{
+			p += 2;
+			
+			while (p[0] != 0 && (p[0] != '*' || p[1] != '/'))
+			{
+				if (p[0] == '\n')
+					line++;
+				p++;
+			}
+			
+			if (p[0] != 0)
+				p += 2;
+		}
+		
+		void skip_quoted(const char quote)
+		{
+			p++;
+			
+			while (p[0] != 0 && p[0] != quote && p[0] != '\n')
+			{
+				if (p[0] == '\\' && p[1] != 0)
+				{
+					if (p[1] == '\n')
+						line++;
+					p++;
+				}
+				
+				p++;
+			}
+			
+			if (p[0] == quote)
+				p++;
+		}
+		
+		// R"delimiter( .. )delimiter"
+		void skip_raw_string()
+		{
+			p++;
+			
+			const char * delimiter_begin = p;
+			
+			while (p[0] != 0 && p[0] != '(' && p[0] != '\n')
+				p++;
+			
+			const std::string terminator = ")" + std::string(delimiter_begin, p) + "\"";
+			
+			const char * end = strstr(p, terminator.c_str());
+			
+			if (end == nullptr)
+				end = p + strlen(p);
+			else
+				end += terminator.size();
+			
+			for (; p < end; ++p)
+				if (p[0] == '\n')
+					line++;
+		}
+		
+		void read_directive()
+		{
+			const int directive_line = line;
+			
+			// gather the logical line, with line continuations and comments removed
+			
+			std::string text;
+			
+			while (p[0] != 0 && p[0] != '\n')
+			{
+				if (p[0] == '\\' && (p[1] == '\n' || (p[1] == '\r' && p[2] == '\n')))
+				{
+					p += p[1] == '\r' ? 3 : 2;
+					line++;
+				}
+				else if (p[0] == '/' && p[1] == '*')
+				{
+					skip_block_comment();
+					text.push_back(' ');
+				}
+				else if (p[0] == '/' && p[1] == '/')
+				{
+					while (p[0] != 0 && p[0] != '\n')
+						p++;
+				}
+				else
+				{
+					text.push_back(p[0]);
+					p++;
+				}
+			}
+			
+			const char * d = text.c_str();
+			
+			while (is_whitespace(d[0]))
+				d++;
+			
+			const char * name_begin = d;
+			while (is_identifier_char(d[0]))
+				d++;
+			const std::string directive(name_begin, d);
+			
+			while (is_whitespace(d[0]))
+				d++;
+			
+			const std::string previous_guard_name = guard_name;
+			guard_name.clear();
+			
+			if (directive == "ifndef")
+			{
+				const char * guard_name_end = d;
+				while (is_identifier_char(guard_name_end[0]))
+					guard_name_end++;
+				guard_name.assign(d, guard_name_end);
+			}
+			
+			if (directive == "define" || directive == "undef")
+			{
+				const char * macro_begin = d;
+				while (is_identifier_char(d[0]))
+					d++;
+				
+				SourceSymbols::MacroDirective macro_directive;
+				macro_directive.name = std::string(macro_begin, d);
+				macro_directive.is_undef = directive == "undef";
+				macro_directive.is_guarded = macro_directive.is_undef == false && macro_directive.name == previous_guard_name;
+				macro_directive.line = directive_line;
+				
+				// note : whitespace is normalized, as redefinitions are allowed as long as they are identical
+				//        apart from whitespace. the parameter list of function-like macros directly follows the name,
+				//        so the whitespace in front of the replacement list is kept
+				
+				bool is_space = false;
+				
+				for (; d[0] != 0; ++d)
+				{
+					if (is_whitespace(d[0]))
+						is_space = true;
+					else
+					{
+						if (is_space)
+							macro_directive.definition.push_back(' ');
+						macro_directive.definition.push_back(d[0]);
+						is_space = false;
+					}
+				}
+				
+				// note : whitespace inside the parameter list doesn't matter at all
+				
+				if (macro_directive.definition.empty() == false && macro_directive.definition[0] == '(')
+				{
+					std::string & definition = macro_directive.definition;
+					
+					const size_t parameters_end = definition.find(')');
+					
+					if (parameters_end != std::string::npos)
+						definition.erase(std::remove(definition.begin(), definition.begin() + parameters_end, ' '), definition.begin() + parameters_end);
+				}
+				
+				if (macro_directive.name.empty() == false)
+					symbols->macro_directives.push_back(macro_directive);
+			}
+			else if (directive == "if" || directive == "ifdef" || directive == "ifndef" || directive == "elif")
+			{
+				// the identifiers used by conditions may refer to macros defined by other files
+				
+				while (d[0] != 0)
+				{
+					if (is_identifier_begin(d[0]))
+					{
+						const char * identifier_begin = d;
+						while (is_identifier_char(d[0]))
+							d++;
+						
+						const std::string identifier(identifier_begin, d);
+						
+						if (identifier != "defined")
+							add_identifier(identifier, directive_line);
+					}
+					else if (d[0] >= '0' && d[0] <= '9')
+					{
+						while (is_identifier_char(d[0]))
+							d++;
+					}
+					else
+						d++;
+				}
+			}
+		}
+		
+		bool next(Token & token)
+		{
+			for (;;)
+			{
+				if (p[0] == 0)
+					return false;
+				else if (p[0] == '\n')
+				{
+					line++;
+					is_line_begin = true;
+					p++;
+				}
+				else if (is_whitespace(p[0]))
+					p++;
+				else if (p[0] == '\\' && p[1] == '\n')
+				{
+					line++;
+					p += 2;
+				}
+				else if (p[0] == '/' && p[1] == '/')
+				{
+					while (p[0] != 0 && p[0] != '\n')
+						p++;
+				}
+				else if (p[0] == '/' && p[1] == '*')
+					skip_block_comment();
+				else if (p[0] == '#' && is_line_begin)
+				{
+					p++;
+					read_directive();
+				}
+				else
+					break;
+			}
+			
+			is_line_begin = false;
+			
+			token.line = line;
+			
+			const char * begin = p;
+			
+			if (is_identifier_begin(p[0]))
+			{
+				while (is_identifier_char(p[0]))
+					p++;
+				
+				token.kind = Token::kKind_Identifier;
+				token.text.assign(begin, p);
+				
+				// string and character literals may have an encoding prefix
+				
+				if (p[0] == '"' || p[0] == '\'')
+				{
+					const bool is_raw = p[0] == '"' && (token.text == "R" || token.text == "LR" || token.text == "uR" || token.text == "UR" || token.text == "u8R");
+					const bool is_prefix = token.text == "L" || token.text == "u" || token.text == "U" || token.text == "u8";
+					
+					if (is_raw)
+					{
+						skip_raw_string();
+						token.kind = Token::kKind_Literal;
+					}
+					else if (is_prefix)
+					{
+						skip_quoted(p[0]);
+						token.kind = Token::kKind_Literal;
+					}
+				}
+			}
+			else if ((p[0] >= '0' && p[0] <= '9') || (p[0] == '.' && p[1] >= '0' && p[1] <= '9'))
+			{
+				// note : this includes digit separators, and the signs of exponents
+				
+				while (is_identifier_char(p[0]) || p[0] == '.' || p[0] == '\'' ||
+					((p[0] == '+' || p[0] == '-') && (p[-1] == 'e' || p[-1] == 'E' || p[-1] == 'p' || p[-1] == 'P')))
+				{
+					p++;
+				}
+				
+				token.kind = Token::kKind_Literal;
+			}
+			else if (p[0] == '"' || p[0] == '\'')
+			{
+				skip_quoted(p[0]);
+				token.kind = Token::kKind_Literal;
+			}
+			else if (p[0] == ':' && p[1] == ':')
+			{
+				p += 2;
+				token.kind = Token::kKind_Punctuation;
+			}
+			else
+			{
+				p++;
+				token.kind = Token::kKind_Punctuation;
+			}
+			
+			if (token.kind != Token::kKind_Identifier)
+				token.text.assign(begin, p);
+			
+			return true;
+		}
+	};
+	
+	static bool is_punctuation(const Token & token, const char * text)
+	{
+		return token.kind == Token::kKind_Punctuation && token.text == text;
+	}
+	
+	static bool is_identifier(const Token & token, const char * text)
+	{
+		return token.kind == Token::kKind_Identifier && token.text == text;
+	}
+	
+	// removes attributes, as they may appear almost anywhere within a declaration: [[..]], __attribute__((..)),
+	// __declspec(..) and alignas(..)
+	static void remove_attributes(std::vector<Token> & tokens)
+	{
+		std::vector<Token> result;
+		
+		for (size_t i = 0; i < tokens.size(); ++i)
+		{
+			size_t end = i;
+			
+			if (is_punctuation(tokens[i], "[") && i + 1 < tokens.size() && is_punctuation(tokens[i + 1], "["))
+			{
+				int depth = 0;
+				
+				for (end = i; end < tokens.size(); ++end)
+				{
+					if (is_punctuation(tokens[end], "["))
+						depth++;
+					else if (is_punctuation(tokens[end], "]") && --depth == 0)
+						break;
+				}
+			}
+			else if (
+				(is_identifier(tokens[i], "__attribute__") || is_identifier(tokens[i], "__declspec") || is_identifier(tokens[i], "alignas")) &&
+				i + 1 < tokens.size() && is_punctuation(tokens[i + 1], "("))
+			{
+				int depth = 0;
+				
+				for (end = i + 1; end < tokens.size(); ++end)
+				{
+					if (is_punctuation(tokens[end], "("))
+						depth++;
+					else if (is_punctuation(tokens[end], ")") && --depth == 0)
+						break;
+				}
+			}
+			else
+			{
+				result.push_back(tokens[i]);
+				continue;
+			}
+			
+			i = end;
+		}
+		
+		tokens.swap(result);
+	}
+	
+	static std::string join_tokens(const std::vector<Token> & tokens, const size_t begin, const size_t end)
+	{
+		std::string result;
+		
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (i != begin)
+				result.push_back(' ');
+			result += tokens[i].text;
+		}
+		
+		return result;
+	}
+	
+	// returns the parameter types of a function, given the tokens of its parameter list. parameter names and default
+	// arguments are left out, so overloads can be told apart from redefinitions
+	static std::string get_parameter_types(const std::vector<Token> & tokens, const size_t begin, const size_t end)
+	{
+		std::string result;
+		
+		size_t parameter_begin = begin;
+		int depth = 0;
+		
+		for (size_t i = begin; i <= end; ++i)
+		{
+			if (i < end)
+			{
+				if (is_punctuation(tokens[i], "(") || is_punctuation(tokens[i], "<") || is_punctuation(tokens[i], "["))
+					depth++;
+				else if (is_punctuation(tokens[i], ")") || is_punctuation(tokens[i], ">") || is_punctuation(tokens[i], "]"))
+					depth--;
+				
+				if (depth != 0 || is_punctuation(tokens[i], ",") == false)
+					continue;
+			}
+			
+			size_t parameter_end = i;
+			
+			for (size_t j = parameter_begin; j < i; ++j)
+			{
+				if (is_punctuation(tokens[j], "="))
+				{
+					parameter_end = j;
+					break;
+				}
+			}
+			
+			if (parameter_end - parameter_begin >= 2 && tokens[parameter_end - 1].kind == Token::kKind_Identifier)
+			{
+				const Token & type_end = tokens[parameter_end - 2];
+				
+				const bool has_name =
+					type_end.kind == Token::kKind_Identifier ||
+					is_punctuation(type_end, "*") ||
+					is_punctuation(type_end, "&") ||
+					is_punctuation(type_end, ">");
+				
+				if (has_name)
+					parameter_end--;
+			}
+			
+			const std::string parameter = join_tokens(tokens, parameter_begin, parameter_end);
+			
+			if (parameter != "void")
+			{
+				if (result.empty() == false)
+					result += ", ";
+				result += parameter;
+			}
+			
+			parameter_begin = i + 1;
+		}
+		
+		return result;
+	}
+	
+	// finds the file-local symbols declared at namespace scope
+	struct DeclarationParser
+	{
+		enum ScopeKind
+		{
+			kScopeKind_Namespace,
+			kScopeKind_Enum,
+			kScopeKind_Other
+		};
+		
+		struct Scope
+		{
+			ScopeKind kind = kScopeKind_Other;
+			std::string name; // for named namespaces
+			bool is_anonymous = false; // for namespaces
+		};
+		
+		std::vector<Scope> scopes;
+		
+		std::vector<Token> statement; // the tokens of the current declaration at namespace scope
+		
+		bool is_statement_processed = false;
+		bool statement_has_body = false;
+		
+		bool expects_enumerator = false;
+		int enum_paren_depth = 0;
+		
+		SourceSymbols * symbols = nullptr;
+		
+		int get_other_depth() const
+		{
+			int result = 0;
+			
+			for (auto & scope : scopes)
+				if (scope.kind != kScopeKind_Namespace)
+					result++;
+			
+			return result;
+		}
+		
+		bool is_anonymous() const
+		{
+			for (auto & scope : scopes)
+				if (scope.is_anonymous)
+					return true;
+			
+			return false;
+		}
+		
+		// note : names are qualified by the named namespaces they're part of. anonymous namespaces inside the same
+		//        namespace are merged when the files are included into a single translation unit
+		std::string qualify(const std::string & name) const
+		{
+			std::string result;
+			
+			for (auto & scope : scopes)
+			{
+				if (scope.kind == kScopeKind_Namespace && scope.name.empty() == false)
+				{
+					result += scope.name;
+					result += "::";
+				}
+			}
+			
+			return result + name;
+		}
+		
+		void add_symbol(const std::string & name, const SourceSymbols::SymbolKind kind, const std::string & signature, const int line, const bool is_local = true)
+		{
+			SourceSymbols::Symbol symbol;
+			symbol.name = qualify(name);
+			symbol.kind = kind;
+			symbol.signature = signature;
+			symbol.is_local = is_local;
+			symbol.line = line;
+			
+			symbols->symbols.push_back(symbol);
+		}
+		
+		void process_declaration(std::vector<Token> & tokens, const bool has_body)
+		{
+			remove_attributes(tokens);
+			
+			size_t begin = 0;
+			
+			// templates
+			
+			if (tokens.empty() == false && is_identifier(tokens[0], "template"))
+			{
+				// note : explicit instantiations don't define anything new
+				
+				if (tokens.size() < 2 || is_punctuation(tokens[1], "<") == false)
+					return;
+				
+				int depth = 0;
+				
+				for (begin = 1; begin < tokens.size(); ++begin)
+				{
+					if (is_punctuation(tokens[begin], "<"))
+						depth++;
+					else if (is_punctuation(tokens[begin], ">") && --depth == 0)
+						break;
+				}
+				
+				begin++;
+			}
+			
+			if (begin >= tokens.size())
+				return;
+			
+			const Token & first = tokens[begin];
+			
+			if (first.kind != Token::kKind_Identifier ||
+				first.text == "extern" ||
+				first.text == "friend" ||
+				first.text == "namespace" ||
+				first.text == "static_assert")
+			{
+				return;
+			}
+			
+			// alias declarations
+			
+			if (first.text == "using")
+			{
+				if (begin + 2 < tokens.size() &&
+					tokens[begin + 1].kind == Token::kKind_Identifier &&
+					is_punctuation(tokens[begin + 2], "="))
+				{
+					add_symbol(tokens[begin + 1].text, SourceSymbols::kSymbolKind_TypeAlias, join_tokens(tokens, begin + 3, tokens.size()), first.line);
+				}
+				
+				return;
+			}
+			
+			// typedefs. the name follows the type, except for function pointers
+			
+			if (first.text == "typedef")
+			{
+				if (has_body)
+					return;
+				
+				size_t name_index = 0;
+				
+				// note : function types have their name inside the first pair of parentheses, as in (*name)(..)
+				
+				for (size_t i = begin + 1; i < tokens.size(); ++i)
+				{
+					if (is_punctuation(tokens[i], "(") == false)
+						continue;
+					
+					size_t group_end = i + 1;
+					
+					while (group_end < tokens.size() && is_punctuation(tokens[group_end], ")") == false && is_punctuation(tokens[group_end], "(") == false)
+					{
+						if (tokens[group_end].kind == Token::kKind_Identifier)
+							name_index = group_end;
+						group_end++;
+					}
+					
+					if (group_end + 1 >= tokens.size() || is_punctuation(tokens[group_end], ")") == false || is_punctuation(tokens[group_end + 1], "(") == false)
+						name_index = 0;
+					
+					break;
+				}
+				
+				if (name_index == 0)
+				{
+					for (size_t i = begin + 1; i < tokens.size(); ++i)
+					{
+						if (is_punctuation(tokens[i], "[") || is_punctuation(tokens[i], "("))
+							break;
+						else if (tokens[i].kind == Token::kKind_Identifier)
+							name_index = i;
+					}
+				}
+				
+				if (name_index == 0)
+					return;
+				
+				// note : a typedef defining a type along with it always conflicts. identical typedefs don't
+				
+				std::string signature = join_tokens(tokens, begin + 1, name_index) + " " + join_tokens(tokens, name_index + 1, tokens.size());
+				
+				if (statement_has_body)
+					signature.clear();
+				
+				add_symbol(tokens[name_index].text, SourceSymbols::kSymbolKind_TypeAlias, signature, tokens[name_index].line);
+				
+				return;
+			}
+			
+			// class definitions. these aren't file-local. but as they're usually only visible to the file when defined
+			// in a source file, each file may have its own definition using the same name
+			
+			if (first.text == "struct" || first.text == "class" || first.text == "union" || first.text == "enum")
+			{
+				if (has_body == false && tokens.size() - begin == 2)
+					return;
+				
+				size_t name_index = begin + 1;
+				
+				if (first.text == "enum" && name_index < tokens.size() && (is_identifier(tokens[name_index], "class") || is_identifier(tokens[name_index], "struct")))
+					name_index++;
+				
+				if (has_body)
+				{
+					if (name_index < tokens.size() && tokens[name_index].kind == Token::kKind_Identifier)
+					{
+						// note : nested classes defined elsewhere and specializations are left out
+						
+						const bool is_definition =
+							name_index + 1 == tokens.size() ||
+							is_punctuation(tokens[name_index + 1], ":") ||
+							is_identifier(tokens[name_index + 1], "final");
+						
+						if (is_definition)
+						{
+							add_symbol(tokens[name_index].text, SourceSymbols::kSymbolKind_Type, std::string(), tokens[name_index].line);
+							return;
+						}
+					}
+				}
+			}
+			
+			// functions and variables. the name precedes the parameter list, initializer or array size
+			
+			bool is_static = false;
+			bool is_const = false;
+			bool is_inline = false;
+			bool is_pointer = false;
+			
+			size_t stop_index = begin;
+			int depth = 0;
+			
+			for (; stop_index < tokens.size(); ++stop_index)
+			{
+				const Token & token = tokens[stop_index];
+				
+				if (is_punctuation(token, "<"))
+					depth++;
+				else if (is_punctuation(token, ">"))
+					depth--;
+				else if (depth > 0)
+					continue;
+				else if (is_punctuation(token, "(") || is_punctuation(token, "=") || is_punctuation(token, "[") || is_punctuation(token, ",") || is_punctuation(token, ":"))
+					break;
+				else if (is_identifier(token, "static"))
+					is_static = true;
+				else if (is_identifier(token, "const") || is_identifier(token, "constexpr"))
+					is_const = true;
+				else if (is_identifier(token, "inline"))
+					is_inline = true;
+				else if (is_punctuation(token, "*") || is_punctuation(token, "&"))
+					is_pointer = true;
+			}
+			
+			// pointers to functions, as in (*name)(..)
+			
+			if (stop_index + 2 < tokens.size() &&
+				is_punctuation(tokens[stop_index], "(") &&
+				(is_punctuation(tokens[stop_index + 1], "*") || is_punctuation(tokens[stop_index + 1], "&")) &&
+				tokens[stop_index + 2].kind == Token::kKind_Identifier)
+			{
+				const bool is_local = is_anonymous() || is_static;
+				
+				add_symbol(tokens[stop_index + 2].text, SourceSymbols::kSymbolKind_Variable, std::string(), tokens[stop_index + 2].line, is_local);
+				
+				return;
+			}
+			
+			if (stop_index == begin || tokens[stop_index - 1].kind != Token::kKind_Identifier)
+				return;
+			
+			// note : qualified names refer to things declared elsewhere. this includes destructors
+			
+			if (stop_index >= begin + 2 && (is_punctuation(tokens[stop_index - 2], "::") || is_punctuation(tokens[stop_index - 2], "~")))
+				return;
+			
+			const Token & name = tokens[stop_index - 1];
+			
+			if (name.text == "operator" ||
+				name.text == "struct" ||
+				name.text == "class" ||
+				name.text == "union" ||
+				name.text == "enum")
+			{
+				return;
+			}
+			
+			const bool is_function = stop_index < tokens.size() && is_punctuation(tokens[stop_index], "(");
+			
+			// note : const variables have internal linkage, unless they're declared extern. for pointers, this
+			//        depends on where const appears, which is simplified here to treat them as not const
+			
+			const bool is_local =
+				is_anonymous() ||
+				is_static ||
+				(is_function == false && is_const && is_inline == false && is_pointer == false);
+			
+			// note : functions and variables with external linkage are only a problem when they collide with a
+			//        file-local one. otherwise they would fail to link without conglomerates too. declarations of
+			//        functions with external linkage are left out, as they may refer to a definition elsewhere
+			
+			if (is_local == false && is_function && has_body == false)
+				return;
+			
+			if (is_function)
+			{
+				size_t parameters_end = stop_index + 1;
+				
+				for (int paren_depth = 1; parameters_end < tokens.size(); ++parameters_end)
+				{
+					if (is_punctuation(tokens[parameters_end], "("))
+						paren_depth++;
+					else if (is_punctuation(tokens[parameters_end], ")") && --paren_depth == 0)
+						break;
+				}
+				
+				add_symbol(name.text, SourceSymbols::kSymbolKind_Function, get_parameter_types(tokens, stop_index + 1, parameters_end), name.line, is_local);
+			}
+			else
+			{
+				add_symbol(name.text, SourceSymbols::kSymbolKind_Variable, std::string(), name.line, is_local);
+			}
+		}
+		
+		void open_scope()
+		{
+			const int other_depth = get_other_depth();
+			
+			Scope scope;
+			
+			if (other_depth == 0)
+			{
+				size_t begin = 0;
+				
+				if (statement.empty() == false && is_identifier(statement[0], "inline"))
+					begin = 1;
+				
+				if (statement.size() > begin && is_identifier(statement[begin], "namespace"))
+				{
+					scope.kind = kScopeKind_Namespace;
+					
+					// note : nested namespace definitions (namespace a::b) are kept as a single scope
+					
+					for (size_t i = begin + 1; i < statement.size(); ++i)
+						if (statement[i].kind == Token::kKind_Identifier || is_punctuation(statement[i], "::"))
+							scope.name += statement[i].text;
+					
+					scope.is_anonymous = scope.name.empty();
+					
+					statement.clear();
+				}
+				else if (statement.size() == 2 && is_identifier(statement[0], "extern") && statement[1].kind == Token::kKind_Literal)
+				{
+					// a linkage specification. it doesn't affect names
+					scope.kind = kScopeKind_Namespace;
+					
+					statement.clear();
+				}
+				else if (statement.empty() == false && is_statement_processed == false)
+				{
+					statement_has_body = true;
+					
+					std::vector<Token> tokens = statement;
+					process_declaration(tokens, true);
+					
+					// note : typedefs are processed once their name is known
+					
+					if (is_identifier(statement[0], "typedef") == false)
+						is_statement_processed = true;
+					
+					// the enumerators of unscoped enums are visible at namespace scope
+					
+					size_t enum_index = 0;
+					
+					if (statement.size() >= 2 && is_identifier(statement[0], "typedef"))
+						enum_index = 1;
+					
+					if (statement.size() > enum_index &&
+						is_identifier(statement[enum_index], "enum") &&
+						(statement.size() == enum_index + 1 ||
+						(is_identifier(statement[enum_index + 1], "class") == false && is_identifier(statement[enum_index + 1], "struct") == false)))
+					{
+						scope.kind = kScopeKind_Enum;
+						expects_enumerator = true;
+						enum_paren_depth = 0;
+					}
+				}
+			}
+			
+			scopes.push_back(scope);
+		}
+		
+		void close_scope()
+		{
+			if (scopes.empty())
+				return;
+			
+			const Scope scope = scopes.back();
+			scopes.pop_back();
+			
+			if (get_other_depth() != 0)
+				return;
+			
+			if (scope.kind == kScopeKind_Namespace)
+			{
+				statement.clear();
+				is_statement_processed = false;
+				statement_has_body = false;
+				return;
+			}
+			
+			// a function body ends the declaration. classes and initializers are followed by a semicolon
+			
+			bool is_function = false;
+			
+			for (auto & token : statement)
+				if (is_punctuation(token, "("))
+					is_function = true;
+			
+			if (is_function && statement.empty() == false && is_identifier(statement[0], "typedef") == false)
+			{
+				statement.clear();
+				is_statement_processed = false;
+				statement_has_body = false;
+			}
+		}
+		
+		void add_token(const Token & token)
+		{
+			if (token.kind == Token::kKind_Identifier)
+				symbols->identifiers.insert(std::make_pair(token.text, token.line));
+			
+			if (is_punctuation(token, "{"))
+			{
+				open_scope();
+				return;
+			}
+			
+			if (is_punctuation(token, "}"))
+			{
+				close_scope();
+				return;
+			}
+			
+			const int other_depth = get_other_depth();
+			
+			if (other_depth == 1 && scopes.back().kind == kScopeKind_Enum)
+			{
+				if (is_punctuation(token, "("))
+					enum_paren_depth++;
+				else if (is_punctuation(token, ")"))
+					enum_paren_depth--;
+				else if (is_punctuation(token, ",") && enum_paren_depth == 0)
+					expects_enumerator = true;
+				else if (expects_enumerator && token.kind == Token::kKind_Identifier)
+				{
+					add_symbol(token.text, SourceSymbols::kSymbolKind_Enumerator, std::string(), token.line);
+					expects_enumerator = false;
+				}
+				
+				return;
+			}
+			
+			if (other_depth != 0)
+				return;
+			
+			if (is_punctuation(token, ";"))
+			{
+				if (is_statement_processed == false)
+					process_declaration(statement, false);
+				
+				statement.clear();
+				is_statement_processed = false;
+				statement_has_body = false;
+				return;
+			}
+			
+			statement.push_back(token);
+		}
+	};
+	
+	bool SourceSymbols::scan(const char * filename)
+	{
+		std::vector<char> contents;
+		
+		if (!read_file(filename, contents))
+			return false;
+		
+		contents.push_back(0);
+		
+		scan_text(contents.data());
+		
+		return true;
+	}
+	
+	void SourceSymbols::scan_text(const char * text)
+	{
+		symbols.clear();
+		macro_directives.clear();
+		identifiers.clear();
+		
+		Lexer lexer;
+		lexer.p = text;
+		lexer.symbols = this;
+		
+		DeclarationParser parser;
+		parser.symbols = this;
+		
+		Token token;
+		
+		while (lexer.next(token))
+			parser.add_token(token);
+	}
+	
+	static bool symbols_conflict(const SourceSymbols::Symbol & a, const SourceSymbols::Symbol & b)
+	{
+		if (a.is_local == false && b.is_local == false)
+			return false;
+		
+		// note : functions with different parameter types are overloads, and identical type aliases may be
+		//        declared more than once
+		
+		if (a.kind == SourceSymbols::kSymbolKind_Function && b.kind == SourceSymbols::kSymbolKind_Function)
+			return a.signature == b.signature;
+		
+		if (a.kind == SourceSymbols::kSymbolKind_TypeAlias && b.kind == SourceSymbols::kSymbolKind_TypeAlias)
+			return a.signature.empty() || a.signature != b.signature;
+		
+		return true;
+	}
+	
+	static const char * get_symbol_kind_name(const SourceSymbols::SymbolKind kind)
+	{
+		switch (kind)
+		{
+		case SourceSymbols::kSymbolKind_Function:
+			return "function";
+		case SourceSymbols::kSymbolKind_Variable:
+			return "variable";
+		case SourceSymbols::kSymbolKind_Type:
+			return "type";
+		case SourceSymbols::kSymbolKind_TypeAlias:
+			return "type alias";
+		case SourceSymbols::kSymbolKind_Enumerator:
+			return "enumerator";
+		}
+		
+		return "symbol";
+	}
+	
+	void find_conglomerate_conflicts(const std::vector<const SourceSymbols*> & files, std::vector<ConglomerateConflict> & conflicts)
+	{
+		struct Definition
+		{
+			size_t file_index;
+			const SourceSymbols::Symbol * symbol;
+		};
+		
+		struct MacroDefinition
+		{
+			size_t file_index;
+			const SourceSymbols::MacroDirective * macro_directive;
+		};
+		
+		std::multimap<std::string, Definition> definitions;
+		
+		std::map<std::string, MacroDefinition> macro_definitions; // the macros which are defined at the end of the files seen so far
+		
+		for (size_t file_index = 0; file_index < files.size(); ++file_index)
+		{
+			const SourceSymbols & file = *files[file_index];
+			
+			// symbols
+			
+			std::multimap<std::string, Definition> file_definitions;
+			
+			for (auto & symbol : file.symbols)
+			{
+				// note : a file may declare a function before defining it
+				
+				bool is_redeclaration = false;
+				
+				auto range = file_definitions.equal_range(symbol.name);
+				
+				for (auto itr = range.first; itr != range.second; ++itr)
+					if (itr->second.symbol->kind == symbol.kind && itr->second.symbol->signature == symbol.signature)
+						is_redeclaration = true;
+				
+				if (is_redeclaration)
+					continue;
+				
+				file_definitions.insert(std::make_pair(symbol.name, Definition { file_index, &symbol }));
+				
+				range = definitions.equal_range(symbol.name);
+				
+				for (auto itr = range.first; itr != range.second; ++itr)
+				{
+					if (symbols_conflict(*itr->second.symbol, symbol))
+					{
+						ConglomerateConflict conflict;
+						conflict.file_index = file_index;
+						conflict.line = symbol.line;
+						conflict.other_file_index = itr->second.file_index;
+						conflict.other_line = itr->second.symbol->line;
+						conflict.description = std::string(get_symbol_kind_name(symbol.kind)) + " '" + symbol.name + "' conflicts with the " + get_symbol_kind_name(itr->second.symbol->kind) + " defined by";
+						conflicts.push_back(conflict);
+						break;
+					}
+				}
+			}
+			
+			definitions.insert(file_definitions.begin(), file_definitions.end());
+			
+			// macros leaking from earlier files. they may be redefined differently, or change the meaning of code
+			// which uses the same name
+			
+			std::map<std::string, const SourceSymbols::MacroDirective*> first_directives;
+			
+			for (auto & macro_directive : file.macro_directives)
+			{
+				first_directives.insert(std::make_pair(macro_directive.name, &macro_directive));
+				
+				if (macro_directive.is_undef || macro_directive.is_guarded)
+					continue;
+				
+				auto macro_definition_itr = macro_definitions.find(macro_directive.name);
+				
+				if (macro_definition_itr == macro_definitions.end() ||
+					macro_definition_itr->second.file_index == file_index ||
+					macro_definition_itr->second.macro_directive->definition == macro_directive.definition)
+				{
+					continue;
+				}
+				
+				ConglomerateConflict conflict;
+				conflict.file_index = file_index;
+				conflict.line = macro_directive.line;
+				conflict.other_file_index = macro_definition_itr->second.file_index;
+				conflict.other_line = macro_definition_itr->second.macro_directive->line;
+				conflict.description = "macro '" + macro_directive.name + "' is redefined differently. it was previously defined by";
+				conflicts.push_back(conflict);
+			}
+			
+			for (auto & macro_definition_itr : macro_definitions)
+			{
+				auto & name = macro_definition_itr.first;
+				
+				// note : guarded definitions are usually a fallback for a macro defined elsewhere, such as by a
+				//        system header. using the name is likely intended to refer to the same macro
+				
+				if (macro_definition_itr.second.macro_directive->is_guarded)
+					continue;
+				
+				auto identifier_itr = file.identifiers.find(name);
+				
+				if (identifier_itr == file.identifiers.end())
+					continue;
+				
+				// note : the file may define or undefine the macro itself before using it. a guarded definition
+				//        tests whether the macro is defined right before it, so it's fine to use it that way
+				
+				auto first_directive_itr = first_directives.find(name);
+				
+				if (first_directive_itr != first_directives.end() &&
+					(first_directive_itr->second->line <= identifier_itr->second || first_directive_itr->second->is_guarded))
+				{
+					continue;
+				}
+				
+				ConglomerateConflict conflict;
+				conflict.file_index = file_index;
+				conflict.line = identifier_itr->second;
+				conflict.other_file_index = macro_definition_itr.second.file_index;
+				conflict.other_line = macro_definition_itr.second.macro_directive->line;
+				conflict.description = "'" + name + "' refers to the macro defined by";
+				conflicts.push_back(conflict);
+			}
+			
+			for (auto & macro_directive : file.macro_directives)
+			{
+				if (macro_directive.is_undef)
+					macro_definitions.erase(macro_directive.name);
+				else if (macro_directive.is_guarded == false || macro_definitions.count(macro_directive.name) == 0)
+					macro_definitions[macro_directive.name] = MacroDefinition { file_index, &macro_directive };
+			}
+		}
+	}
+}
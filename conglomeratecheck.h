@@ -0,0 +1,68 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace chibi
+{
+	/**
+	 * The names a source file defines which may collide with those of other source files once they are included into
+	 * the same conglomerate. The file is read using a lightweight lexer, so no compiler is needed. Header files
+	 * included by the source file aren't followed.
+	 */
+	struct SourceSymbols
+	{
+		enum SymbolKind
+		{
+			kSymbolKind_Function,
+			kSymbolKind_Variable,
+			kSymbolKind_Type,        // a class, struct, union or enum definition
+			kSymbolKind_TypeAlias,   // a typedef or alias declaration
+			kSymbolKind_Enumerator   // an enumerator of an unscoped enum
+		};
+		
+		struct Symbol
+		{
+			std::string name; // the name, qualified by the namespaces it's defined in
+			SymbolKind kind = kSymbolKind_Variable;
+			std::string signature; // the parameter types for functions, and the aliased type for type aliases
+			bool is_local = true; // false for functions and variables with external linkage
+			int line = 0;
+		};
+		
+		struct MacroDirective
+		{
+			std::string name;
+			std::string definition; // the parameters and replacement list, with whitespace normalized
+			bool is_undef = false;
+			bool is_guarded = false; // defined only when not defined yet, using #ifndef
+			int line = 0;
+		};
+		
+		std::vector<Symbol> symbols; // the symbols defined at namespace scope
+		std::vector<MacroDirective> macro_directives; // the #define and #undef directives, in order
+		std::map<std::string, int> identifiers; // the first line each identifier is used on, including preprocessor conditions
+		
+		bool scan(const char * filename);
+		
+		void scan_text(const char * text);
+	};
+	
+	struct ConglomerateConflict
+	{
+		size_t file_index = 0; // the index of the file causing the conflict
+		int line = 0;
+		
+		size_t other_file_index = 0; // the index of the earlier file it conflicts with
+		int other_line = 0;
+		
+		std::string description;
+	};
+	
+	/**
+	 * Finds the symbols and macros which collide when the given files are included into a single conglomerate, in the
+	 * given order. A conflict is reported at the later of the two files involved.
+	 */
+	void find_conglomerate_conflicts(const std::vector<const SourceSymbols*> & files, std::vector<ConglomerateConflict> & conflicts);
+}
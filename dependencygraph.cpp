@@ -0,0 +1,257 @@
+#include "chibi-internal.h"
+#include "dependencygraph.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+
+#if defined(__GNUC__)
+	#define vsprintf_s(s, ss, f, a) vsnprintf(s, ss, f, a)
+#endif
+
+static void report_error(const char * format, ...)
+{
+	char text[1024];
+	va_list ap;
+	va_start(ap, format);
+	vsprintf_s(text, sizeof(text), format, ap);
+	va_end(ap);
+	
+	//
+	
+	printf("error: %s\n", text);
+}
+
+namespace chibi
+{
+	void DependencyGraph::build(const ChibiInfo & chibi_info)
+	{
+		const int num_libraries = (int)chibi_info.libraries.size();
+		
+		nodes.clear();
+		nodes.resize(num_libraries);
+		
+		all_library_dependencies_once.reset(new std::once_flag[num_libraries]);
+		
+		all_library_dependencies.clear();
+		all_library_dependencies.resize(num_libraries);
+		
+		// assign name ids. dependencies are identified by name, so external libraries get an id as well
+		
+		std::unordered_map<std::string, int> name_ids;
+		
+		for (auto * library : chibi_info.libraries)
+			name_ids[library->name] = library->id;
+		
+		num_names = num_libraries;
+		
+		for (auto * library : chibi_info.libraries)
+		{
+			Node & node = nodes[library->id];
+			
+			node.library = library;
+			
+			for (auto & library_dependency : library->library_dependencies)
+			{
+				auto i = name_ids.find(library_dependency.name);
+				
+				if (i == name_ids.end())
+					i = name_ids.insert(std::make_pair(library_dependency.name, num_names++)).first;
+				
+				node.dependency_name_ids.push_back(i->second);
+			}
+		}
+		
+		// visit the libraries depth-first, to detect cycles and to sort the libraries so they come after their dependencies
+		
+		enum State
+		{
+			kState_Unvisited,
+			kState_Visiting,
+			kState_Visited
+		};
+		
+		struct StackItem
+		{
+			int id;
+			size_t dependency_index;
+		};
+		
+		std::vector<State> states(num_libraries, kState_Unvisited);
+		
+		std::vector<StackItem> stack;
+		
+		std::vector<int> sorted_ids;
+		sorted_ids.reserve(num_libraries);
+		
+		has_cycles = false;
+		
+		for (int root_id = 0; root_id < num_libraries; ++root_id)
+		{
+			if (states[root_id] != kState_Unvisited)
+				continue;
+			
+			states[root_id] = kState_Visiting;
+			stack.push_back({ root_id, 0 });
+			
+			while (stack.empty() == false)
+			{
+				StackItem & item = stack.back();
+				
+				auto & library_dependencies = nodes[item.id].library->library_dependencies;
+				
+				if (item.dependency_index == library_dependencies.size())
+				{
+					states[item.id] = kState_Visited;
+					sorted_ids.push_back(item.id);
+					stack.pop_back();
+					continue;
+				}
+				
+				const ChibiLibrary * dependency = library_dependencies[item.dependency_index++].library;
+				
+				if (dependency == nullptr)
+					continue;
+				
+				if (states[dependency->id] == kState_Unvisited)
+				{
+					states[dependency->id] = kState_Visiting;
+					stack.push_back({ dependency->id, 0 });
+				}
+				else if (states[dependency->id] == kState_Visiting)
+				{
+					// the dependency is on the stack. the part of the stack starting at the dependency forms a cycle
+					
+					std::string path;
+					
+					bool in_cycle = false;
+					
+					for (auto & cycle_item : stack)
+					{
+						if (cycle_item.id == dependency->id)
+							in_cycle = true;
+						
+						if (in_cycle)
+						{
+							path.append(nodes[cycle_item.id].library->name);
+							path.append(" -> ");
+						}
+					}
+					
+					path.append(dependency->name);
+					
+					printf("warning: dependency cycle: %s\n", path.c_str());
+					
+					has_cycles = true;
+				}
+			}
+		}
+		
+		// compute levels and closures. dependencies come before the libraries depending on them, except when they
+		// are part of a cycle. in that case we repeat until the closures no longer change
+		
+		for (auto id : sorted_ids)
+		{
+			Node & node = nodes[id];
+			
+			node.closure.resize(num_libraries);
+			
+			for (auto & library_dependency : node.library->library_dependencies)
+			{
+				if (library_dependency.library != nullptr && node.level < nodes[library_dependency.library->id].level + 1)
+					node.level = nodes[library_dependency.library->id].level + 1;
+			}
+		}
+		
+		for (;;)
+		{
+			bool changed = false;
+			
+			for (auto id : sorted_ids)
+			{
+				Node & node = nodes[id];
+				
+				for (auto & library_dependency : node.library->library_dependencies)
+				{
+					const ChibiLibrary * dependency = library_dependency.library;
+					
+					if (dependency == nullptr)
+						continue;
+					
+					if (node.closure.contains(dependency->id) == false)
+					{
+						node.closure.insert(dependency->id);
+						changed = true;
+					}
+					
+					if (node.closure.insert(nodes[dependency->id].closure))
+						changed = true;
+				}
+			}
+			
+			if (has_cycles == false || changed == false)
+				break;
+		}
+	}
+	
+	const std::vector<const ChibiLibraryDependency*> * DependencyGraph::get_all_library_dependencies(const ChibiLibrary & library) const
+	{
+		// note : the writers ask for the dependencies of many libraries concurrently. only threads asking for the same
+		//        library wait for each other
+		
+		std::call_once(all_library_dependencies_once[library.id], [&]()
+			{
+				all_library_dependencies[library.id] = compute_all_library_dependencies(library);
+			});
+		
+		return all_library_dependencies[library.id].get();
+	}
+	
+	std::unique_ptr<std::vector<const ChibiLibraryDependency*>> DependencyGraph::compute_all_library_dependencies(const ChibiLibrary & library) const
+	{
+		std::unique_ptr<std::vector<const ChibiLibraryDependency*>> library_dependencies(new std::vector<const ChibiLibraryDependency*>());
+		
+		// visit the libraries breadth-first, listing each dependency (by name) only once
+		
+		std::vector<bool> traversed_names(num_names, false);
+		
+		std::vector<int> queue;
+		
+		queue.push_back(library.id);
+		
+		traversed_names[library.id] = true;
+		
+		for (size_t queue_index = 0; queue_index < queue.size(); ++queue_index)
+		{
+			const Node & node = nodes[queue[queue_index]];
+			
+			for (size_t i = 0; i < node.dependency_name_ids.size(); ++i)
+			{
+				const int name_id = node.dependency_name_ids[i];
+				
+				if (traversed_names[name_id])
+					continue;
+				
+				traversed_names[name_id] = true;
+				
+				auto & library_dependency = node.library->library_dependencies[i];
+				
+				library_dependencies->push_back(&library_dependency);
+				
+				if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
+				{
+					if (library_dependency.library == nullptr)
+					{
+						report_error("failed to resolve library dependency: %s for library %s", library_dependency.name.c_str(), node.library->name.c_str());
+						return nullptr;
+					}
+					
+					queue.push_back(library_dependency.library->id);
+				}
+			}
+		}
+		
+		return library_dependencies;
+	}
+}
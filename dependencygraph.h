@@ -0,0 +1,94 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+struct ChibiInfo;
+struct ChibiLibrary;
+struct ChibiLibraryDependency;
+
+namespace chibi
+{
+	/**
+	 * A set of library ids, stored as one bit per library.
+	 */
+	struct LibrarySet
+	{
+		std::vector<uint64_t> bits;
+		
+		void resize(const int num_libraries)
+		{
+			bits.resize((num_libraries + 63) / 64);
+		}
+		
+		bool contains(const int id) const
+		{
+			return (bits[id >> 6] >> (id & 63)) & 1;
+		}
+		
+		void insert(const int id)
+		{
+			bits[id >> 6] |= uint64_t(1) << (id & 63);
+		}
+		
+		// adds all of the libraries in the other set. returns true when the set changed
+		bool insert(const LibrarySet & other)
+		{
+			uint64_t changed = 0;
+			
+			for (size_t i = 0; i < bits.size(); ++i)
+			{
+				const uint64_t new_bits = bits[i] | other.bits[i];
+				changed |= new_bits ^ bits[i];
+				bits[i] = new_bits;
+			}
+			
+			return changed != 0;
+		}
+	};
+
+	/**
+	 * The graph of dependencies between the libraries and apps in the workspace. It is built once after parsing,
+	 * using the library ids as node ids, so later passes can query dependencies without looking up libraries by name.
+	 */
+	struct DependencyGraph
+	{
+		struct Node
+		{
+			const ChibiLibrary * library = nullptr;
+			
+			std::vector<int> dependency_name_ids; // the name id of each of the library's dependencies, in the order in which they were declared
+			
+			int level = 0; // zero for libraries without dependencies, otherwise one more than the highest level of the libraries it depends on
+			
+			LibrarySet closure; // all of the libraries this library depends on, directly or indirectly
+		};
+		
+		std::vector<Node> nodes;
+		
+		int num_names = 0; // library names followed by the names of external libraries. libraries use their id as the name id
+		
+		bool has_cycles = false;
+		
+		mutable std::unique_ptr<std::once_flag[]> all_library_dependencies_once; // by library id. each list is computed once, without blocking the threads asking for other libraries
+		
+		mutable std::vector<std::unique_ptr<std::vector<const ChibiLibraryDependency*>>> all_library_dependencies; // by library id, filled in on demand. null when a dependency couldn't be resolved
+		
+		/**
+		 * Builds the graph. Reports a warning with the path of each dependency cycle found.
+		 */
+		void build(const ChibiInfo & chibi_info);
+		
+		/**
+		 * Returns all of the direct and indirect dependencies of the given library, in breadth-first order, with
+		 * each dependency listed only once. The result is computed once per library and may be shared between threads.
+		 * Returns null when a library dependency could not be resolved.
+		 */
+		const std::vector<const ChibiLibraryDependency*> * get_all_library_dependencies(const ChibiLibrary & library) const;
+		
+	private:
+		std::unique_ptr<std::vector<const ChibiLibraryDependency*>> compute_all_library_dependencies(const ChibiLibrary & library) const;
+	};
+}
@@ -1,11 +1,18 @@
+#include "binaryio.h"
 #include "filesystem.h"
 #include "stringhelpers.h"
+#include "threadpool.h"
+#include <chrono>
+#include <errno.h>
+#include <memory>
 #include <string.h>
+#include <sys/stat.h>
 
 using namespace chibi;
 
 #ifndef _MSC_VER
 	#include <dirent.h>
+	#include <fcntl.h> // AT_SYMLINK_NOFOLLOW
 #endif
 
 #ifdef _MSC_VER
@@ -15,44 +22,6 @@ using namespace chibi;
 	#ifndef PATH_MAX
 		#define PATH_MAX _MAX_PATH
 	#endif
-	typedef SSIZE_T ssize_t;
-	static ssize_t getline(char ** _line, size_t * _line_size, FILE * file)
-	{
-		char *& line = *_line;
-		size_t & line_size = *_line_size;
-
-		if (line == nullptr)
-		{
-			line_size = 32;
-			line = (char*)malloc(line_size);
-		}
-
-		for (;;)
-		{
-			auto pos = ftell(file);
-
-			const char * r = fgets(line, (int)line_size, file);
-
-			if (r == nullptr)
-				break;
-
-			const size_t length = strlen(line);
-
-			if (length + 1 == line_size)
-			{
-				free(line);
-
-				line_size *= 2;
-				line = (char*)malloc(line_size);
-
-				fseek(file, pos, SEEK_SET);
-			}
-			else
-				return length;
-		}
-
-		return -1;
-	}
 #else
     #include <stdio.h>
 	#include <unistd.h>
@@ -60,10 +29,11 @@ using namespace chibi;
 
 namespace chibi_filesystem
 {
-	std::vector<std::string> listFiles(const char * path, bool recurse)
+	// invokes the callback for each entry of a single directory, excluding '.' and '..'
+	template <typename F>
+	static void for_each_directory_entry(const char * path, F && callback)
 	{
 	#ifdef WIN32
-		std::vector<std::string> result;
 		WIN32_FIND_DATAA ffd;
 		char wildcard[MAX_PATH];
 		sprintf_s(wildcard, sizeof(wildcard), "%s\\*", path);
@@ -72,128 +42,683 @@ namespace chibi_filesystem
 		{
 			do
 			{
-				char fullPath[MAX_PATH];
-				if (strcmp(path, "."))
-					concat(fullPath, sizeof(fullPath), path, "/", ffd.cFileName);
-				else
-					concat(fullPath, sizeof(fullPath), ffd.cFileName);
-
-				if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				{
-					if (recurse && strcmp(ffd.cFileName, ".") && strcmp(ffd.cFileName, ".."))
-					{
-						std::vector<std::string> subResult = listFiles(fullPath, recurse);
-						result.insert(result.end(), subResult.begin(), subResult.end());
-					}
-				}
-				else
-				{
-					result.push_back(fullPath);
-				}
+				if (!strcmp(ffd.cFileName, ".") || !strcmp(ffd.cFileName, ".."))
+					continue;
+				
+				callback(ffd.cFileName, (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
 			} while (FindNextFileA(find, &ffd) != 0);
 
 			FindClose(find);
 		}
-		return result;
 	#else
-		std::vector<std::string> result;
+		DIR * dir = opendir(path);
 		
-		std::vector<DIR*> dirs;
+		if (dir != nullptr)
 		{
-			DIR * dir = opendir(path);
-			if (dir)
-				dirs.push_back(dir);
-		}
-		
-		while (!dirs.empty())
-		{
-			DIR * dir = dirs.back();
-			dirs.pop_back();
-			
 			dirent * ent;
 			
 			while ((ent = readdir(dir)) != 0)
 			{
-				char fullPath[PATH_MAX];
-				if (strcmp(path, "."))
-					concat(fullPath, sizeof(fullPath), path, "/", ent->d_name);
-				else
-					concat(fullPath, sizeof(fullPath), ent->d_name);
+				if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+					continue;
 				
-				if (ent->d_type == DT_DIR)
-				{
-					if (recurse && strcmp(ent->d_name, ".") && strcmp(ent->d_name, ".."))
-					{
-						std::vector<std::string> subResult = listFiles(fullPath, recurse);
-						result.insert(result.end(), subResult.begin(), subResult.end());
-					}
-				}
-				else
+				bool is_directory = ent->d_type == DT_DIR;
+				
+				if (ent->d_type == DT_UNKNOWN)
 				{
-					result.push_back(fullPath);
+					// some file systems don't report the file type. fall back to stat in this case
+					
+					struct stat s;
+					
+					if (fstatat(dirfd(dir), ent->d_name, &s, AT_SYMLINK_NOFOLLOW) == 0)
+						is_directory = S_ISDIR(s.st_mode);
 				}
+				
+				callback(ent->d_name, is_directory);
 			}
 			
 			closedir(dir);
 		}
-		return result;
 	#endif
 	}
+	
+	static void read_directory(const char * path, std::vector<DirectoryCache::Entry> & entries)
+	{
+		for_each_directory_entry(path, [&](const char * name, const bool is_directory)
+			{
+				DirectoryCache::Entry entry;
+				entry.name = name;
+				entry.is_directory = is_directory;
+				entries.push_back(entry);
+			});
+	}
 
-	//
+	/**
+	 * A simple bump allocator. Memory is released all at once when the arena is destroyed.
+	 */
+	struct Arena
+	{
+		static const size_t kBlockSize = 64 * 1024;
+		
+		std::vector<std::unique_ptr<char[]>> blocks;
+		
+		char * ptr = nullptr;
+		size_t remaining = 0;
+		
+		void * alloc(const size_t size)
+		{
+			const size_t alignment = sizeof(void*);
+			const size_t padding = (alignment - (uintptr_t)ptr % alignment) % alignment;
+			
+			if (ptr == nullptr || padding + size > remaining)
+			{
+				const size_t block_size = size > kBlockSize ? size : kBlockSize;
+				
+				blocks.emplace_back(new char[block_size]);
+				
+				ptr = blocks.back().get();
+				remaining = block_size;
+				
+				return alloc(size);
+			}
+			
+			void * result = ptr + padding;
+			
+			ptr += padding + size;
+			remaining -= padding + size;
+			
+			return result;
+		}
+		
+		template <typename T>
+		T * alloc_array(const size_t count)
+		{
+			return (T*)alloc(sizeof(T) * count);
+		}
+		
+		const char * copy_string(const char * text)
+		{
+			const size_t size = strlen(text) + 1;
+			
+			char * result = (char*)alloc(size);
+			memcpy(result, text, size);
+			
+			return result;
+		}
+	};
 
-	bool write_if_different(const char * text, const char * filename)
+	/**
+	 * Walks a directory tree in parallel. Each directory is read by a separate task, and subdirectories are
+	 * walked by new tasks, which idle threads steal from the thread which found them. The directory entries are
+	 * stored in arenas. The results are flattened into a list of files in a single pass when done, in the same
+	 * (depth-first) order as a sequential walk would produce.
+	 */
+	struct DirectoryWalker
 	{
-		FileHandle existing_file(filename, "rt");
+		struct Node;
 		
-		bool is_equal = false;
+		struct Item
+		{
+			const char * name;
+			
+			bool is_directory;
+			
+			Node * subdirectory; // set for directories when recursing
+		};
 		
-		if (existing_file != nullptr)
+		struct Node
 		{
-			std::string existing_text;
+			const char * path;
 			
-			char * line = nullptr;
-			size_t line_size = 0;
+			Item * items;
+			int num_items;
+		};
+		
+		bool recurse = false;
+		
+		DirectoryCache * cache = nullptr;
+		
+		TaskGroup task_group;
+		
+		std::mutex arena_mutex;
+		std::vector<std::unique_ptr<Arena>> arenas;
+		std::vector<Arena*> free_arenas;
+		
+		Arena * acquire_arena()
+		{
+			std::lock_guard<std::mutex> lock(arena_mutex);
 			
-			for (;;)
+			if (free_arenas.empty())
+			{
+				arenas.emplace_back(new Arena());
+				
+				return arenas.back().get();
+			}
+			else
 			{
-				const ssize_t r = getline(&line, &line_size, existing_file);
+				Arena * arena = free_arenas.back();
+				free_arenas.pop_back();
 				
-				if (r < 0)
-					break;
+				return arena;
+			}
+		}
+		
+		void release_arena(Arena * arena)
+		{
+			std::lock_guard<std::mutex> lock(arena_mutex);
+			
+			free_arenas.push_back(arena);
+		}
+		
+		Node * create_node(Arena & arena, const char * path)
+		{
+			Node * node = arena.alloc_array<Node>(1);
+			node->path = arena.copy_string(path);
+			node->items = nullptr;
+			node->num_items = 0;
+			
+			return node;
+		}
+		
+		void walk(Node * node)
+		{
+			Arena * arena = acquire_arena();
+			
+			std::vector<Item> items;
+			
+			if (cache != nullptr)
+			{
+				// note : listings in the cache remain valid for as long as the cache exists, so we can point directly to their names
 				
-				existing_text.append(line);
+				for (auto & entry : cache->get_directory(node->path).entries)
+					items.push_back({ entry.name.c_str(), entry.is_directory, nullptr });
+			}
+			else
+			{
+				for_each_directory_entry(node->path, [&](const char * name, const bool is_directory)
+					{
+						items.push_back({ arena->copy_string(name), is_directory, nullptr });
+					});
 			}
 			
-			free(line);
-			line = nullptr;
+			node->items = arena->alloc_array<Item>(items.size());
+			node->num_items = (int)items.size();
 			
-			if (text == existing_text)
-				is_equal = true;
+			for (size_t i = 0; i < items.size(); ++i)
+			{
+				Item & item = node->items[i];
+				
+				item = items[i];
+				
+				if (item.is_directory && recurse)
+				{
+					char path[PATH_MAX];
+					if (strcmp(node->path, "."))
+						concat(path, sizeof(path), node->path, "/", item.name);
+					else
+						concat(path, sizeof(path), item.name);
+					
+					Node * subdirectory = create_node(*arena, path);
+					
+					item.subdirectory = subdirectory;
+					
+					task_group.add([this, subdirectory]()
+						{
+							walk(subdirectory);
+						});
+				}
+			}
 			
-			existing_file.close();
+			release_arena(arena);
 		}
 		
-		if (is_equal)
+		void flatten(const Node * node, std::vector<std::string> & result, std::vector<std::string> * directories) const
 		{
-			return true;
+			if (directories != nullptr)
+				directories->push_back(node->path);
+			
+			for (int i = 0; i < node->num_items; ++i)
+			{
+				const Item & item = node->items[i];
+				
+				if (item.subdirectory != nullptr)
+				{
+					flatten(item.subdirectory, result, directories);
+				}
+				else if (item.is_directory == false)
+				{
+					char path[PATH_MAX];
+					if (strcmp(node->path, "."))
+						concat(path, sizeof(path), node->path, "/", item.name);
+					else
+						concat(path, sizeof(path), item.name);
+					
+					result.push_back(path);
+				}
+			}
 		}
-		else
+	};
+
+	std::vector<std::string> listFiles(const char * path, bool recurse, DirectoryCache * cache, std::vector<std::string> * directories)
+	{
+		DirectoryWalker walker;
+		walker.recurse = recurse;
+		walker.cache = cache;
+		
+		Arena arena;
+		
+		DirectoryWalker::Node * root = walker.create_node(arena, path);
+		
+		walker.walk(root);
+		
+		walker.task_group.wait();
+		
+		std::vector<std::string> result;
+		
+		walker.flatten(root, result, directories);
+		
+		return result;
+	}
+
+	//
+
+	// note : bump the version whenever the layout of the cache file changes
+	
+	static const char kDirectoryCacheMagic[8] = { 'c', 'h', 'i', 'b', 'i', 'd', 'c', 0 };
+	static const int32_t kDirectoryCacheVersion = 1;
+	
+	// directories modified less than this many nanoseconds before they were read may be modified again without their
+	// modification time changing, due to the limited resolution of file system timestamps. we don't save their listing
+	static const int64_t kRacyDirectoryInterval = 2000000000ll;
+	
+	static const int64_t kRacyDirectoryMtime = -2;
+	
+	bool DirectoryCache::load(const char * filename)
+	{
+		directories.clear();
+		
+		std::vector<char> contents;
+		
+		if (!read_file(filename, contents))
+			return false;
+		
+		BinaryReader reader(contents.data(), contents.size());
+		
+		char magic[sizeof(kDirectoryCacheMagic)];
+		
+		if (!reader.read_bytes(magic, sizeof(magic)) || memcmp(magic, kDirectoryCacheMagic, sizeof(magic)) != 0)
+			return false;
+		
+		if (reader.read_int32() != kDirectoryCacheVersion)
+			return false;
+		
+		const int32_t num_directories = reader.read_count();
+		
+		for (int32_t i = 0; i < num_directories && reader.error == false; ++i)
 		{
-			FileHandle file(filename, "wt");
+			std::string path;
+			reader.read_string(path);
+			
+			Directory & directory = directories[path];
+			
+			directory.mtime = reader.read_int64();
 			
-			if (file == nullptr)
+			directory.entries.resize(reader.read_count());
+			
+			for (auto & entry : directory.entries)
 			{
-				return false;
+				reader.read_string(entry.name);
+				entry.is_directory = reader.read_bool();
 			}
-			else
+		}
+		
+		if (reader.error)
+		{
+			directories.clear();
+			return false;
+		}
+		
+		return true;
+	}
+	
+	bool DirectoryCache::save(const char * filename) const
+	{
+		// note : we save the directories not visited during the current run as well. they are likely still scanned
+		//        by chibi files which were reused from the parse cache
+		
+		BinaryWriter writer;
+		
+		writer.write_bytes(kDirectoryCacheMagic, sizeof(kDirectoryCacheMagic));
+		writer.write_int32(kDirectoryCacheVersion);
+		writer.write_int32((int32_t)directories.size());
+		
+		for (auto & directory_itr : directories)
+		{
+			auto & directory = directory_itr.second;
+			
+			writer.write_string(directory_itr.first);
+			writer.write_int64(directory.mtime);
+			
+			writer.write_int32((int32_t)directory.entries.size());
+			
+			for (auto & entry : directory.entries)
+			{
+				writer.write_string(entry.name);
+				writer.write_bool(entry.is_directory);
+			}
+		}
+		
+		return write_file_atomically(filename, writer.data.data(), writer.data.size());
+	}
+	
+	const DirectoryCache::Directory & DirectoryCache::get_directory(const char * path)
+	{
+		// note : we check the modification time and read directories without holding the lock, so other threads
+		//        can look up directories in the mean time
+		
+		bool is_cached = false;
+		
+		int64_t cached_mtime = -1;
+		
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			auto i = directories.find(path);
+			
+			if (i != directories.end())
 			{
-				fprintf(file, "%s", text);
+				// the listing was already checked or read during the current run
 				
-				file.close();
+				if (i->second.is_valid)
+				{
+					num_hits++;
+					return i->second;
+				}
 				
-				return true;
+				is_cached = true;
+				cached_mtime = i->second.mtime;
 			}
 		}
+		
+		int64_t mtime;
+		int64_t size;
+		
+		if (!get_file_info(path, mtime, size))
+			mtime = -1;
+		
+		const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		
+		if (mtime >= 0 && mtime > now - kRacyDirectoryInterval)
+			mtime = kRacyDirectoryMtime;
+		
+		const bool is_hit =
+			is_cached &&
+			mtime != kRacyDirectoryMtime &&
+			mtime == cached_mtime;
+		
+		std::vector<Entry> entries;
+		
+		if (is_hit == false)
+			read_directory(path, entries);
+		
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		Directory & directory = directories[path];
+		
+		if (directory.is_valid)
+		{
+			// another thread got here first
+			
+			num_hits++;
+			return directory;
+		}
+		
+		if (is_hit)
+			num_hits++;
+		else
+		{
+			if (is_cached == false)
+				num_misses++;
+			else
+				num_rereads++;
+			
+			directory.mtime = mtime;
+			directory.entries = std::move(entries);
+		}
+		
+		directory.is_valid = true;
+		
+		return directory;
+	}
+
+	bool get_file_info(const char * path, int64_t & mtime, int64_t & size)
+	{
+	#if defined(_MSC_VER)
+		struct __stat64 s;
+		if (_stat64(path, &s) != 0)
+			return false;
+		mtime = int64_t(s.st_mtime) * 1000000000;
+	#else
+		struct stat s;
+		if (stat(path, &s) != 0)
+			return false;
+		#if defined(MACOS)
+			mtime = int64_t(s.st_mtimespec.tv_sec) * 1000000000 + s.st_mtimespec.tv_nsec;
+		#else
+			mtime = int64_t(s.st_mtim.tv_sec) * 1000000000 + s.st_mtim.tv_nsec;
+		#endif
+	#endif
+		size = int64_t(s.st_size);
+		return true;
+	}
+
+	bool create_directory(const char * path)
+	{
+	#if defined(_MSC_VER)
+		if (_mkdir(path) != 0 && errno != EEXIST)
+			return false;
+	#else
+		if (mkdir(path, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 && errno != EEXIST)
+			return false;
+	#endif
+		
+		return true;
+	}
+	
+	bool create_directories(const char * path)
+	{
+		if (create_directory(path))
+			return true;
+		
+		if (errno != ENOENT)
+			return false;
+		
+		// create the parent directory first and try again
+		
+		char parent_path[PATH_MAX];
+		if (!get_path_from_filename(path, parent_path, sizeof(parent_path)) || parent_path[0] == 0 || !strcmp(parent_path, path))
+			return false;
+		
+		if (!create_directories(parent_path))
+			return false;
+		
+		return create_directory(path);
+	}
+	
+	bool read_file(const char * filename, std::vector<char> & contents)
+	{
+		FileHandle f(filename, "rb");
+		
+		if (f == nullptr)
+			return false;
+		
+	#ifndef _MSC_VER
+		// directories can be opened as files on some systems, but the file size reported for them is bogus
+		
+		struct stat s;
+		
+		if (fstat(fileno(f), &s) != 0 || S_ISREG(s.st_mode) == false)
+			return false;
+	#endif
+		
+		if (fseek(f, 0, SEEK_END) != 0)
+			return false;
+		
+		const long size = ftell(f);
+		
+		if (size < 0 || fseek(f, 0, SEEK_SET) != 0)
+			return false;
+		
+		contents.resize(size);
+		
+		if (fread(contents.data(), 1, size, f) != (size_t)size)
+			return false;
+		
+		return true;
+	}
+	
+	bool write_file_atomically(const char * filename, const void * contents, const size_t size)
+	{
+		const std::string temp_filename = std::string(filename) + ".tmp";
+		
+		FileHandle f(temp_filename.c_str(), "wb");
+		
+		if (f == nullptr)
+			return false;
+		
+		if (fwrite(contents, 1, size, f) != size)
+		{
+			f.close();
+			remove(temp_filename.c_str());
+			return false;
+		}
+		
+		f.close();
+		
+	#if defined(_MSC_VER)
+		// rename doesn't replace existing files on Windows
+		remove(filename);
+	#endif
+		
+		if (rename(temp_filename.c_str(), filename) != 0)
+		{
+			remove(temp_filename.c_str());
+			return false;
+		}
+		
+		return true;
+	}
+
+	//
+
+	static bool file_has_contents(const char * filename, const char * text, const size_t text_size)
+	{
+		// compare the sizes first, so files which changed in size don't need to be read at all
+		
+		int64_t mtime;
+		int64_t size;
+		
+		if (get_file_info(filename, mtime, size) == false || size != (int64_t)text_size)
+			return false;
+		
+		FileHandle f(filename, "rb");
+		
+		if (f == nullptr)
+			return false;
+		
+		// compare the contents in large blocks, stopping at the first difference
+		
+		char buffer[1 << 14];
+		
+		size_t offset = 0;
+		
+		for (;;)
+		{
+			const size_t num_read = fread(buffer, 1, sizeof(buffer), f);
+			
+			if (num_read == 0)
+				break;
+			
+			if (offset + num_read > text_size || memcmp(buffer, text + offset, num_read) != 0)
+				return false;
+			
+			offset += num_read;
+		}
+		
+		return offset == text_size;
+	}
+	
+	bool write_if_different(const char * text, const char * filename)
+	{
+		const size_t text_size = strlen(text);
+		
+		if (file_has_contents(filename, text, text_size))
+		{
+			return true;
+		}
+		else
+		{
+			// replace the file in one go, so tools watching it never see a partially written file
+			
+			return write_file_atomically(filename, text, text_size);
+		}
+	}
+	
+	static bool is_same_file(const char * path1, const char * path2)
+	{
+	#if defined(_MSC_VER)
+		// note : we don't check file identity on Windows. hard links are recognized by having the same contents instead
+		return false;
+	#else
+		struct stat s1;
+		struct stat s2;
+		
+		if (stat(path1, &s1) != 0 || stat(path2, &s2) != 0)
+			return false;
+		
+		return s1.st_dev == s2.st_dev && s1.st_ino == s2.st_ino;
+	#endif
+	}
+	
+	bool link_or_copy_file(const char * src, const char * dst, bool & is_linked)
+	{
+		is_linked = false;
+		
+		if (is_same_file(src, dst))
+		{
+			is_linked = true;
+			return true;
+		}
+		
+		
+		std::vector<char> contents;
+		
+		if (!read_file(src, contents))
+			return false;
+		
+		if (file_has_contents(dst, contents.data(), contents.size()))
+			return true;
+		
+		// try to create a hard link first. this fails when src and dst live on different volumes, or when the
+		// file system doesn't support hard links at all
+		
+		remove(dst);
+		
+	#if defined(_MSC_VER)
+		if (CreateHardLinkA(dst, src, nullptr))
+		{
+			is_linked = true;
+			return true;
+		}
+	#else
+		if (link(src, dst) == 0)
+		{
+			is_linked = true;
+			return true;
+		}
+	#endif
+		
+		return write_file_atomically(dst, contents.data(), contents.size());
 	}
 }
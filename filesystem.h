@@ -1,7 +1,10 @@
 #pragma once
 
+#include <mutex>
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace chibi_filesystem
@@ -37,7 +40,94 @@ namespace chibi_filesystem
 		}
 	};
 
-	std::vector<std::string> listFiles(const char * path, bool recurse);
+	/**
+	 * Stores the listings of directories, so they only need to be read again when their modification time changed.
+	 * The cache is saved in between runs, and may be shared between threads.
+	 */
+	struct DirectoryCache
+	{
+		struct Entry
+		{
+			std::string name;
+			
+			bool is_directory = false;
+		};
+		
+		struct Directory
+		{
+			int64_t mtime = -1;
+			
+			std::vector<Entry> entries;
+			
+			bool is_valid = false; // true when the listing was checked to be up to date during the current run
+		};
+		
+		std::mutex mutex;
+		
+		std::unordered_map<std::string, Directory> directories;
+		
+		int num_hits = 0; // listings which were up to date
+		int num_misses = 0; // directories which were not in the cache yet
+		int num_rereads = 0; // directories read again as their modification time changed
+		
+		bool load(const char * filename);
+		bool save(const char * filename) const;
+		
+		bool has_changes() const
+		{
+			return num_misses != 0 || num_rereads != 0;
+		}
+		
+		/**
+		 * Returns the up to date listing for the given directory. The returned listing remains valid until the cache is destroyed.
+		 */
+		const Directory & get_directory(const char * path);
+	};
+
+	/**
+	 * Lists all of the files inside the given directory, optionally recursing into subdirectories.
+	 * When cache is set, directory listings are looked up in the cache instead of reading the directories each time.
+	 * When directories is set, the paths of all of the directories which were read are added to it.
+	 */
+	std::vector<std::string> listFiles(const char * path, bool recurse, DirectoryCache * cache = nullptr, std::vector<std::string> * directories = nullptr);
+
+	/**
+	 * Retrieves the modification time (in nanoseconds) and size of a file or directory.
+	 * @return False if the file or directory doesn't exist.
+	 */
+	bool get_file_info(const char * path, int64_t & mtime, int64_t & size);
 
+	/**
+	 * Creates a directory. Succeeds when the directory already exists.
+	 */
+	bool create_directory(const char * path);
+
+	/**
+	 * Creates a directory, along with any of its parent directories which don't exist yet.
+	 */
+	bool create_directories(const char * path);
+
+	/**
+	 * Reads the entire contents of a file.
+	 */
+	bool read_file(const char * filename, std::vector<char> & contents);
+
+	/**
+	 * Writes the contents to a temporary file first, and renames it to filename when done. An interrupted
+	 * write never leaves a partially written file behind.
+	 */
+	bool write_file_atomically(const char * filename, const void * contents, const size_t size);
+
+	/**
+	 * Writes the text to a file, unless the file already has the same contents. Leaving the file untouched keeps
+	 * its modification time intact, so build tools don't consider it changed.
+	 */
 	bool write_if_different(const char * text, const char * filename);
+
+	/**
+	 * Makes dst mirror the file at src. A hard link is created when possible, so later changes to src show up in dst
+	 * without copying. Otherwise the file is copied, but only when dst doesn't have the same contents already.
+	 * @param is_linked Set to true when dst is known to be a hard link to src. Copies must be refreshed when src changes.
+	 */
+	bool link_or_copy_file(const char * src, const char * dst, bool & is_linked);
 }
@@ -0,0 +1,125 @@
+#include "binaryio.h"
+#include "filesystem.h"
+#include "fingerprint.h"
+#include <chrono>
+
+using namespace chibi_filesystem;
+
+// note : bump the version whenever the layout of the fingerprint file, or the output generated by chibi changes
+
+static const char kFingerprintMagic[8] = { 'c', 'h', 'i', 'b', 'i', 'f', 'p', 0 };
+static const int32_t kFingerprintVersion = 3;
+
+// inputs modified less than this many nanoseconds before they were read may be modified again without their
+// modification time changing, due to the limited resolution of file system timestamps
+static const int64_t kRacyInputInterval = 2000000000ll;
+
+namespace chibi
+{
+	static int64_t get_mtime(const char * path)
+	{
+		int64_t mtime;
+		int64_t size;
+		
+		if (!get_file_info(path, mtime, size))
+			return -1;
+		
+		return mtime;
+	}
+	
+	bool Fingerprint::load(const char * filename)
+	{
+		arguments.clear();
+		entries.clear();
+		
+		std::vector<char> data;
+		
+		if (!read_file(filename, data))
+			return false;
+		
+		BinaryReader reader(data.data(), data.size());
+		
+		char magic[sizeof(kFingerprintMagic)];
+		
+		if (!reader.read_bytes(magic, sizeof(magic)) || memcmp(magic, kFingerprintMagic, sizeof(magic)) != 0)
+			return false;
+		
+		if (reader.read_int32() != kFingerprintVersion)
+			return false;
+		
+		reader.read_string(arguments);
+		
+		entries.resize(reader.read_count());
+		
+		for (auto & entry : entries)
+		{
+			reader.read_string(entry.path);
+			entry.mtime = reader.read_int64();
+		}
+		
+		if (reader.error)
+		{
+			arguments.clear();
+			entries.clear();
+			return false;
+		}
+		
+		return true;
+	}
+	
+	bool Fingerprint::save(const char * filename) const
+	{
+		BinaryWriter writer;
+		
+		writer.write_bytes(kFingerprintMagic, sizeof(kFingerprintMagic));
+		writer.write_int32(kFingerprintVersion);
+		writer.write_string(arguments);
+		writer.write_int32((int32_t)entries.size());
+		
+		for (auto & entry : entries)
+		{
+			writer.write_string(entry.path);
+			writer.write_int64(entry.mtime);
+		}
+		
+		return write_file_atomically(filename, writer.data.data(), writer.data.size());
+	}
+	
+	bool Fingerprint::is_up_to_date(const std::string & in_arguments) const
+	{
+		if (entries.empty() || arguments != in_arguments)
+			return false;
+		
+		for (auto & entry : entries)
+			if (get_mtime(entry.path.c_str()) != entry.mtime)
+				return false;
+		
+		return true;
+	}
+	
+	bool Fingerprint::add_input(const char * path, const int64_t start_time)
+	{
+		Entry entry;
+		entry.path = path;
+		entry.mtime = get_mtime(path);
+		
+		entries.push_back(entry);
+		
+		return entry.mtime < start_time - kRacyInputInterval;
+	}
+	
+	void Fingerprint::add_output(const char * path)
+	{
+		Entry entry;
+		entry.path = path;
+		entry.mtime = get_mtime(path);
+		
+		entries.push_back(entry);
+	}
+	
+	int64_t get_current_time()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace chibi
+{
+	/**
+	 * A record of everything the output of a run of chibi depends on: the arguments it was invoked with, and the
+	 * modification times of the files and directories it read and wrote. When none of these changed since the
+	 * previous run, the build files are up to date and there is nothing left to do.
+	 */
+	struct Fingerprint
+	{
+		struct Entry
+		{
+			std::string path;
+			
+			int64_t mtime = -1; // -1 when the file or directory didn't exist
+		};
+		
+		std::string arguments;
+		
+		std::vector<Entry> entries;
+		
+		bool load(const char * filename);
+		bool save(const char * filename) const;
+		
+		/**
+		 * Checks whether the fingerprint was recorded using the same arguments, and none of the files and directories
+		 * changed since.
+		 */
+		bool is_up_to_date(const std::string & arguments) const;
+		
+		/**
+		 * Records the current modification time of a file or directory read by chibi.
+		 * @param start_time The time at which chibi started reading its inputs. See get_current_time.
+		 * @return False when the input was modified so shortly before start_time, that a later modification may
+		 * leave its modification time unchanged. The fingerprint can't be trusted and shouldn't be saved in this case.
+		 */
+		bool add_input(const char * path, const int64_t start_time);
+		
+		/**
+		 * Records the current modification time of a file written by chibi.
+		 */
+		void add_output(const char * path);
+	};
+	
+	/**
+	 * Returns the current time in nanoseconds, in the same time base as file modification times.
+	 */
+	int64_t get_current_time();
+}
@@ -0,0 +1,423 @@
+#include "filesystem.h"
+#include "gitindex.h"
+#include "stringhelpers.h"
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+using namespace chibi_filesystem;
+
+static uint32_t read_uint32_be(const uint8_t * bytes)
+{
+	return
+		(uint32_t(bytes[0]) << 24) |
+		(uint32_t(bytes[1]) << 16) |
+		(uint32_t(bytes[2]) << 8) |
+		(uint32_t(bytes[3]) << 0);
+}
+
+static uint16_t read_uint16_be(const uint8_t * bytes)
+{
+	return uint16_t((bytes[0] << 8) | bytes[1]);
+}
+
+static bool is_absolute_path(const std::string & path)
+{
+	return
+		(path.size() >= 1 && path[0] == '/') ||
+		(path.size() >= 2 && path[1] == ':');
+}
+
+namespace chibi
+{
+	bool GitIndex::load(const char * in_index_filename, const int hash_size)
+	{
+		index_filename = in_index_filename;
+		
+		paths.clear();
+		stats.clear();
+		
+		std::vector<char> contents;
+		
+		if (!read_file(in_index_filename, contents))
+			return false;
+		
+		const uint8_t * data = (const uint8_t*)contents.data();
+		const uint8_t * end = data + contents.size();
+		
+		// header
+		
+		if (contents.size() < 12 || memcmp(data, "DIRC", 4) != 0)
+			return false;
+		
+		const uint32_t version = read_uint32_be(data + 4);
+		const uint32_t num_entries = read_uint32_be(data + 8);
+		
+		if (version < 2 || version > 4)
+			return false;
+		
+		const uint8_t * ptr = data + 12;
+		
+		// entries
+		
+		const int kStatSize = 40; // ctime, mtime, dev, ino, mode, uid, gid, size
+		
+		std::string path;
+		
+		paths.reserve(num_entries);
+		stats.reserve(num_entries);
+		
+		for (uint32_t i = 0; i < num_entries; ++i)
+		{
+			const uint8_t * entry = ptr;
+			
+			if (end - ptr < kStatSize + hash_size + 2)
+				return false;
+			
+			const uint32_t mode = read_uint32_be(ptr + 24);
+			
+			FileStat stat;
+			stat.mtime_seconds = read_uint32_be(ptr + 8);
+			stat.mtime_nanoseconds = read_uint32_be(ptr + 12);
+			stat.size = read_uint32_be(ptr + 36);
+			
+			ptr += kStatSize + hash_size;
+			
+			const uint16_t flags = read_uint16_be(ptr);
+			ptr += 2;
+			
+			uint16_t extended_flags = 0;
+			
+			if (flags & 0x4000)
+			{
+				if (version < 3 || end - ptr < 2)
+					return false;
+				
+				extended_flags = read_uint16_be(ptr);
+				ptr += 2;
+			}
+			
+			if (version == 4)
+			{
+				// the path is prefix compressed. it starts with the number of bytes to remove from the previous path,
+				// followed by the (zero-terminated) text to append to it
+				
+				if (ptr == end)
+					return false;
+				
+				uint8_t c = *ptr++;
+				size_t strip = c & 127;
+				
+				while (c & 128)
+				{
+					if (ptr == end)
+						return false;
+					
+					c = *ptr++;
+					strip = ((strip + 1) << 7) | (c & 127);
+				}
+				
+				if (strip > path.size())
+					return false;
+				
+				path.resize(path.size() - strip);
+				
+				const uint8_t * suffix = ptr;
+				
+				while (ptr < end && *ptr != 0)
+					ptr++;
+				
+				if (ptr == end)
+					return false;
+				
+				path.append((const char*)suffix, ptr - suffix);
+				
+				ptr++;
+			}
+			else
+			{
+				// the path is zero-terminated, and padded with zeroes so the size of the entry is a multiple of eight
+				
+				const uint8_t * name = ptr;
+				
+				while (ptr < end && *ptr != 0)
+					ptr++;
+				
+				if (ptr == end)
+					return false;
+				
+				path.assign((const char*)name, ptr - name);
+				
+				const size_t entry_size = ((ptr - entry) + 8) & ~size_t(7);
+				
+				if (size_t(end - entry) < entry_size)
+					return false;
+				
+				ptr = entry + entry_size;
+			}
+			
+			// skip submodules (gitlinks), sparse directory entries and files excluded from a sparse checkout
+			
+			const uint32_t type = mode >> 12;
+			
+			if (type == 0xE || type == 0x4)
+				continue;
+			
+			if (extended_flags & 0x4000)
+				continue;
+			
+			// files with merge conflicts have multiple entries (stages). list them only once
+			
+			if (paths.empty() == false && paths.back() == path)
+				continue;
+			
+			paths.push_back(path);
+			stats.push_back(stat);
+		}
+		
+		return true;
+	}
+	
+	void GitIndex::list_files(const std::string & relative_path, const bool recurse, const char * output_path, std::vector<std::string> & result) const
+	{
+		const std::string prefix =
+			relative_path.empty()
+			? relative_path
+			: relative_path + "/";
+		
+		// paths are sorted, so all of the files inside the directory are stored consecutively
+		
+		auto begin = std::lower_bound(paths.begin(), paths.end(), prefix);
+		
+		for (auto i = begin; i != paths.end() && string_starts_with(*i, prefix); ++i)
+		{
+			const char * name = i->c_str() + prefix.size();
+			
+			if (recurse == false && strchr(name, '/') != nullptr)
+				continue;
+			
+			std::string filename;
+			filename.reserve(strlen(output_path) + 1 + strlen(name));
+			filename.append(output_path);
+			filename.push_back('/');
+			filename.append(name);
+			
+			result.push_back(filename);
+		}
+	}
+	
+	bool GitIndex::is_modified(const char * in_path) const
+	{
+		const std::string path = normalize_path(in_path);
+		
+		if (path.size() <= worktree_path.size() ||
+			!string_starts_with(path, worktree_path) ||
+			path[worktree_path.size()] != '/')
+		{
+			return true;
+		}
+		
+		const std::string relative_path = path.substr(worktree_path.size() + 1);
+		
+		auto i = std::lower_bound(paths.begin(), paths.end(), relative_path);
+		
+		if (i == paths.end() || *i != relative_path)
+			return true;
+		
+		const FileStat & stat = stats[i - paths.begin()];
+		
+		int64_t mtime;
+		int64_t size;
+		
+		if (!get_file_info(path.c_str(), mtime, size))
+			return true;
+		
+		const int64_t seconds = mtime / 1000000000;
+		const int64_t nanoseconds = mtime % 1000000000;
+		
+		return
+			uint32_t(size) != stat.size ||
+			uint32_t(seconds) != stat.mtime_seconds ||
+			(stat.mtime_nanoseconds != 0 && uint32_t(nanoseconds) != stat.mtime_nanoseconds);
+	}
+	
+	bool find_git_repository(const char * in_path, std::string & worktree_path, std::string & git_dir)
+	{
+		std::string path = normalize_path(in_path);
+		
+		for (;;)
+		{
+			const std::string dot_git = path + "/.git";
+			
+			int64_t mtime;
+			int64_t size;
+			
+			if (get_file_info((dot_git + "/HEAD").c_str(), mtime, size))
+			{
+				worktree_path = path;
+				git_dir = dot_git;
+				return true;
+			}
+			
+			// linked worktrees and submodules have a .git file, which points to the actual git directory
+			
+			std::vector<char> contents;
+			
+			if (read_file(dot_git.c_str(), contents))
+			{
+				const char * kPrefix = "gitdir:";
+				
+				std::string text(contents.begin(), contents.end());
+				
+				if (string_starts_with(text, kPrefix))
+				{
+					std::string location = text.substr(strlen(kPrefix));
+					
+					while (!location.empty() && isspace((unsigned char)location.front()))
+						location.erase(location.begin());
+					while (!location.empty() && isspace((unsigned char)location.back()))
+						location.pop_back();
+					
+					worktree_path = path;
+					git_dir = is_absolute_path(location)
+						? normalize_path(location.c_str())
+						: normalize_path((path + "/" + location).c_str());
+					return true;
+				}
+			}
+			
+			const size_t separator = path.find_last_of('/');
+			
+			if (separator == std::string::npos || path.empty())
+				return false;
+			
+			path.resize(separator);
+		}
+	}
+	
+	static int get_repository_hash_size(const std::string & git_dir)
+	{
+		// the repository configuration lives in the common git directory, which is different from the git directory
+		// for linked worktrees
+		
+		std::string common_dir = git_dir;
+		
+		std::vector<char> contents;
+		
+		if (read_file((git_dir + "/commondir").c_str(), contents))
+		{
+			std::string location(contents.begin(), contents.end());
+			
+			while (!location.empty() && isspace((unsigned char)location.back()))
+				location.pop_back();
+			
+			common_dir = is_absolute_path(location)
+				? location
+				: git_dir + "/" + location;
+		}
+		
+		if (read_file((common_dir + "/config").c_str(), contents))
+		{
+			contents.push_back(0);
+			
+			const char * object_format = strstr(contents.data(), "objectformat");
+			
+			if (object_format != nullptr && strstr(object_format, "sha256") != nullptr)
+				return 32;
+		}
+		
+		return 20;
+	}
+	
+	const GitIndex * GitIndexCache::find_index(const char * path)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			auto i = indices_by_path.find(path);
+			
+			if (i != indices_by_path.end())
+				return i->second;
+		}
+		
+		// note : searching for the repository means checking each of the parent directories. we do this without
+		//        holding the lock, so other threads can look up paths in the meantime
+		
+		std::string worktree_path;
+		std::string git_dir;
+		
+		const bool is_found = find_git_repository(path, worktree_path, git_dir);
+		
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		if (is_found == false)
+		{
+			indices_by_path[path] = nullptr;
+			
+			return nullptr;
+		}
+		
+		auto i = indices.find(git_dir);
+		
+		if (i == indices.end())
+		{
+			std::unique_ptr<GitIndex> index(new GitIndex());
+			
+			index->worktree_path = worktree_path;
+			
+			if (!index->load((git_dir + "/index").c_str(), get_repository_hash_size(git_dir)))
+				index.reset();
+			
+			i = indices.emplace(git_dir, std::move(index)).first;
+		}
+		
+		indices_by_path[path] = i->second.get();
+		
+		return i->second.get();
+	}
+	
+	std::string normalize_path(const char * path)
+	{
+		std::vector<std::string> components;
+		
+		const bool is_absolute = path[0] == '/';
+		
+		for (const char * ptr = path; *ptr != 0; )
+		{
+			const char * separator = strchr(ptr, '/');
+			
+			if (separator == nullptr)
+				separator = ptr + strlen(ptr);
+			
+			const std::string component(ptr, separator);
+			
+			if (component == "..")
+			{
+				if (components.empty() == false && components.back() != "..")
+					components.pop_back();
+				else
+					components.push_back(component);
+			}
+			else if (component.empty() == false && component != ".")
+				components.push_back(component);
+			
+			ptr = *separator == 0 ? separator : separator + 1;
+		}
+		
+		std::string result;
+		
+		if (is_absolute)
+			result.push_back('/');
+		
+		for (size_t i = 0; i < components.size(); ++i)
+		{
+			if (i != 0)
+				result.push_back('/');
+			result.append(components[i]);
+		}
+		
+		return result;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace chibi
+{
+	/**
+	 * The files tracked by a git repository, as read from the repository's index file. Reading the index
+	 * is a lot cheaper than walking the working tree, and skips any untracked files and build output.
+	 */
+	struct GitIndex
+	{
+		std::string worktree_path; // the root of the working tree
+		std::string index_filename;
+		
+		/**
+		 * The file status recorded by git when the file was last added to the index. When the file on disk
+		 * has a different modification time or size, it was modified since.
+		 */
+		struct FileStat
+		{
+			uint32_t mtime_seconds = 0;
+			uint32_t mtime_nanoseconds = 0; // zero when git was built without nanosecond support
+			uint32_t size = 0; // truncated to 32 bits
+		};
+		
+		std::vector<std::string> paths; // paths relative to the working tree, sorted
+		std::vector<FileStat> stats; // the file status for each path
+		
+		/**
+		 * Reads the index file. Index versions 2, 3 and 4 are supported.
+		 * @param hash_size The size of object names in bytes. 20 for SHA-1 repositories, 32 for SHA-256.
+		 */
+		bool load(const char * index_filename, const int hash_size);
+		
+		/**
+		 * Lists the tracked files inside the given directory.
+		 * @param relative_path The directory to list, relative to the working tree. Empty for the working tree itself.
+		 * @param recurse When set, files inside subdirectories are listed as well.
+		 * @param output_path The path to prepend to the listed files, instead of the directory's location within the working tree.
+		 */
+		void list_files(const std::string & relative_path, const bool recurse, const char * output_path, std::vector<std::string> & result) const;
+		
+		/**
+		 * Checks whether the file at the given (absolute) path differs from its entry in the index, or isn't
+		 * tracked at all. Like git itself, only the modification time and size are compared.
+		 */
+		bool is_modified(const char * path) const;
+	};
+
+	/**
+	 * Finds the git repository containing the given path, by looking for a .git directory or file (as used by
+	 * linked worktrees and submodules) in the path and all of its parent directories.
+	 * @param worktree_path Output for the root of the working tree.
+	 * @param git_dir Output for the git directory, which contains the index file.
+	 */
+	bool find_git_repository(const char * path, std::string & worktree_path, std::string & git_dir);
+
+	/**
+	 * Loads the index of each repository only once, when it's first needed. May be shared between threads.
+	 */
+	struct GitIndexCache
+	{
+		std::mutex mutex;
+		
+		std::map<std::string, std::unique_ptr<GitIndex>> indices; // by git directory. null when the index failed to load
+		
+		std::map<std::string, const GitIndex*> indices_by_path; // the result of find_index for each path looked up so far
+		
+		/**
+		 * Returns the index for the repository containing the given (absolute) path, or null when the path isn't part of a repository.
+		 * The result is remembered for each path. Look up files by their directory, so the repository is searched for only once per directory.
+		 */
+		const GitIndex * find_index(const char * path);
+	};
+
+	/**
+	 * Removes '.' and '..' components and duplicate separators from the given path.
+	 */
+	std::string normalize_path(const char * path);
+}
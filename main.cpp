@@ -48,11 +48,20 @@ static void report_error(const char * format, ...)
 
 static void show_chibi_cli()
 {
-	printf("usage: chibi -g <source_path> <destination_path> ..[-target <wildcard>] [-platform <name>]\n");
+	printf("usage: chibi -g <source_path> <destination_path> ..[-target <wildcard>] [-platform <name>] [-no-cache] [-no-regenerate] [-cache-stats] [-split-targets] [-compact] [-adaptive-conglomerates] [-check-conglomerates] [-split-conglomerates] [-build-log <path>]\n");
 	printf("\t<source_path> the path where to begin looking for the chibi root file\n");
 	printf("\t<destination_path> the path where to output the generated cmake file\n");
 	printf("\t-target sets an optional filter for the <app_name> or <library_name> to limit the scope of the generated cmake file to only the specific target(s). <wildcard> may specify either the complete target name or a wildcard. when used more than once, multiple targets can be set\n");
 	printf("\t-platform sets an optional platform for which to generate build files. supported platforms: macos, windows, linux, linux.raspberry-pi, ios, android\n");
+	printf("\t-no-cache disables caching. by default, chibi stores the parse results for each chibi file and the listings of directories scanned using scan_files inside <destination_path>, and reuses them for chibi files and directories which didn't change since the previous run. chibi also stores a fingerprint of all of its inputs, and does nothing at all when none of them changed\n");
+	printf("\t-no-regenerate leaves out the code which lets the generated cmake file invoke chibi to generate it again when a chibi file or scanned directory changes. by default, the generated file contains the path to the chibi executable and the current working directory. use this option when the generated files are shared or moved across machines, and run chibi by hand after making changes\n");
+	printf("\t-cache-stats prints statistics about the number of chibi files and directories which were reused from the cache\n");
+	printf("\t-split-targets writes the cmake code for each library and app to its own file inside <destination_path>/chibi-targets, and includes these files from CMakeLists.txt. only the files for targets which changed are rewritten, which keeps the amount of generated file changes proportional to the edit\n");
+	printf("\t-compact generates fewer, batched cmake commands, to reduce the time cmake spends configuring. header files and other files which aren't compiled are only listed for IDE generators (Xcode and Visual Studio), or when the CHIBI_LIST_ALL_FILES cmake variable is set\n");
+	printf("\t-adaptive-conglomerates compiles files which are modified or untracked according to the git index by themselves, rather than as part of their conglomerate, so editing a file doesn't recompile the entire conglomerate. the other files remain in their conglomerates. the conglomerates are updated each time chibi runs. the generated build files run chibi again when the git index changes, such as when files are staged or committed. a clean file which gets edited is pulled out of its conglomerate the next time chibi runs\n");
+	printf("\t-check-conglomerates scans the files included into each conglomerate for file-local symbols (static functions and variables, const variables, and anything inside an anonymous namespace), types and macros which collide once the files are compiled as a single translation unit. the conflicts are reported, and no build files are written when any are found. the files are read using a lightweight lexer, without following includes\n");
+	printf("\t-split-conglomerates checks conglomerates the same way, and compiles the files causing conflicts by themselves, rather than as part of their conglomerate. the files are checked when the build files are generated. conflicts introduced afterwards are found the next time they are generated\n");
+	printf("\t-build-log reads the compile times measured during a previous build from <path>, which is either a .ninja_log file or a build directory generated for Ninja. files marked auto_conglomerate are partitioned so each conglomerate takes a similar amount of time to compile, rather than having a similar size. chibi prints an estimate of the longest translation unit and the total compile time before and after\n");
 }
 
 int main(int argc, const char * argv[])
@@ -63,6 +72,11 @@ int main(int argc, const char * argv[])
 	const char * src_path = nullptr;
 	const char * dst_path = nullptr;
 	
+	ChibiOptions options;
+	
+	// note : the generated build files invoke chibi the same way to regenerate themselves
+	options.chibi_path = argv[0];
+	
 	argc -= 1;
 	argv += 1;
 	
@@ -129,6 +143,50 @@ int main(int argc, const char * argv[])
 				return -1;
 			}
 		}
+		else if (!strcmp(option, "-no-cache"))
+		{
+			options.use_cache = false;
+		}
+		else if (!strcmp(option, "-no-regenerate"))
+		{
+			options.regenerate = false;
+		}
+		else if (!strcmp(option, "-cache-stats"))
+		{
+			options.show_cache_stats = true;
+		}
+		else if (!strcmp(option, "-split-targets"))
+		{
+			options.split_targets = true;
+		}
+		else if (!strcmp(option, "-compact"))
+		{
+			options.compact = true;
+		}
+		else if (!strcmp(option, "-adaptive-conglomerates"))
+		{
+			options.adaptive_conglomerates = true;
+		}
+		else if (!strcmp(option, "-check-conglomerates"))
+		{
+			options.check_conglomerates = true;
+		}
+		else if (!strcmp(option, "-split-conglomerates"))
+		{
+			options.split_conglomerates = true;
+		}
+		else if (!strcmp(option, "-build-log"))
+		{
+			const char * build_log;
+			
+			if (!eat_arg(argc, argv, build_log))
+			{
+				report_error("missing build log path: %s", option);
+				return -1;
+			}
+			
+			options.build_log = build_log;
+		}
 		else
 		{
 			report_error("unknown command line option: %s", option);
@@ -150,7 +208,7 @@ int main(int argc, const char * argv[])
 	for (auto & target : build_targets)
 		targets[index++] = target.c_str();
 	
-	if (chibi_generate(cwd, src_path, dst_path, targets, numTargets, platform) == false)
+	if (chibi_generate(cwd, src_path, dst_path, targets, numTargets, platform, options) == false)
 		return -1;
 	
 	return 0;
@@ -0,0 +1,361 @@
+#include "chibi-internal.h"
+#include "filesystem.h"
+#include "parsecache.h"
+
+using namespace chibi_filesystem;
+
+// note : bump the version whenever the layout of the cache file or of the serialized results changes
+
+static const char kParseCacheMagic[8] = { 'c', 'h', 'i', 'b', 'i', 'p', 'c', 0 };
+static const int32_t kParseCacheVersion = 6;
+
+// chibi files modified less than this many nanoseconds before they were read may be modified again without their
+// modification time changing, due to the limited resolution of file system timestamps. we always verify their contents
+static const int64_t kRacyChibiFileInterval = 2000000000ll;
+
+static const int64_t kRacyChibiFileMtime = -2;
+
+namespace chibi
+{
+	bool ParseCache::load(const char * filename)
+	{
+		entries.clear();
+		
+		std::vector<char> data;
+		
+		if (!read_file(filename, data))
+			return false;
+		
+		BinaryReader reader(data.data(), data.size());
+		
+		char magic[sizeof(kParseCacheMagic)];
+		
+		if (!reader.read_bytes(magic, sizeof(magic)) || memcmp(magic, kParseCacheMagic, sizeof(magic)) != 0)
+			return false;
+		
+		if (reader.read_int32() != kParseCacheVersion)
+			return false;
+		
+		const int32_t num_entries = reader.read_count();
+		
+		for (int32_t i = 0; i < num_entries && reader.error == false; ++i)
+		{
+			std::string key;
+			reader.read_string(key);
+			
+			ParseCacheEntry & entry = entries[key];
+			
+			entry.mtime = reader.read_int64();
+			entry.size = reader.read_int64();
+			entry.content_hash = (uint64_t)reader.read_int64();
+			
+			entry.dependencies.resize(reader.read_count());
+			
+			for (auto & dependency : entry.dependencies)
+			{
+				reader.read_string(dependency.path);
+				dependency.mtime = reader.read_int64();
+			}
+			
+			entry.data.resize(reader.read_count());
+			reader.read_bytes(entry.data.data(), entry.data.size());
+		}
+		
+		if (reader.error)
+		{
+			entries.clear();
+			return false;
+		}
+		
+		return true;
+	}
+	
+	bool ParseCache::save(const char * filename) const
+	{
+		BinaryWriter writer;
+		
+		writer.write_bytes(kParseCacheMagic, sizeof(kParseCacheMagic));
+		writer.write_int32(kParseCacheVersion);
+		writer.write_int32((int32_t)entries.size());
+		
+		for (auto & entry_itr : entries)
+		{
+			auto & entry = entry_itr.second;
+			
+			writer.write_string(entry_itr.first);
+			
+			writer.write_int64(entry.mtime);
+			writer.write_int64(entry.size);
+			writer.write_int64((int64_t)entry.content_hash);
+			
+			writer.write_int32((int32_t)entry.dependencies.size());
+			
+			for (auto & dependency : entry.dependencies)
+			{
+				writer.write_string(dependency.path);
+				writer.write_int64(dependency.mtime);
+			}
+			
+			writer.write_int32((int32_t)entry.data.size());
+			writer.write_bytes(entry.data.data(), entry.data.size());
+		}
+		
+		return write_file_atomically(filename, writer.data.data(), writer.data.size());
+	}
+	
+	uint64_t compute_content_hash(const char * text, const size_t size)
+	{
+		// FNV-1a (64 bit)
+		
+		uint64_t result = 14695981039346656037ull;
+		
+		for (size_t i = 0; i < size; ++i)
+		{
+			result ^= (uint8_t)text[i];
+			result *= 1099511628211ull;
+		}
+		
+		return result;
+	}
+	
+	bool validate_parse_cache_entry(const ParseCacheEntry & entry, const char * filename, int64_t & mtime)
+	{
+		int64_t size;
+		
+		if (!get_file_info(filename, mtime, size) || size != entry.size)
+			return false;
+		
+		if (mtime != entry.mtime)
+		{
+			// the file was touched, or it was modified shortly before the entry was made. check if the contents changed
+			
+			FileHandle f(filename, "rb");
+			
+			if (f == nullptr)
+				return false;
+			
+			std::vector<char> text(size);
+			
+			if (fread(text.data(), 1, size, f) != (size_t)size)
+				return false;
+			
+			if (compute_content_hash(text.data(), text.size()) != entry.content_hash)
+				return false;
+		}
+		
+		for (auto & dependency : entry.dependencies)
+		{
+			int64_t dependency_mtime;
+			int64_t dependency_size;
+			
+			if (!get_file_info(dependency.path.c_str(), dependency_mtime, dependency_size))
+				dependency_mtime = -1;
+			
+			if (dependency_mtime != dependency.mtime)
+				return false;
+		}
+		
+		return true;
+	}
+	
+	void set_parse_cache_entry_mtime(ParseCacheEntry & entry, const int64_t mtime, const int64_t start_time)
+	{
+		if (mtime >= 0 && mtime > start_time - kRacyChibiFileInterval)
+			entry.mtime = kRacyChibiFileMtime;
+		else
+			entry.mtime = mtime;
+	}
+	
+	void write_library(BinaryWriter & writer, const ChibiLibrary & library)
+	{
+		writer.write_string(library.name);
+		writer.write_string(library.path);
+		writer.write_string(library.group_name);
+		writer.write_string(library.chibi_file);
+		
+		writer.write_bool(library.shared);
+		writer.write_bool(library.prebuilt);
+		writer.write_bool(library.objc_arc);
+		writer.write_bool(library.isExecutable);
+		writer.write_bool(library.auto_conglomerate);
+		writer.write_int32(library.auto_conglomerate_size);
+		
+		writer.write_int32((int32_t)library.files.size());
+		for (auto & file : library.files)
+		{
+			writer.write_string(file.filename);
+			writer.write_string(file.group);
+			writer.write_string(file.conglomerate_filename);
+			writer.write_bool(file.compile);
+			writer.write_bool(file.auto_conglomerate);
+		}
+		
+		writer.write_int32((int32_t)library.file_scans.size());
+		for (auto & file_scan : library.file_scans)
+		{
+			writer.write_string(file_scan.path);
+			writer.write_string(file_scan.extensions);
+			writer.write_bool(file_scan.traverse);
+			writer.write_int32(file_scan.source);
+			writer.write_strings(file_scan.excluded_paths);
+			writer.write_strings(file_scan.excluded_files);
+			writer.write_string(file_scan.group);
+			writer.write_string(file_scan.conglomerate_filename);
+			writer.write_bool(file_scan.auto_conglomerate);
+			writer.write_int64((int64_t)file_scan.file_index);
+		}
+		
+		writer.write_int32((int32_t)library.library_dependencies.size());
+		for (auto & library_dependency : library.library_dependencies)
+		{
+			writer.write_string(library_dependency.name);
+			writer.write_string(library_dependency.path);
+			writer.write_int32(library_dependency.type);
+			writer.write_bool(library_dependency.embed_framework);
+		}
+		
+		writer.write_int32((int32_t)library.package_dependencies.size());
+		for (auto & package_dependency : library.package_dependencies)
+		{
+			writer.write_string(package_dependency.name);
+			writer.write_string(package_dependency.variable_name);
+			writer.write_int32(package_dependency.type);
+		}
+		
+		writer.write_int32((int32_t)library.header_paths.size());
+		for (auto & header_path : library.header_paths)
+		{
+			writer.write_string(header_path.path);
+			writer.write_bool(header_path.expose);
+			writer.write_string(header_path.alias_through_copy);
+			writer.write_string(header_path.alias_through_copy_path);
+		}
+		
+		writer.write_int32((int32_t)library.compile_definitions.size());
+		for (auto & compile_definition : library.compile_definitions)
+		{
+			writer.write_string(compile_definition.name);
+			writer.write_string(compile_definition.value);
+			writer.write_bool(compile_definition.expose);
+			writer.write_string(compile_definition.toolchain);
+			writer.write_strings(compile_definition.configs);
+		}
+		
+		writer.write_int32((int32_t)library.conglomerate_groups.size());
+		for (auto & conglomerate_group : library.conglomerate_groups)
+		{
+			writer.write_string(conglomerate_group.first);
+			writer.write_string(conglomerate_group.second);
+		}
+		
+		writer.write_string(library.resource_path);
+		writer.write_strings(library.resource_excludes);
+		writer.write_strings(library.dist_files);
+		writer.write_strings(library.license_files);
+		writer.write_strings(library.link_translation_unit_using_function_calls);
+		writer.write_string(library.precompiled_header);
+		writer.write_bool(library.precompiled_header_expose);
+	}
+	
+	bool read_library(BinaryReader & reader, ChibiLibrary & library)
+	{
+		reader.read_string(library.name);
+		reader.read_string(library.path);
+		reader.read_string(library.group_name);
+		reader.read_string(library.chibi_file);
+		
+		library.shared = reader.read_bool();
+		library.prebuilt = reader.read_bool();
+		library.objc_arc = reader.read_bool();
+		library.isExecutable = reader.read_bool();
+		library.auto_conglomerate = reader.read_bool();
+		library.auto_conglomerate_size = reader.read_int32();
+		
+		std::string group;
+		std::string conglomerate_filename;
+		
+		library.files.resize(reader.read_count());
+		for (auto & file : library.files)
+		{
+			reader.read_string(file.filename);
+			reader.read_string(group);
+			reader.read_string(conglomerate_filename);
+			file.group = group;
+			file.conglomerate_filename = conglomerate_filename;
+			file.compile = reader.read_bool();
+			file.auto_conglomerate = reader.read_bool();
+		}
+		
+		library.file_scans.resize(reader.read_count());
+		for (auto & file_scan : library.file_scans)
+		{
+			reader.read_string(file_scan.path);
+			reader.read_string(file_scan.extensions);
+			file_scan.traverse = reader.read_bool();
+			file_scan.source = (ChibiScanSource)reader.read_int32();
+			reader.read_strings(file_scan.excluded_paths);
+			reader.read_strings(file_scan.excluded_files);
+			reader.read_string(file_scan.group);
+			reader.read_string(file_scan.conglomerate_filename);
+			file_scan.auto_conglomerate = reader.read_bool();
+			file_scan.file_index = (size_t)reader.read_int64();
+			
+			if (file_scan.file_index > library.files.size())
+				reader.error = true;
+		}
+		
+		library.library_dependencies.resize(reader.read_count());
+		for (auto & library_dependency : library.library_dependencies)
+		{
+			reader.read_string(library_dependency.name);
+			reader.read_string(library_dependency.path);
+			library_dependency.type = (ChibiLibraryDependency::Type)reader.read_int32();
+			library_dependency.embed_framework = reader.read_bool();
+		}
+		
+		library.package_dependencies.resize(reader.read_count());
+		for (auto & package_dependency : library.package_dependencies)
+		{
+			reader.read_string(package_dependency.name);
+			reader.read_string(package_dependency.variable_name);
+			package_dependency.type = (ChibiPackageDependency::Type)reader.read_int32();
+		}
+		
+		library.header_paths.resize(reader.read_count());
+		for (auto & header_path : library.header_paths)
+		{
+			reader.read_string(header_path.path);
+			header_path.expose = reader.read_bool();
+			reader.read_string(header_path.alias_through_copy);
+			reader.read_string(header_path.alias_through_copy_path);
+		}
+		
+		library.compile_definitions.resize(reader.read_count());
+		for (auto & compile_definition : library.compile_definitions)
+		{
+			reader.read_string(compile_definition.name);
+			reader.read_string(compile_definition.value);
+			compile_definition.expose = reader.read_bool();
+			reader.read_string(compile_definition.toolchain);
+			reader.read_strings(compile_definition.configs);
+		}
+		
+		const int32_t num_conglomerate_groups = reader.read_count();
+		for (int32_t i = 0; i < num_conglomerate_groups; ++i)
+		{
+			reader.read_string(conglomerate_filename);
+			reader.read_string(group);
+			library.conglomerate_groups[conglomerate_filename] = group;
+		}
+		
+		reader.read_string(library.resource_path);
+		reader.read_strings(library.resource_excludes);
+		reader.read_strings(library.dist_files);
+		reader.read_strings(library.license_files);
+		reader.read_strings(library.link_translation_unit_using_function_calls);
+		reader.read_string(library.precompiled_header);
+		library.precompiled_header_expose = reader.read_bool();
+		
+		return reader.error == false;
+	}
+}
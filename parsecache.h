@@ -0,0 +1,81 @@
+#pragma once
+
+#include "binaryio.h"
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ChibiLibrary;
+
+namespace chibi
+{
+	/**
+	 * A file or directory the result of parsing a chibi file depends on. The cached result becomes invalid when
+	 * the modification time changes. mtime is -1 when the file or directory didn't exist at the time of parsing.
+	 */
+	struct ParseCacheDependency
+	{
+		std::string path;
+		
+		int64_t mtime = -1;
+	};
+	
+	/**
+	 * The cached result of parsing a single chibi file.
+	 */
+	struct ParseCacheEntry
+	{
+		// modification time, size and content hash of the chibi file itself
+		int64_t mtime = 0;
+		int64_t size = 0;
+		uint64_t content_hash = 0;
+		
+		std::vector<ParseCacheDependency> dependencies;
+		
+		std::vector<char> data; // the serialized result
+	};
+	
+	/**
+	 * Parse results for chibi files, stored in a binary file inside the destination directory. Entries are keyed
+	 * by everything which affects the result of parsing a chibi file besides its contents: its path, the platform,
+	 * and the group name active at the point where the file was added.
+	 */
+	struct ParseCache
+	{
+		std::unordered_map<std::string, ParseCacheEntry> entries;
+		
+		bool load(const char * filename);
+		bool save(const char * filename) const;
+		
+		const ParseCacheEntry * find(const std::string & key) const
+		{
+			auto i = entries.find(key);
+			
+			return i == entries.end() ? nullptr : &i->second;
+		}
+	};
+	
+	uint64_t compute_content_hash(const char * text, const size_t size);
+	
+	/**
+	 * Checks whether the cache entry for the given chibi file is still valid. The chibi file's modification
+	 * time and size are checked first. Only when the modification time changed, or when the entry is marked
+	 * racy, the file is read and its contents compared using the content hash.
+	 * @param mtime Output for the current modification time of the chibi file.
+	 * @return True if the cached result may be used.
+	 */
+	bool validate_parse_cache_entry(const ParseCacheEntry & entry, const char * filename, int64_t & mtime);
+	
+	/**
+	 * Stores the modification time of the chibi file in the cache entry. Chibi files modified shortly before
+	 * they were read may be modified again without their modification time changing. Their entries are marked
+	 * racy, so their contents are always verified.
+	 * @param start_time The time at which chibi started reading its inputs. See get_current_time.
+	 */
+	void set_parse_cache_entry_mtime(ParseCacheEntry & entry, const int64_t mtime, const int64_t start_time);
+	
+	void write_library(BinaryWriter & writer, const ChibiLibrary & library);
+	bool read_library(BinaryReader & reader, ChibiLibrary & library);
+}
@@ -1,12 +1,5 @@
 #include "stringbuilder.h"
-#include <stdarg.h>
-
-#if defined(__GNUC__)
-	#define sprintf_s(s, ss, f, ...) snprintf(s, ss, f, __VA_ARGS__)
-	#define vsprintf_s(s, ss, f, a) vsnprintf(s, ss, f, a)
-	#define strcpy_s(d, ds, s) strcpy(d, s)
-	#define sscanf_s sscanf
-#endif
+#include <stdio.h>
 
 namespace chibi
 {
@@ -14,10 +7,41 @@ namespace chibi
 	{
 		va_list va;
 		va_start(va, format);
-		char text[STRING_BUFFER_SIZE];
-		vsprintf_s(text, sizeof(text), format, va);
+		AppendFormatV(format, va);
 		va_end(va);
-
-		Append(text);
+	}
+	
+	void StringBuilder::AppendFormatV(const char * format, va_list va)
+	{
+		// format into a buffer on the stack first, as most lines are short. when a line doesn't fit, we know its exact
+		// size after the first attempt, and format it once more directly into the string
+		
+		char buffer[1024];
+		
+		va_list va_retry;
+		va_copy(va_retry, va);
+		
+		const int length = vsnprintf(buffer, sizeof(buffer), format, va);
+		
+		if (length < 0)
+		{
+			// note : formatting failed. leave the text as it is
+		}
+		else if ((size_t)length < sizeof(buffer))
+		{
+			text.append(buffer, length);
+		}
+		else
+		{
+			const size_t size = text.size();
+			
+			text.resize(size + length + 1);
+			
+			vsnprintf(&text[size], length + 1, format, va_retry);
+			
+			text.resize(size + length);
+		}
+		
+		va_end(va_retry);
 	}
 }
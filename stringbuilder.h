@@ -1,19 +1,13 @@
 #pragma once
 
+#include <stdarg.h>
 #include <string>
 
 namespace chibi
 {
-	static const int STRING_BUFFER_SIZE = (1 << 12);
-
 	struct StringBuilder
 	{
-		std::string text;
-		
-		StringBuilder()
-		{
-			text.reserve(1 << 16);
-		}
+		std::string text; // note : grows geometrically as text gets appended. there is no limit on the size of the text
 		
 		void Append(const char c)
 		{
@@ -27,6 +21,8 @@ namespace chibi
 		
 		void AppendFormat(const char * format, ...);
 		
+		void AppendFormatV(const char * format, va_list va);
+		
 		void Reset()
 		{
 			text.clear();
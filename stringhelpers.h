@@ -206,61 +206,6 @@ namespace chibi
 		return true;
 	}
 
-	static bool match_wildcard(const char * in_text, const char * wildcard, const char separator)
-	{
-		const char * text = in_text;
-		
-		while (wildcard[0] != 0)
-		{
-			if (wildcard[0] == separator)
-			{
-				// did we match the entire element? match
-				if (text[0] == 0)
-					return true;
-
-				// restart matching against the next element
-				text = in_text;
-				wildcard++;
-			}
-			else if (wildcard[0] == '*')
-			{
-				if (wildcard[1] == 0 || wildcard[1] == separator)
-					return true;
-				else
-				{
-					while (text[0] != 0 && text[0] != wildcard[1])
-						text++;
-					
-					if (text[0] == 0)
-						return false;
-					
-					wildcard++;
-				}
-			}
-			else if (text[0] != wildcard[0])
-			{
-				// seek to the next element
-				while (wildcard[0] != 0 && wildcard[0] != separator)
-					wildcard++;
-				
-				// no more elements? no match
-				if (wildcard[0] == 0)
-					return false;
-				
-				// we found the next element. restart matching
-				in_text = text;
-				wildcard++;
-			}
-			else
-			{
-				text++;
-				wildcard++;
-			}
-		}
-		
-		return text[0] == 0;
-	}
-	
 	static bool match_element(const char * in_text, const char * element, const char separator)
 	{
 		const char * text = in_text;
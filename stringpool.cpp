@@ -0,0 +1,49 @@
+#include "stringpool.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace chibi
+{
+	static const std::string s_empty_string;
+
+	struct StringPool
+	{
+		std::mutex mutex;
+		
+		std::unordered_set<std::string> strings; // note : elements of an unordered set don't move when it grows
+		
+		const std::string * intern(const std::string & text)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			return &*strings.insert(text).first;
+		}
+	};
+
+	static StringPool & get_string_pool()
+	{
+		static StringPool string_pool;
+		
+		return string_pool;
+	}
+
+	InternedString::InternedString()
+		: text(&s_empty_string)
+	{
+	}
+
+	InternedString::InternedString(const char * in_text)
+		: text(&s_empty_string)
+	{
+		if (in_text[0] != 0)
+			text = get_string_pool().intern(in_text);
+	}
+
+	InternedString::InternedString(const std::string & in_text)
+		: text(&s_empty_string)
+	{
+		if (in_text.empty() == false)
+			text = get_string_pool().intern(in_text);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+namespace chibi
+{
+	/**
+	 * A string stored once in a global, thread-safe pool. Interned strings are cheap to copy and compare, which makes
+	 * them a good fit for names which repeat for many files, like group names and conglomerate filenames.
+	 */
+	struct InternedString
+	{
+		const std::string * text;
+		
+		InternedString();
+		InternedString(const char * text);
+		InternedString(const std::string & text);
+		
+		const char * c_str() const
+		{
+			return text->c_str();
+		}
+		
+		bool empty() const
+		{
+			return text->empty();
+		}
+		
+		operator const std::string & () const
+		{
+			return *text;
+		}
+		
+		bool operator==(const InternedString & other) const
+		{
+			return text == other.text;
+		}
+		
+		bool operator!=(const InternedString & other) const
+		{
+			return text != other.text;
+		}
+	};
+}
@@ -0,0 +1,137 @@
+#include "buildlog.h"
+#include "filesystem.h"
+#include "testing.h"
+
+#include <string>
+
+using namespace chibi;
+using namespace chibi_filesystem;
+
+static bool load_log(BuildLog & build_log, const std::string & text)
+{
+	const char * filename = "test-buildlog.tmp";
+	
+	if (!write_file_atomically(filename, text.c_str(), text.size()))
+		return false;
+	
+	return build_log.load(filename);
+}
+
+static void test_headers()
+{
+	BuildLog build_log;
+	
+	const std::string entry = "0\t100\t0\tCMakeFiles/lib.dir/a.cpp.o\t1234\n";
+	
+	CHECK(load_log(build_log, "# ninja log v5\n" + entry));
+	CHECK(build_log.entries.size() == 1);
+	
+	CHECK(load_log(build_log, "# ninja log v6\n" + entry));
+	CHECK(build_log.entries.size() == 1);
+	
+	CHECK(load_log(build_log, "# ninja log v4\n" + entry) == false);
+	CHECK(load_log(build_log, entry) == false);
+	CHECK(load_log(build_log, "") == false);
+	
+	// a build directory containing the log
+	
+	CHECK(create_directories("test-buildlog-dir"));
+	CHECK(write_file_atomically("test-buildlog-dir/.ninja_log", ("# ninja log v5\n" + entry).c_str(), entry.size() + 15));
+	CHECK(build_log.load("test-buildlog-dir"));
+	CHECK(build_log.entries.size() == 1);
+	
+	CHECK(build_log.load("test-buildlog-missing") == false);
+}
+
+static void test_entries()
+{
+	BuildLog build_log;
+	
+	CHECK(load_log(build_log,
+		"# ninja log v5\n"
+		"10\t250\t0\tCMakeFiles/lib.dir/src/a.cpp.o\t1\n"
+		"20\t50\t0\tsub/CMakeFiles/app.dir/main.cpp.o\t2\n"
+		"0\t30\t0\tCMakeFiles/lib.dir/C_/work/b.cpp.obj\t3\n"
+		"0\t900\t0\tliblib.a\t4\n"
+		"0\t900\t0\tCMakeFiles/lib.dir/link.txt\t5\n"
+		"0\t900\t0\tbuild.ninja\t6\n"
+		"malformed line\n"
+		"0\t10\t0\tCMakeFiles/lib.dir/src/c.cpp.o"));
+	
+	CHECK(build_log.entries.size() == 3);
+	
+	if (build_log.entries.size() == 3)
+	{
+		CHECK(build_log.entries[0].target == "lib");
+		CHECK(build_log.entries[0].source == "src/a.cpp");
+		CHECK(build_log.entries[0].duration == 240);
+		
+		// object files of targets in subdirectories
+		
+		CHECK(build_log.entries[1].target == "app");
+		CHECK(build_log.entries[1].source == "main.cpp");
+		CHECK(build_log.entries[1].duration == 30);
+		
+		// the drive letter of absolute paths on Windows
+		
+		CHECK(build_log.entries[2].target == "lib");
+		CHECK(build_log.entries[2].source == "C:/work/b.cpp");
+	}
+}
+
+static void test_duplicate_outputs()
+{
+	// a.cpp was first compiled as part of a unity file, which was split up later. each output appearing again moves
+	// to the end, so the entries are ordered by the time they were last built
+	
+	BuildLog build_log;
+	
+	CHECK(load_log(build_log,
+		"# ninja log v5\n"
+		"0\t100\t0\tCMakeFiles/lib.dir/a.cpp.o\t1\n"
+		"0\t500\t0\tCMakeFiles/lib.dir/unity-a.cpp.o\t2\n"
+		"0\t50\t0\tCMakeFiles/lib.dir/b.cpp.o\t3\n"
+		"0\t70\t0\tCMakeFiles/lib.dir/a.cpp.o\t4\n"
+		"0\t60\t0\tCMakeFiles/lib.dir/b.cpp.o\t5\n"));
+	
+	CHECK(build_log.entries.size() == 3);
+	
+	if (build_log.entries.size() == 3)
+	{
+		CHECK(build_log.entries[0].source == "unity-a.cpp");
+		CHECK(build_log.entries[0].duration == 500);
+		CHECK(build_log.entries[1].source == "a.cpp");
+		CHECK(build_log.entries[1].duration == 70);
+		CHECK(build_log.entries[2].source == "b.cpp");
+		CHECK(build_log.entries[2].duration == 60);
+	}
+	
+	// the same source in different targets are different outputs
+	
+	CHECK(load_log(build_log,
+		"# ninja log v5\n"
+		"0\t100\t0\tCMakeFiles/lib1.dir/a.cpp.o\t1\n"
+		"0\t200\t0\tCMakeFiles/lib2.dir/a.cpp.o\t2\n"));
+	
+	CHECK(build_log.entries.size() == 2);
+}
+
+static void test_source_matches()
+{
+	CHECK(BuildLog::source_matches("/work/src/a.cpp", "src/a.cpp"));
+	CHECK(BuildLog::source_matches("/work/src/a.cpp", "work/src/a.cpp"));
+	CHECK(BuildLog::source_matches("src/a.cpp", "src/a.cpp"));
+	CHECK(BuildLog::source_matches("/work/src/a.cpp", "rc/a.cpp") == false);
+	CHECK(BuildLog::source_matches("/work/src/a.cpp", "b.cpp") == false);
+	CHECK(BuildLog::source_matches("a.cpp", "src/a.cpp") == false);
+}
+
+int main()
+{
+	test_headers();
+	test_entries();
+	test_duplicate_outputs();
+	test_source_matches();
+	
+	return report_test_results("buildlog");
+}
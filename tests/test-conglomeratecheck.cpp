@@ -0,0 +1,283 @@
+#include "conglomeratecheck.h"
+#include "testing.h"
+
+#include <string>
+#include <vector>
+
+using namespace chibi;
+
+static const SourceSymbols::Symbol * find_symbol(const SourceSymbols & symbols, const char * name)
+{
+	for (auto & symbol : symbols.symbols)
+		if (symbol.name == name)
+			return &symbol;
+	
+	return nullptr;
+}
+
+// scans each text as a source file, and returns the conflicts found when including them into a single conglomerate
+static std::vector<ConglomerateConflict> find_conflicts(const std::vector<const char*> & texts)
+{
+	std::vector<SourceSymbols> files(texts.size());
+	
+	std::vector<const SourceSymbols*> file_pointers;
+	
+	for (size_t i = 0; i < texts.size(); ++i)
+	{
+		files[i].scan_text(texts[i]);
+		file_pointers.push_back(&files[i]);
+	}
+	
+	std::vector<ConglomerateConflict> conflicts;
+	find_conglomerate_conflicts(file_pointers, conflicts);
+	
+	return conflicts;
+}
+
+static bool has_conflict(const std::vector<const char*> & texts)
+{
+	return find_conflicts(texts).empty() == false;
+}
+
+static void test_symbols()
+{
+	SourceSymbols symbols;
+	symbols.scan_text(
+		"static int helper(int a, float b = 1.f) { return a; }\n"
+		"int exported(int x) { return x; }\n"
+		"int declared(int x);\n"
+		"static int counter = 0;\n"
+		"const int kLimit = 10;\n"
+		"Foo::~Foo() { }\n"
+		"void Foo::method() { }\n"
+		"static void (*callback)(int) = nullptr;\n"
+		"typedef int (*Handler)(int);\n"
+		"using Alias = std::vector<int>;\n"
+		"enum Color { kRed, kGreen = 2 };\n"
+		"enum class Scoped { kA };\n"
+		"struct Local { int member; void f() { int inner = 0; } };\n"
+		"template <typename T> static T identity(T t) { return t; }\n");
+	
+	auto * helper = find_symbol(symbols, "helper");
+	CHECK(helper != nullptr && helper->kind == SourceSymbols::kSymbolKind_Function);
+	CHECK(helper != nullptr && helper->is_local && helper->line == 1);
+	
+	// parameter names and default arguments are left out of the signature
+	
+	CHECK(helper != nullptr && helper->signature == "int, float");
+	
+	// functions with external linkage are only recorded when defined
+	
+	auto * exported = find_symbol(symbols, "exported");
+	CHECK(exported != nullptr && exported->is_local == false);
+	CHECK(find_symbol(symbols, "declared") == nullptr);
+	
+	// const variables have internal linkage
+	
+	auto * counter = find_symbol(symbols, "counter");
+	CHECK(counter != nullptr && counter->kind == SourceSymbols::kSymbolKind_Variable && counter->is_local);
+	
+	auto * limit = find_symbol(symbols, "kLimit");
+	CHECK(limit != nullptr && limit->is_local);
+	
+	// members defined outside their class, including destructors, belong to the class
+	
+	CHECK(find_symbol(symbols, "Foo") == nullptr);
+	CHECK(find_symbol(symbols, "~Foo") == nullptr);
+	CHECK(find_symbol(symbols, "method") == nullptr);
+	
+	// pointers to functions
+	
+	auto * callback = find_symbol(symbols, "callback");
+	CHECK(callback != nullptr && callback->kind == SourceSymbols::kSymbolKind_Variable && callback->is_local);
+	
+	auto * handler = find_symbol(symbols, "Handler");
+	CHECK(handler != nullptr && handler->kind == SourceSymbols::kSymbolKind_TypeAlias);
+	
+	auto * alias = find_symbol(symbols, "Alias");
+	CHECK(alias != nullptr && alias->kind == SourceSymbols::kSymbolKind_TypeAlias);
+	
+	// the enumerators of unscoped enums only
+	
+	auto * color = find_symbol(symbols, "Color");
+	CHECK(color != nullptr && color->kind == SourceSymbols::kSymbolKind_Type);
+	
+	auto * green = find_symbol(symbols, "kGreen");
+	CHECK(green != nullptr && green->kind == SourceSymbols::kSymbolKind_Enumerator);
+	CHECK(find_symbol(symbols, "kRed") != nullptr);
+	CHECK(find_symbol(symbols, "Scoped") != nullptr);
+	CHECK(find_symbol(symbols, "kA") == nullptr);
+	
+	// members and locals aren't at namespace scope
+	
+	CHECK(find_symbol(symbols, "Local") != nullptr);
+	CHECK(find_symbol(symbols, "member") == nullptr);
+	CHECK(find_symbol(symbols, "f") == nullptr);
+	CHECK(find_symbol(symbols, "inner") == nullptr);
+	
+	auto * identity = find_symbol(symbols, "identity");
+	CHECK(identity != nullptr && identity->kind == SourceSymbols::kSymbolKind_Function && identity->is_local);
+}
+
+static void test_namespaces()
+{
+	SourceSymbols symbols;
+	symbols.scan_text(
+		"namespace ns { static int in_ns; namespace { int anonymous; } }\n"
+		"namespace { int anonymous_top; void anonymous_function() { } }\n"
+		"namespace a::b { static int nested; }\n"
+		"extern \"C\" { static int c_linkage; }\n");
+	
+	CHECK(find_symbol(symbols, "ns::in_ns") != nullptr);
+	CHECK(find_symbol(symbols, "in_ns") == nullptr);
+	CHECK(find_symbol(symbols, "a::b::nested") != nullptr);
+	CHECK(find_symbol(symbols, "c_linkage") != nullptr);
+	
+	// everything inside an anonymous namespace is file-local
+	
+	auto * anonymous = find_symbol(symbols, "ns::anonymous");
+	CHECK(anonymous != nullptr && anonymous->is_local);
+	
+	auto * anonymous_function = find_symbol(symbols, "anonymous_function");
+	CHECK(anonymous_function != nullptr && anonymous_function->is_local);
+	
+	// the same name in different namespaces doesn't conflict, but anonymous namespaces are merged
+	
+	CHECK(has_conflict({ "namespace a { static int x; }", "namespace b { static int x; }" }) == false);
+	CHECK(has_conflict({ "namespace a { static int x; }", "namespace a { static int x; }" }));
+	CHECK(has_conflict({ "namespace { int x; }", "namespace { int x; }" }));
+	CHECK(has_conflict({ "namespace { int x; }", "static int x;" }));
+}
+
+static void test_comments_and_literals()
+{
+	SourceSymbols symbols;
+	symbols.scan_text(
+		"// static int line_comment;\n"
+		"/* static int\n"
+		"   block_comment; */\n"
+		"const char * s = \"static int in_string;\";\n"
+		"const char * r = R\"delimiter(\n"
+		"static int in_raw_string; )\" still raw\n"
+		")delimiter\";\n"
+		"char c = '\\'';\n"
+		"static int after_literals;\n");
+	
+	CHECK(find_symbol(symbols, "line_comment") == nullptr);
+	CHECK(find_symbol(symbols, "block_comment") == nullptr);
+	CHECK(find_symbol(symbols, "in_string") == nullptr);
+	CHECK(find_symbol(symbols, "in_raw_string") == nullptr);
+	CHECK(symbols.identifiers.count("still") == 0);
+	
+	// line numbers keep counting through multi-line comments and raw strings
+	
+	auto * after_literals = find_symbol(symbols, "after_literals");
+	CHECK(after_literals != nullptr && after_literals->line == 9);
+}
+
+static void test_macros()
+{
+	SourceSymbols symbols;
+	symbols.scan_text(
+		"#ifndef GUARDED\n"
+		"#define GUARDED 1\n"
+		"#endif\n"
+		"#define  MAX( a , b )   ((a) >  (b) ? \\\n"
+		"   (a) : (b))\n"
+		"#define EMPTY\n"
+		"#undef EMPTY\n"
+		"#if defined(FEATURE) && OTHER\n"
+		"#endif\n");
+	
+	CHECK(symbols.macro_directives.size() == 4);
+	
+	if (symbols.macro_directives.size() == 4)
+	{
+		CHECK(symbols.macro_directives[0].name == "GUARDED");
+		CHECK(symbols.macro_directives[0].is_guarded);
+		
+		// whitespace is normalized, and line continuations are removed
+		
+		CHECK(symbols.macro_directives[1].name == "MAX");
+		CHECK(symbols.macro_directives[1].definition == "(a,b) ((a) > (b) ? (a) : (b))");
+		CHECK(symbols.macro_directives[1].is_guarded == false);
+		CHECK(symbols.macro_directives[1].line == 4);
+		
+		CHECK(symbols.macro_directives[3].name == "EMPTY");
+		CHECK(symbols.macro_directives[3].is_undef);
+	}
+	
+	// identifiers used by conditions are recorded
+	
+	CHECK(symbols.identifiers.count("FEATURE") == 1);
+	CHECK(symbols.identifiers.count("OTHER") == 1);
+	
+	// redefinitions are fine as long as they only differ in whitespace
+	
+	CHECK(has_conflict({ "#define MAX(a, b) ((a) > (b) ? (a) : (b))", "#define MAX(a,b)  ((a) > (b) ?  (a) : (b))" }) == false);
+	CHECK(has_conflict({ "#define MAX(a, b) ((a) > (b) ? (a) : (b))", "#define MAX(a, b) ((a) < (b) ? (b) : (a))" }));
+	CHECK(has_conflict({ "#define VALUE 1", "#define VALUE (1)" }));
+	
+	// a macro leaking into a later file which uses the same name
+	
+	CHECK(has_conflict({ "#define count 4", "static int count;" }));
+	CHECK(has_conflict({ "#define count 4\n#undef count", "static int count;" }) == false);
+	CHECK(has_conflict({ "#define count 4", "#undef count\nstatic int count;" }) == false);
+	CHECK(has_conflict({ "#define count 4", "static int other;" }) == false);
+	
+	// guarded definitions are fallbacks, which are meant to refer to the same macro
+	
+	CHECK(has_conflict({ "#ifndef M_PI\n#define M_PI 3.14\n#endif", "#ifndef M_PI\n#define M_PI 3.1415\n#endif\nfloat x = M_PI;" }) == false);
+	CHECK(has_conflict({ "#define M_PI 3.14", "#ifndef M_PI\n#define M_PI 3.1415\n#endif\nfloat x = M_PI;" }) == false);
+}
+
+static void test_conflicts()
+{
+	// file-local functions collide, unless they're overloads
+	
+	CHECK(has_conflict({ "static int helper(int a) { return a; }", "static int helper(int b) { return b; }" }));
+	CHECK(has_conflict({ "static int helper(int a) { return a; }", "static int helper(float a) { return 0; }" }) == false);
+	
+	// a file-local symbol colliding with one with external linkage
+	
+	CHECK(has_conflict({ "int helper(int a) { return a; }", "static int helper(int a) { return a; }" }));
+	CHECK(has_conflict({ "int helper(int a) { return a; }", "int helper(int a) { return a; }" }) == false);
+	
+	// a file declaring a function before defining it
+	
+	CHECK(has_conflict({ "static void helper();\nstatic void helper() { }" }) == false);
+	
+	// type aliases may be repeated as long as they alias the same type
+	
+	CHECK(has_conflict({ "typedef unsigned int uint;", "typedef unsigned int uint;" }) == false);
+	CHECK(has_conflict({ "typedef unsigned int uint;", "typedef int uint;" }));
+	CHECK(has_conflict({ "using Map = std::map<int, int>;", "using Map = std::map<int, int>;" }) == false);
+	
+	// types, variables and enumerators
+	
+	CHECK(has_conflict({ "struct Local { };", "struct Local { int x; };" }));
+	CHECK(has_conflict({ "enum Color { kRed };", "static const int kRed = 1;" }));
+	CHECK(has_conflict({ "static int x;", "static int y;" }) == false);
+	
+	// the conflict is reported at the later file, pointing at the earlier one
+	
+	auto conflicts = find_conflicts({ "static int a;", "static int b;", "\nstatic int a;" });
+	CHECK(conflicts.size() == 1);
+	
+	if (conflicts.size() == 1)
+	{
+		CHECK(conflicts[0].file_index == 2 && conflicts[0].line == 2);
+		CHECK(conflicts[0].other_file_index == 0 && conflicts[0].other_line == 1);
+	}
+}
+
+int main()
+{
+	test_symbols();
+	test_namespaces();
+	test_comments_and_literals();
+	test_macros();
+	test_conflicts();
+	
+	return report_test_results("conglomeratecheck");
+}
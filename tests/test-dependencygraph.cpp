@@ -0,0 +1,255 @@
+#include "chibi-internal.h"
+#include "dependencygraph.h"
+#include "testing.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chibi;
+
+static ChibiLibrary * add_library(ChibiInfo & chibi_info, const char * name)
+{
+	ChibiLibrary * library = new ChibiLibrary();
+	library->name = name;
+	
+	CHECK(chibi_info.add_library(library));
+	
+	return library;
+}
+
+static void add_dependency(ChibiLibrary * library, const char * name, const ChibiLibraryDependency::Type type = ChibiLibraryDependency::kType_Generated)
+{
+	ChibiLibraryDependency library_dependency;
+	library_dependency.name = name;
+	library_dependency.type = type;
+	
+	library->library_dependencies.push_back(library_dependency);
+}
+
+static void build_graph(ChibiInfo & chibi_info)
+{
+	chibi_info.resolve_library_dependencies();
+	chibi_info.dependency_graph.build(chibi_info);
+}
+
+static std::vector<std::string> get_dependency_names(const ChibiInfo & chibi_info, const ChibiLibrary * library)
+{
+	std::vector<std::string> result;
+	
+	auto * library_dependencies = chibi_info.dependency_graph.get_all_library_dependencies(*library);
+	
+	if (library_dependencies != nullptr)
+	{
+		for (auto * library_dependency : *library_dependencies)
+			result.push_back(library_dependency->name);
+	}
+	
+	return result;
+}
+
+static void test_diamond()
+{
+	// app depends on a and b, which both depend on c
+	
+	ChibiInfo chibi_info;
+	
+	auto * app = add_library(chibi_info, "app");
+	auto * a = add_library(chibi_info, "a");
+	auto * b = add_library(chibi_info, "b");
+	auto * c = add_library(chibi_info, "c");
+	auto * unused = add_library(chibi_info, "unused");
+	
+	add_dependency(app, "a");
+	add_dependency(app, "b");
+	add_dependency(a, "c");
+	add_dependency(a, "dl", ChibiLibraryDependency::kType_Global);
+	add_dependency(b, "c");
+	add_dependency(b, "dl", ChibiLibraryDependency::kType_Find);
+	add_dependency(c, "m", ChibiLibraryDependency::kType_Global);
+	
+	build_graph(chibi_info);
+	
+	auto & graph = chibi_info.dependency_graph;
+	
+	CHECK(graph.has_cycles == false);
+	
+	CHECK(graph.nodes[c->id].level == 0);
+	CHECK(graph.nodes[a->id].level == 1);
+	CHECK(graph.nodes[b->id].level == 1);
+	CHECK(graph.nodes[app->id].level == 2);
+	CHECK(graph.nodes[unused->id].level == 0);
+	
+	auto & closure = graph.nodes[app->id].closure;
+	CHECK(closure.contains(a->id));
+	CHECK(closure.contains(b->id));
+	CHECK(closure.contains(c->id));
+	CHECK(closure.contains(app->id) == false);
+	CHECK(closure.contains(unused->id) == false);
+	
+	CHECK(graph.nodes[c->id].closure.contains(a->id) == false);
+	
+	// dependencies are listed breadth-first, each name only once. the first one found wins
+	
+	CHECK(get_dependency_names(chibi_info, app) == std::vector<std::string>({ "a", "b", "c", "dl", "m" }));
+	
+	auto * library_dependencies = graph.get_all_library_dependencies(*app);
+	CHECK(library_dependencies != nullptr && (*library_dependencies)[3]->type == ChibiLibraryDependency::kType_Global);
+	
+	CHECK(get_dependency_names(chibi_info, c) == std::vector<std::string>({ "m" }));
+	CHECK(get_dependency_names(chibi_info, unused).empty());
+	
+	// the result is computed once, and the same list is returned each time
+	
+	CHECK(graph.get_all_library_dependencies(*app) == library_dependencies);
+}
+
+static void test_cycles()
+{
+	// x -> y -> z -> x, with w depending on the cycle
+	
+	ChibiInfo chibi_info;
+	
+	auto * w = add_library(chibi_info, "w");
+	auto * x = add_library(chibi_info, "x");
+	auto * y = add_library(chibi_info, "y");
+	auto * z = add_library(chibi_info, "z");
+	
+	add_dependency(w, "x");
+	add_dependency(x, "y");
+	add_dependency(y, "z");
+	add_dependency(z, "x");
+	
+	build_graph(chibi_info);
+	
+	auto & graph = chibi_info.dependency_graph;
+	
+	CHECK(graph.has_cycles);
+	
+	// each library in the cycle depends on all of them, including itself
+	
+	for (auto * library : { x, y, z })
+	{
+		auto & closure = graph.nodes[library->id].closure;
+		
+		CHECK(closure.contains(x->id));
+		CHECK(closure.contains(y->id));
+		CHECK(closure.contains(z->id));
+		CHECK(closure.contains(w->id) == false);
+	}
+	
+	auto & closure = graph.nodes[w->id].closure;
+	CHECK(closure.contains(x->id) && closure.contains(y->id) && closure.contains(z->id));
+	
+	// the walk stops at libraries it has seen before, including the library itself
+	
+	CHECK(get_dependency_names(chibi_info, x) == std::vector<std::string>({ "y", "z" }));
+	CHECK(get_dependency_names(chibi_info, w) == std::vector<std::string>({ "x", "y", "z" }));
+	
+	// a library depending on itself
+	
+	ChibiInfo self_chibi_info;
+	
+	auto * self = add_library(self_chibi_info, "self");
+	add_dependency(self, "self");
+	
+	build_graph(self_chibi_info);
+	
+	CHECK(self_chibi_info.dependency_graph.has_cycles);
+	CHECK(self_chibi_info.dependency_graph.nodes[self->id].closure.contains(self->id));
+	CHECK(get_dependency_names(self_chibi_info, self).empty());
+}
+
+static void test_unresolved()
+{
+	ChibiInfo chibi_info;
+	
+	auto * app = add_library(chibi_info, "app");
+	auto * a = add_library(chibi_info, "a");
+	
+	add_dependency(app, "a");
+	add_dependency(a, "missing");
+	
+	build_graph(chibi_info);
+	
+	auto & graph = chibi_info.dependency_graph;
+	
+	CHECK(graph.has_cycles == false);
+	CHECK(graph.nodes[app->id].closure.contains(a->id));
+	
+	// listing the dependencies fails for every library which (indirectly) depends on the missing library
+	
+	CHECK(graph.get_all_library_dependencies(*a) == nullptr);
+	CHECK(graph.get_all_library_dependencies(*app) == nullptr);
+	CHECK(graph.get_all_library_dependencies(*app) == nullptr);
+}
+
+static void test_concurrent_queries()
+{
+	// a chain of libraries, each depending on all of the libraries before it
+	
+	ChibiInfo chibi_info;
+	
+	const int kNumLibraries = 200;
+	
+	for (int i = 0; i < kNumLibraries; ++i)
+	{
+		auto * library = add_library(chibi_info, ("lib" + std::to_string(i)).c_str());
+		
+		for (int j = i - 1; j >= 0; --j)
+			add_dependency(library, ("lib" + std::to_string(j)).c_str());
+	}
+	
+	build_graph(chibi_info);
+	
+	auto & graph = chibi_info.dependency_graph;
+	
+	const int kNumThreads = 8;
+	
+	std::vector<std::vector<const std::vector<const ChibiLibraryDependency*>*>> results(kNumThreads);
+	
+	std::vector<std::thread> threads;
+	
+	for (int t = 0; t < kNumThreads; ++t)
+	{
+		threads.push_back(std::thread([&, t]()
+			{
+				for (int i = 0; i < kNumLibraries; ++i)
+				{
+					const int id = (i * (t + 1)) % kNumLibraries;
+					
+					results[t].push_back(graph.get_all_library_dependencies(*chibi_info.libraries[id]));
+				}
+			}));
+	}
+	
+	for (auto & thread : threads)
+		thread.join();
+	
+	// every thread sees the same list for the same library
+	
+	for (int t = 0; t < kNumThreads; ++t)
+	{
+		for (int i = 0; i < kNumLibraries; ++i)
+		{
+			const int id = (i * (t + 1)) % kNumLibraries;
+			
+			auto * library_dependencies = results[t][i];
+			
+			CHECK(library_dependencies == graph.get_all_library_dependencies(*chibi_info.libraries[id]));
+			CHECK(library_dependencies != nullptr && (int)library_dependencies->size() == id);
+		}
+	}
+	
+	CHECK(graph.nodes[kNumLibraries - 1].level == kNumLibraries - 1);
+}
+
+int main()
+{
+	test_diamond();
+	test_cycles();
+	test_unresolved();
+	test_concurrent_queries();
+	
+	return report_test_results("dependencygraph");
+}
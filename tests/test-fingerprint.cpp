@@ -0,0 +1,156 @@
+#include "filesystem.h"
+#include "fingerprint.h"
+#include "testing.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace chibi;
+using namespace chibi_filesystem;
+
+static const char * kInputFilename = "test-fingerprint-input.tmp";
+static const char * kOutputFilename = "test-fingerprint-output.tmp";
+static const char * kMissingFilename = "test-fingerprint-missing.tmp";
+static const char * kFingerprintFilename = "test-fingerprint.tmp";
+
+static int64_t get_mtime(const char * filename)
+{
+	int64_t mtime;
+	int64_t size;
+	
+	if (!get_file_info(filename, mtime, size))
+		return -1;
+	
+	return mtime;
+}
+
+static void test_racy_inputs()
+{
+	CHECK(write_file_atomically(kInputFilename, "input", 5));
+	
+	const int64_t mtime = get_mtime(kInputFilename);
+	CHECK(mtime != -1);
+	
+	// an input modified just before chibi started reading may be modified again within the same timestamp. this makes
+	// the fingerprint unreliable, and add_input says so
+	
+	Fingerprint fingerprint;
+	CHECK(fingerprint.add_input(kInputFilename, get_current_time()) == false);
+	CHECK(fingerprint.add_input(kInputFilename, mtime) == false);
+	CHECK(fingerprint.add_input(kInputFilename, mtime + 1000000000ll) == false);
+	CHECK(fingerprint.add_input(kInputFilename, mtime + 3000000000ll));
+	
+	// missing inputs are recorded as such, and are never racy
+	
+	CHECK(fingerprint.add_input(kMissingFilename, mtime));
+	CHECK(fingerprint.entries.back().mtime == -1);
+	CHECK(fingerprint.entries.size() == 5);
+}
+
+static void test_up_to_date()
+{
+	remove(kMissingFilename);
+	
+	CHECK(write_file_atomically(kInputFilename, "input", 5));
+	CHECK(write_file_atomically(kOutputFilename, "output", 6));
+	
+	const int64_t start_time = get_mtime(kInputFilename) + 3000000000ll;
+	
+	Fingerprint fingerprint;
+	fingerprint.arguments = "cwd\n-g\nsrc\ndst";
+	CHECK(fingerprint.add_input(kInputFilename, start_time));
+	CHECK(fingerprint.add_input(kMissingFilename, start_time));
+	fingerprint.add_output(kOutputFilename);
+	
+	CHECK(fingerprint.is_up_to_date("cwd\n-g\nsrc\ndst"));
+	CHECK(fingerprint.is_up_to_date("cwd\n-g\nsrc\ndst\n-compact") == false);
+	
+	// the recorded state survives a save and load
+	
+	CHECK(fingerprint.save(kFingerprintFilename));
+	
+	Fingerprint loaded_fingerprint;
+	CHECK(loaded_fingerprint.load(kFingerprintFilename));
+	CHECK(loaded_fingerprint.arguments == fingerprint.arguments);
+	CHECK(loaded_fingerprint.entries.size() == 3);
+	CHECK(loaded_fingerprint.is_up_to_date(fingerprint.arguments));
+	
+	for (size_t i = 0; i < fingerprint.entries.size() && i < loaded_fingerprint.entries.size(); ++i)
+	{
+		CHECK(loaded_fingerprint.entries[i].path == fingerprint.entries[i].path);
+		CHECK(loaded_fingerprint.entries[i].mtime == fingerprint.entries[i].mtime);
+	}
+	
+	// a different modification time means the file changed, even when it's older
+	
+	loaded_fingerprint.entries[0].mtime--;
+	CHECK(loaded_fingerprint.is_up_to_date(fingerprint.arguments) == false);
+	
+	// a missing input which now exists
+	
+	CHECK(write_file_atomically(kMissingFilename, "", 0));
+	CHECK(fingerprint.is_up_to_date(fingerprint.arguments) == false);
+	remove(kMissingFilename);
+	CHECK(fingerprint.is_up_to_date(fingerprint.arguments));
+	
+	// a deleted output
+	
+	remove(kOutputFilename);
+	CHECK(fingerprint.is_up_to_date(fingerprint.arguments) == false);
+	
+	// a fingerprint without any entries never is up to date
+	
+	Fingerprint empty_fingerprint;
+	empty_fingerprint.arguments = fingerprint.arguments;
+	CHECK(empty_fingerprint.is_up_to_date(fingerprint.arguments) == false);
+}
+
+static void test_invalid_files()
+{
+	Fingerprint fingerprint;
+	fingerprint.arguments = "arguments";
+	fingerprint.add_output(kOutputFilename);
+	CHECK(fingerprint.save(kFingerprintFilename));
+	
+	std::vector<char> data;
+	CHECK(read_file(kFingerprintFilename, data));
+	
+	Fingerprint loaded_fingerprint;
+	
+	// truncated files fail to load, and leave the fingerprint empty
+	
+	for (size_t size = 0; size < data.size(); ++size)
+	{
+		CHECK(write_file_atomically(kFingerprintFilename, data.data(), size));
+		CHECK(loaded_fingerprint.load(kFingerprintFilename) == false);
+		CHECK(loaded_fingerprint.entries.empty() && loaded_fingerprint.arguments.empty());
+	}
+	
+	// a different magic or version
+	
+	for (size_t i : { 0, 8 })
+	{
+		std::vector<char> modified_data = data;
+		modified_data[i]++;
+		
+		CHECK(write_file_atomically(kFingerprintFilename, modified_data.data(), modified_data.size()));
+		CHECK(loaded_fingerprint.load(kFingerprintFilename) == false);
+	}
+	
+	remove(kFingerprintFilename);
+	CHECK(loaded_fingerprint.load(kFingerprintFilename) == false);
+}
+
+int main()
+{
+	test_racy_inputs();
+	test_up_to_date();
+	test_invalid_files();
+	
+	remove(kInputFilename);
+	remove(kOutputFilename);
+	remove(kMissingFilename);
+	
+	return report_test_results("fingerprint");
+}
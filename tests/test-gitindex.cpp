@@ -0,0 +1,408 @@
+#include "filesystem.h"
+#include "gitindex.h"
+#include "testing.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace chibi;
+using namespace chibi_filesystem;
+
+struct IndexEntry
+{
+	std::string path;
+	
+	uint32_t mode = 0100644;
+	uint32_t mtime_seconds = 0;
+	uint32_t mtime_nanoseconds = 0;
+	uint32_t size = 0;
+	
+	int stage = 0;
+	uint16_t extended_flags = 0;
+};
+
+static void write_uint32_be(std::vector<uint8_t> & data, const uint32_t value)
+{
+	data.push_back(uint8_t(value >> 24));
+	data.push_back(uint8_t(value >> 16));
+	data.push_back(uint8_t(value >> 8));
+	data.push_back(uint8_t(value >> 0));
+}
+
+static void write_uint16_be(std::vector<uint8_t> & data, const uint16_t value)
+{
+	data.push_back(uint8_t(value >> 8));
+	data.push_back(uint8_t(value >> 0));
+}
+
+// encodes a number the way git does for the prefix compressed paths in version 4 indices. each byte holds seven bits,
+// and each continuation adds one to the value, so there is only one way to encode each number
+static void write_varint(std::vector<uint8_t> & data, size_t value)
+{
+	uint8_t bytes[16];
+	int pos = sizeof(bytes) - 1;
+	
+	bytes[pos] = value & 127;
+	
+	while (value >>= 7)
+		bytes[--pos] = 128 | (--value & 127);
+	
+	data.insert(data.end(), bytes + pos, bytes + sizeof(bytes));
+}
+
+// builds an index file the way git writes it
+static std::vector<uint8_t> build_index(const uint32_t version, const int hash_size, const std::vector<IndexEntry> & entries)
+{
+	std::vector<uint8_t> data;
+	
+	data.push_back('D');
+	data.push_back('I');
+	data.push_back('R');
+	data.push_back('C');
+	write_uint32_be(data, version);
+	write_uint32_be(data, (uint32_t)entries.size());
+	
+	std::string previous_path;
+	
+	for (auto & entry : entries)
+	{
+		const size_t entry_begin = data.size();
+		
+		write_uint32_be(data, 0); // ctime
+		write_uint32_be(data, 0);
+		write_uint32_be(data, entry.mtime_seconds);
+		write_uint32_be(data, entry.mtime_nanoseconds);
+		write_uint32_be(data, 0); // dev
+		write_uint32_be(data, 0); // ino
+		write_uint32_be(data, entry.mode);
+		write_uint32_be(data, 0); // uid
+		write_uint32_be(data, 0); // gid
+		write_uint32_be(data, entry.size);
+		
+		data.insert(data.end(), hash_size, 0);
+		
+		const size_t name_length = entry.path.size() < 0xfff ? entry.path.size() : 0xfff;
+		
+		write_uint16_be(data, uint16_t(
+			(entry.extended_flags != 0 ? 0x4000 : 0) |
+			(entry.stage << 12) |
+			name_length));
+		
+		if (entry.extended_flags != 0)
+			write_uint16_be(data, entry.extended_flags);
+		
+		if (version == 4)
+		{
+			size_t common = 0;
+			
+			while (common < previous_path.size() && common < entry.path.size() && previous_path[common] == entry.path[common])
+				common++;
+			
+			write_varint(data, previous_path.size() - common);
+			
+			data.insert(data.end(), entry.path.begin() + common, entry.path.end());
+			data.push_back(0);
+		}
+		else
+		{
+			data.insert(data.end(), entry.path.begin(), entry.path.end());
+			
+			const size_t entry_size = ((data.size() - entry_begin) + 8) & ~size_t(7);
+			
+			data.resize(entry_begin + entry_size, 0);
+		}
+		
+		previous_path = entry.path;
+	}
+	
+	data.insert(data.end(), hash_size, 0); // checksum
+	
+	return data;
+}
+
+static bool load_index(GitIndex & index, const std::vector<uint8_t> & data, const int hash_size)
+{
+	const char * filename = "test-gitindex.tmp";
+	
+	if (!write_file_atomically(filename, data.data(), data.size()))
+		return false;
+	
+	return index.load(filename, hash_size);
+}
+
+static IndexEntry make_entry(const std::string & path, const uint32_t size = 0)
+{
+	IndexEntry entry;
+	entry.path = path;
+	entry.size = size;
+	return entry;
+}
+
+static void test_versions()
+{
+	std::vector<IndexEntry> entries;
+	
+	entries.push_back(make_entry("a.cpp", 1));
+	entries.push_back(make_entry("src/b.cpp", 2));
+	entries.push_back(make_entry("src/detail/c.cpp", 3));
+	entries.push_back(make_entry("src2/d.cpp", 4));
+	
+	entries[1].mtime_seconds = 1234;
+	entries[1].mtime_nanoseconds = 5678;
+	
+	for (uint32_t version = 2; version <= 4; ++version)
+	{
+		for (int hash_size : { 20, 32 })
+		{
+			GitIndex index;
+			CHECK(load_index(index, build_index(version, hash_size, entries), hash_size));
+			
+			CHECK(index.paths.size() == entries.size());
+			CHECK(index.stats.size() == entries.size());
+			
+			for (size_t i = 0; i < entries.size() && i < index.paths.size(); ++i)
+			{
+				CHECK(index.paths[i] == entries[i].path);
+				CHECK(index.stats[i].size == entries[i].size);
+			}
+			
+			if (index.stats.size() >= 2)
+			{
+				CHECK(index.stats[1].mtime_seconds == 1234);
+				CHECK(index.stats[1].mtime_nanoseconds == 5678);
+			}
+		}
+	}
+}
+
+static void test_prefix_compression()
+{
+	// strip counts of 127 and below take a single byte. 128 is the first to need two, and 16512 the first to need three
+	
+	std::vector<IndexEntry> entries;
+	
+	entries.push_back(make_entry("a/" + std::string(127, 'x')));
+	entries.push_back(make_entry("a/y"));
+	entries.push_back(make_entry("a/z" + std::string(128, 'x')));
+	entries.push_back(make_entry("a/zz"));
+	entries.push_back(make_entry("b/" + std::string(16600, 'x')));
+	entries.push_back(make_entry("b/y"));
+	entries.push_back(make_entry("c"));
+	
+	const std::vector<uint8_t> data = build_index(4, 20, entries);
+	
+	GitIndex index;
+	CHECK(load_index(index, data, 20));
+	
+	CHECK(index.paths.size() == entries.size());
+	
+	for (size_t i = 0; i < entries.size() && i < index.paths.size(); ++i)
+		CHECK(index.paths[i] == entries[i].path);
+	
+	// a strip count larger than the previous path is invalid
+	
+	std::vector<IndexEntry> invalid_entries;
+	invalid_entries.push_back(make_entry("a"));
+	
+	std::vector<uint8_t> invalid_data = build_index(4, 20, invalid_entries);
+	
+	const size_t strip_offset = 12 + 40 + 20 + 2;
+	CHECK(invalid_data[strip_offset] == 0);
+	invalid_data[strip_offset] = 1;
+	
+	CHECK(load_index(index, invalid_data, 20) == false);
+}
+
+static void test_skipped_entries()
+{
+	std::vector<IndexEntry> entries;
+	
+	entries.push_back(make_entry("conflict.cpp"));
+	entries.push_back(make_entry("conflict.cpp"));
+	entries.push_back(make_entry("conflict.cpp"));
+	entries.push_back(make_entry("intent-to-add.cpp"));
+	entries.push_back(make_entry("sparse.cpp"));
+	entries.push_back(make_entry("submodule"));
+	
+	entries[0].stage = 1;
+	entries[1].stage = 2;
+	entries[2].stage = 3;
+	entries[3].extended_flags = 0x2000; // intent to add
+	entries[4].extended_flags = 0x4000; // skip worktree
+	entries[5].mode = 0160000; // gitlink
+	
+	for (uint32_t version = 3; version <= 4; ++version)
+	{
+		GitIndex index;
+		CHECK(load_index(index, build_index(version, 20, entries), 20));
+		
+		CHECK(index.paths.size() == 2);
+		
+		if (index.paths.size() == 2)
+		{
+			CHECK(index.paths[0] == "conflict.cpp");
+			CHECK(index.paths[1] == "intent-to-add.cpp");
+		}
+	}
+	
+	// extended flags aren't allowed in version 2 indices
+	
+	GitIndex index;
+	CHECK(load_index(index, build_index(2, 20, entries), 20) == false);
+}
+
+static void test_invalid_indices()
+{
+	std::vector<IndexEntry> entries;
+	entries.push_back(make_entry("a.cpp"));
+	entries.push_back(make_entry("b.cpp"));
+	
+	GitIndex index;
+	
+	CHECK(load_index(index, build_index(1, 20, entries), 20) == false);
+	CHECK(load_index(index, build_index(5, 20, entries), 20) == false);
+	
+	std::vector<uint8_t> data = build_index(2, 20, entries);
+	data[0] = 'X';
+	CHECK(load_index(index, data, 20) == false);
+	
+	// truncating the file anywhere inside the entries must fail, rather than read past the end
+	
+	for (uint32_t version = 2; version <= 4; ++version)
+	{
+		data = build_index(version, 20, entries);
+		
+		const size_t entries_end = data.size() - 20;
+		
+		for (size_t size = 0; size < entries_end; ++size)
+		{
+			std::vector<uint8_t> truncated_data(data.begin(), data.begin() + size);
+			
+			CHECK(load_index(index, truncated_data, 20) == false);
+		}
+	}
+}
+
+static void test_list_files()
+{
+	GitIndex index;
+	index.paths.push_back("a.cpp");
+	index.paths.push_back("src/b.cpp");
+	index.paths.push_back("src/detail/c.cpp");
+	index.paths.push_back("src.cpp");
+	index.paths.push_back("src2/d.cpp");
+	index.stats.resize(index.paths.size());
+	
+	std::vector<std::string> files;
+	index.list_files("src", false, "out", files);
+	CHECK(files == std::vector<std::string>({ "out/b.cpp" }));
+	
+	files.clear();
+	index.list_files("src", true, "out", files);
+	CHECK(files == std::vector<std::string>({ "out/b.cpp", "out/detail/c.cpp" }));
+	
+	files.clear();
+	index.list_files("", false, "root", files);
+	CHECK(files == std::vector<std::string>({ "root/a.cpp", "root/src.cpp" }));
+	
+	files.clear();
+	index.list_files("missing", true, "out", files);
+	CHECK(files.empty());
+}
+
+static void test_is_modified()
+{
+	const char * worktree_path = "test-gitindex-worktree";
+	
+	CHECK(create_directories(worktree_path));
+	CHECK(write_file_atomically("test-gitindex-worktree/file.cpp", "12345", 5));
+	
+	int64_t mtime;
+	int64_t size;
+	CHECK(get_file_info("test-gitindex-worktree/file.cpp", mtime, size));
+	
+	GitIndex index;
+	index.worktree_path = worktree_path;
+	index.paths.push_back("file.cpp");
+	
+	GitIndex::FileStat stat;
+	stat.mtime_seconds = uint32_t(mtime / 1000000000);
+	stat.mtime_nanoseconds = uint32_t(mtime % 1000000000);
+	stat.size = 5;
+	index.stats.push_back(stat);
+	
+	CHECK(index.is_modified("test-gitindex-worktree/file.cpp") == false);
+	CHECK(index.is_modified("test-gitindex-worktree/./sub/../file.cpp") == false);
+	CHECK(index.is_modified("test-gitindex-worktree/untracked.cpp"));
+	CHECK(index.is_modified("elsewhere/file.cpp"));
+	
+	// git built without nanosecond support records zero nanoseconds
+	
+	index.stats[0].mtime_nanoseconds = 0;
+	CHECK(index.is_modified("test-gitindex-worktree/file.cpp") == false);
+	
+	index.stats[0].mtime_seconds++;
+	CHECK(index.is_modified("test-gitindex-worktree/file.cpp"));
+	
+	index.stats[0] = stat;
+	index.stats[0].size = 6;
+	CHECK(index.is_modified("test-gitindex-worktree/file.cpp"));
+}
+
+static void test_find_index()
+{
+	CHECK(create_directories("test-gitindex-repository/.git"));
+	CHECK(create_directories("test-gitindex-repository/sub"));
+	CHECK(write_file_atomically("test-gitindex-repository/.git/HEAD", "ref: refs/heads/main\n", 21));
+	
+	const std::vector<uint8_t> data = build_index(2, 20, { make_entry("sub/file.cpp") });
+	CHECK(write_file_atomically("test-gitindex-repository/.git/index", data.data(), data.size()));
+	
+	GitIndexCache cache;
+	
+	const GitIndex * index = cache.find_index("test-gitindex-repository/sub");
+	CHECK(index != nullptr);
+	if (index != nullptr)
+	{
+		CHECK(index->worktree_path == "test-gitindex-repository");
+		CHECK(index->paths.size() == 1);
+	}
+	
+	// each repository is loaded once, and lookups are remembered by path
+	
+	CHECK(cache.find_index("test-gitindex-repository") == index);
+	CHECK(cache.indices.size() == 1);
+	CHECK(cache.indices_by_path.size() == 2);
+	
+	CHECK(remove("test-gitindex-repository/.git/HEAD") == 0);
+	CHECK(cache.find_index("test-gitindex-repository/sub") == index);
+	
+	// paths outside of a repository are remembered too
+	
+	CHECK(cache.find_index("test-gitindex-repository/other") == nullptr);
+	CHECK(cache.indices_by_path.count("test-gitindex-repository/other") == 1);
+}
+
+static void test_normalize_path()
+{
+	CHECK(normalize_path("/a/./b//c/../d") == "/a/b/d");
+	CHECK(normalize_path("a/b/") == "a/b");
+	CHECK(normalize_path("a/..") == "");
+	CHECK(normalize_path("../a/../../b") == "../../b");
+	CHECK(normalize_path("/") == "/");
+}
+
+int main()
+{
+	test_versions();
+	test_prefix_compression();
+	test_skipped_entries();
+	test_invalid_indices();
+	test_list_files();
+	test_is_modified();
+	test_find_index();
+	test_normalize_path();
+	
+	return report_test_results("gitindex");
+}
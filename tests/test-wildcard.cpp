@@ -0,0 +1,174 @@
+#include "testing.h"
+#include "wildcard.h"
+
+using namespace chibi;
+
+static bool match(const char * pattern, const char * text)
+{
+	WildcardPattern compiled_pattern;
+	compiled_pattern.add(pattern, ';');
+	
+	return compiled_pattern.match(text);
+}
+
+static bool match_extensions(const char * extensions, const char * text)
+{
+	WildcardPattern compiled_pattern;
+	compiled_pattern.set_extensions(extensions, '|');
+	
+	return compiled_pattern.match(text);
+}
+
+static void test_separators()
+{
+	// every element is tried from the start of the text. only the first element used to ever match
+	
+	CHECK(match("*.h;*.cpp", "src/a.h"));
+	CHECK(match("*.h;*.cpp", "src/a.cpp"));
+	CHECK(match("*.h;*.cpp;*.mm", "src/a.mm"));
+	CHECK(match("*.h;*.cpp", "src/a.mm") == false);
+	CHECK(match("main.cpp;main.c", "src/main.c"));
+	CHECK(match("main.cpp;main.c", "src/main.cc") == false);
+	
+	// elements are split on the separator only. '|' is an ordinary character in a pattern
+	
+	CHECK(match("a|b", "a|b"));
+	CHECK(match("a|b", "a") == false);
+	
+	// an empty element matches an empty name only
+	
+	CHECK(match("*.h;", "a.h"));
+	CHECK(match("*.h;", "a.cpp") == false);
+	
+	// patterns may be added in parts
+	
+	WildcardPattern pattern;
+	pattern.add("*.h", ';');
+	pattern.add("*.cpp", ';');
+	CHECK(pattern.match("a.h"));
+	CHECK(pattern.match("a.cpp"));
+	CHECK(pattern.match("a.c") == false);
+}
+
+static void test_extensions()
+{
+	CHECK(match_extensions("cpp|mm|c", "src/a.cpp"));
+	CHECK(match_extensions("cpp|mm|c", "src/a.mm"));
+	CHECK(match_extensions("cpp|mm|c", "src/a.c"));
+	CHECK(match_extensions("cpp|mm|c", "src/a.cc") == false);
+	CHECK(match_extensions("cpp|mm|c", "src/a.cp") == false);
+	
+	// the extension of the file is compared case-insensitively
+	
+	CHECK(match_extensions("cpp", "src/A.CPP"));
+	
+	// the extension is everything after the last dot
+	
+	CHECK(match_extensions("c", "src/a.b.c"));
+	CHECK(match_extensions("b", "src/a.b.c") == false);
+	CHECK(match_extensions("cpp", "src.cpp/readme") == false);
+	
+	// files without an extension only match an empty extension
+	
+	CHECK(match_extensions("cpp", "src/cpp") == false);
+	CHECK(match_extensions("cpp|", "src/makefile"));
+	CHECK(match_extensions("cpp", "src/makefile") == false);
+}
+
+static void test_names()
+{
+	// literals
+	
+	CHECK(match("main.cpp", "main.cpp"));
+	CHECK(match("main.cpp", "src/main.cpp"));
+	CHECK(match("main.cpp", "src/main.cpp2") == false);
+	CHECK(match("main.cpp", "src/xmain.cpp") == false);
+	
+	// prefixes and suffixes
+	
+	CHECK(match("test_*", "src/test_a.cpp"));
+	CHECK(match("test_*", "src/atest_.cpp") == false);
+	CHECK(match("test_*", "test_/a.cpp") == false);
+	CHECK(match("*.cpp", "src/.cpp"));
+	CHECK(match("*.cpp", "src.cpp/a.h") == false);
+	CHECK(match("*", "src/a"));
+	
+	// '?' matches exactly one character
+	
+	CHECK(match("a?.cpp", "ab.cpp"));
+	CHECK(match("a?.cpp", "a.cpp") == false);
+	CHECK(match("a?.cpp", "abc.cpp") == false);
+	
+	// character classes
+	
+	CHECK(match("[a-c]x", "bx"));
+	CHECK(match("[a-c]x", "dx") == false);
+	CHECK(match("[!a-c]x", "dx"));
+	CHECK(match("[!a-c]x", "bx") == false);
+	CHECK(match("[^a-c]x", "dx"));
+	CHECK(match("[]a]x", "]x"));
+	CHECK(match("[]a]x", "ax"));
+	CHECK(match("[ab-]x", "-x"));
+	CHECK(match("*.[ch]", "a.c"));
+	CHECK(match("*.[ch]", "a.h"));
+	CHECK(match("*.[ch]", "a.m") == false);
+	
+	// an unterminated class is an ordinary character
+	
+	CHECK(match("a[b", "a[b"));
+	CHECK(match("a[b", "ab") == false);
+	
+	// stars in the middle
+	
+	CHECK(match("a*b*c", "axxbyyc"));
+	CHECK(match("a*b*c", "axxbyy") == false);
+	CHECK(match("*a*", "bab"));
+}
+
+static void test_paths()
+{
+	// elements with a '/' match the end of the path, starting at a directory boundary
+	
+	CHECK(match("src/*.cpp", "root/src/a.cpp"));
+	CHECK(match("src/*.cpp", "src/a.cpp"));
+	CHECK(match("src/*.cpp", "root/xsrc/a.cpp") == false);
+	CHECK(match("src/*.cpp", "root/src/a.cpp/b.h") == false);
+	
+	// '*' and '?' stay within a directory, '**' crosses directories
+	
+	CHECK(match("src/*.cpp", "root/src/sub/a.cpp") == false);
+	CHECK(match("src/?/a.cpp", "root/src/x/a.cpp"));
+	CHECK(match("src/?a.cpp", "root/src//a.cpp") == false);
+	CHECK(match("src/**.cpp", "root/src/sub/a.cpp"));
+	CHECK(match("src/**.cpp", "root/src/a.cpp"));
+	CHECK(match("src/**/*.cpp", "root/src/sub/deeper/a.cpp"));
+	CHECK(match("src/**/*.cpp", "root/src/a.cpp") == false);
+	CHECK(match("a*/b.cpp", "root/ab/b.cpp"));
+	CHECK(match("a*/b.cpp", "root/a/c/b.cpp") == false);
+	
+	// classes never match the path separator
+	
+	CHECK(match("x/src[!a]a.cpp", "x/src/a.cpp") == false);
+	CHECK(match("x/src[!a]a.cpp", "x/srcba.cpp"));
+	
+	// elements starting with a '/' match the entire path
+	
+	CHECK(match("/src/*.cpp", "/src/a.cpp"));
+	CHECK(match("/src/*.cpp", "/root/src/a.cpp") == false);
+	
+	// a leading '**' matches any number of leading directories
+	
+	CHECK(match("**/detail/*.h", "a/b/detail/x.h"));
+	CHECK(match("**/detail/*.h", "a/b/detail/c/x.h") == false);
+	CHECK(match("**.h", "a/b/x.h"));
+}
+
+int main()
+{
+	test_separators();
+	test_extensions();
+	test_names();
+	test_paths();
+	
+	return report_test_results("wildcard");
+}
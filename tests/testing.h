@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdio.h>
+
+// each test is an executable of its own, which checks a single module. a failed check is reported, after which the
+// test continues, so a single run shows all of the failures. the exit code tells ctest whether any check failed
+
+static int s_num_failed_checks = 0;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			s_num_failed_checks++; \
+		} \
+	} while (false)
+
+static int report_test_results(const char * name)
+{
+	if (s_num_failed_checks != 0)
+	{
+		printf("%s: %d checks failed\n", name, s_num_failed_checks);
+		return 1;
+	}
+	
+	printf("%s: all checks passed\n", name);
+	return 0;
+}
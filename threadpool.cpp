@@ -0,0 +1,244 @@
+#include "threadpool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chibi
+{
+	struct Task
+	{
+		std::function<void()> function;
+
+		TaskGroup * group = nullptr;
+	};
+
+	/**
+	 * A queue of tasks. Each worker thread has its own queue. The owner adds and removes tasks at the back, so the
+	 * most recently added (and likely cache-hot) tasks are executed first. Other threads steal from the front.
+	 */
+	struct TaskQueue
+	{
+		std::mutex mutex;
+
+		std::deque<Task> tasks;
+
+		void push(Task && task)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+		}
+
+		bool pop(Task & task)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (tasks.empty())
+				return false;
+			task = std::move(tasks.back());
+			tasks.pop_back();
+			return true;
+		}
+
+		bool steal(Task & task)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (tasks.empty())
+				return false;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+			return true;
+		}
+	};
+
+	// the index of the task queue owned by the current thread. threads outside of the thread pool share the last queue
+	static thread_local int t_queue_index = -1;
+
+	struct ThreadPool
+	{
+		std::vector<std::unique_ptr<TaskQueue>> queues;
+
+		std::vector<std::thread> threads;
+
+		std::atomic<int> num_queued_tasks;
+
+		// used to put threads to sleep when there's no work to be done
+		std::mutex sleep_mutex;
+		std::condition_variable sleep_cond;
+
+		bool stop = false;
+
+		ThreadPool()
+			: num_queued_tasks(0)
+		{
+			int num_threads = (int)std::thread::hardware_concurrency();
+
+			if (num_threads < 1)
+				num_threads = 1;
+
+			// note : the thread which waits for a task group helps out executing tasks, so we create one thread less
+
+			const int num_workers = num_threads - 1;
+
+			for (int i = 0; i < num_workers + 1; ++i)
+				queues.emplace_back(new TaskQueue());
+
+			for (int i = 0; i < num_workers; ++i)
+			{
+				threads.emplace_back([this, i]()
+					{
+						t_queue_index = i;
+
+						worker();
+					});
+			}
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::unique_lock<std::mutex> lock(sleep_mutex);
+				stop = true;
+			}
+
+			sleep_cond.notify_all();
+
+			for (auto & thread : threads)
+				thread.join();
+		}
+
+		void add(Task && task)
+		{
+			const int queue_index =
+				t_queue_index >= 0
+				? t_queue_index
+				: (int)queues.size() - 1;
+
+			queues[queue_index]->push(std::move(task));
+
+			num_queued_tasks++;
+
+			// note : we briefly take the lock to make sure sleeping threads either see the new task count, or are
+			//        already waiting on the condition variable and receive the notification
+
+			{
+				std::lock_guard<std::mutex> lock(sleep_mutex);
+			}
+
+			sleep_cond.notify_one();
+		}
+
+		bool get_task(Task & task)
+		{
+			if (num_queued_tasks == 0)
+				return false;
+
+			const int num_queues = (int)queues.size();
+
+			const int queue_index =
+				t_queue_index >= 0
+				? t_queue_index
+				: num_queues - 1;
+
+			bool found = queues[queue_index]->pop(task);
+
+			// steal a task from one of the other queues
+
+			for (int i = 1; i < num_queues && found == false; ++i)
+				found = queues[(queue_index + i) % num_queues]->steal(task);
+
+			if (found)
+				num_queued_tasks--;
+
+			return found;
+		}
+
+		void run(Task & task)
+		{
+			task.function();
+
+			task.function = nullptr;
+
+			if (--task.group->num_pending == 0)
+			{
+				// wake up threads waiting for the task group to finish
+
+				{
+					std::lock_guard<std::mutex> lock(sleep_mutex);
+				}
+
+				sleep_cond.notify_all();
+			}
+		}
+
+		void worker()
+		{
+			for (;;)
+			{
+				Task task;
+
+				if (get_task(task))
+				{
+					run(task);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(sleep_mutex);
+
+				sleep_cond.wait(lock, [this]() { return stop || num_queued_tasks > 0; });
+
+				if (stop)
+					break;
+			}
+		}
+
+		void wait(TaskGroup & group)
+		{
+			while (group.num_pending > 0)
+			{
+				Task task;
+
+				if (get_task(task))
+				{
+					run(task);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(sleep_mutex);
+
+				sleep_cond.wait(lock, [&]() { return group.num_pending == 0 || num_queued_tasks > 0; });
+			}
+		}
+	};
+
+	static ThreadPool & get_thread_pool()
+	{
+		static ThreadPool thread_pool;
+
+		return thread_pool;
+	}
+
+	void TaskGroup::add(std::function<void()> && function)
+	{
+		num_pending++;
+
+		Task task;
+		task.function = std::move(function);
+		task.group = this;
+
+		get_thread_pool().add(std::move(task));
+	}
+
+	void TaskGroup::wait()
+	{
+		if (num_pending > 0)
+			get_thread_pool().wait(*this);
+	}
+
+	int get_thread_count()
+	{
+		return (int)get_thread_pool().threads.size() + 1;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+namespace chibi
+{
+	/**
+	 * A group of tasks executed on chibi's shared worker threads. Tasks may add new tasks to the
+	 * group they belong to. wait() blocks until all tasks in the group have finished, and helps
+	 * out executing pending tasks while it waits, so waiting from within a task is allowed.
+	 */
+	struct TaskGroup
+	{
+		std::atomic<int> num_pending;
+
+		TaskGroup()
+			: num_pending(0)
+		{
+		}
+
+		~TaskGroup()
+		{
+			wait();
+		}
+
+		TaskGroup(const TaskGroup &) = delete;
+		TaskGroup & operator=(const TaskGroup &) = delete;
+
+		void add(std::function<void()> && task);
+
+		void wait();
+	};
+
+	/**
+	 * Returns the number of threads tasks are executed on, including the thread which waits for them.
+	 */
+	int get_thread_count();
+}
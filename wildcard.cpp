@@ -0,0 +1,342 @@
+#include "wildcard.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace chibi
+{
+	void WildcardPattern::add(const char * pattern, const char separator)
+	{
+		for (;;)
+		{
+			const char * end = strchr(pattern, separator);
+			
+			if (end == nullptr)
+			{
+				add_element(pattern, pattern + strlen(pattern));
+				break;
+			}
+			
+			add_element(pattern, end);
+			
+			pattern = end + 1;
+		}
+	}
+	
+	void WildcardPattern::set_extensions(const char * in_extensions, const char separator)
+	{
+		is_extension_set = true;
+		
+		for (;;)
+		{
+			const char * end = strchr(in_extensions, separator);
+			
+			if (end == nullptr)
+			{
+				extensions.push_back(in_extensions);
+				break;
+			}
+			
+			extensions.push_back(std::string(in_extensions, end));
+			
+			in_extensions = end + 1;
+		}
+	}
+	
+	void WildcardPattern::add_element(const char * begin, const char * end)
+	{
+		Element element;
+		
+		element.anchored = begin < end && begin[0] == '/';
+		
+		for (const char * ptr = begin; ptr < end; )
+		{
+			Token token;
+			token.type = kTokenType_Char;
+			token.c = *ptr;
+			token.class_index = -1;
+			
+			if (ptr[0] == '*')
+			{
+				if (ptr + 1 < end && ptr[1] == '*')
+				{
+					token.type = kTokenType_DoubleStar;
+					ptr += 2;
+				}
+				else
+				{
+					token.type = kTokenType_Star;
+					ptr += 1;
+				}
+			}
+			else if (ptr[0] == '?')
+			{
+				token.type = kTokenType_AnyChar;
+				ptr += 1;
+			}
+			else if (ptr[0] == '[')
+			{
+				// find the end of the character class. a ']' directly after the opening bracket is part of the set
+				
+				const char * set_begin = ptr + 1;
+				
+				const bool negate = set_begin < end && (set_begin[0] == '!' || set_begin[0] == '^');
+				
+				if (negate)
+					set_begin++;
+				
+				const char * set_end = set_begin < end ? set_begin + 1 : end;
+				
+				while (set_end < end && set_end[0] != ']')
+					set_end++;
+				
+				if (set_end < end)
+				{
+					CharacterClass character_class;
+					memset(character_class.chars, 0, sizeof(character_class.chars));
+					
+					for (const char * c = set_begin; c < set_end; ++c)
+					{
+						if (c + 2 < set_end && c[1] == '-')
+						{
+							for (int i = (uint8_t)c[0]; i <= (uint8_t)c[2]; ++i)
+								character_class.chars[i] = true;
+							c += 2;
+						}
+						else
+						{
+							character_class.chars[(uint8_t)c[0]] = true;
+						}
+					}
+					
+					if (negate)
+					{
+						for (auto & c : character_class.chars)
+							c = !c;
+					}
+					
+					// note : character classes never match the path separator or the end of the text
+					
+					character_class.chars[(uint8_t)'/'] = false;
+					character_class.chars[0] = false;
+					
+					token.type = kTokenType_Class;
+					token.class_index = (int)classes.size();
+					
+					classes.push_back(character_class);
+					
+					ptr = set_end + 1;
+				}
+				else
+				{
+					// no closing bracket. treat the bracket as a regular character
+					
+					ptr += 1;
+				}
+			}
+			else
+			{
+				if (ptr[0] == '/')
+					element.match_path = true;
+				
+				ptr += 1;
+			}
+			
+			element.tokens.push_back(token);
+		}
+		
+		// a leading '**' already matches any number of leading directories, so there's no need to try each of them
+		
+		if (element.tokens.empty() == false && element.tokens.front().type == kTokenType_DoubleStar)
+			element.anchored = true;
+		
+		// use a cheaper way of matching for the most common kinds of patterns
+		
+		if (element.match_path == false)
+		{
+			const size_t num_tokens = element.tokens.size();
+			
+			size_t num_chars = 0;
+			
+			for (auto & token : element.tokens)
+				if (token.type == kTokenType_Char)
+					num_chars++;
+			
+			const bool starts_with_star = num_tokens > 0 && element.tokens.front().type == kTokenType_Star;
+			const bool ends_with_star = num_tokens > 0 && element.tokens.back().type == kTokenType_Star;
+			
+			if (num_chars == num_tokens)
+			{
+				element.type = kElementType_Literal;
+				element.text.assign(begin, end);
+			}
+			else if (num_chars + 1 == num_tokens && starts_with_star)
+			{
+				element.type = kElementType_Suffix;
+				element.text.assign(begin + 1, end);
+			}
+			else if (num_chars + 1 == num_tokens && ends_with_star)
+			{
+				element.type = kElementType_Prefix;
+				element.text.assign(begin, end - 1);
+			}
+			else
+			{
+				element.type = kElementType_Glob;
+			}
+		}
+		else
+		{
+			element.type = kElementType_Glob;
+		}
+		
+		elements.push_back(element);
+	}
+	
+	bool WildcardPattern::match(const char * text) const
+	{
+		if (is_extension_set)
+		{
+			// note : the extension is everything after the last dot. a path without a dot has an empty extension
+			
+			const char * text_end = text + strlen(text);
+			
+			const char * extension = text_end;
+			
+			while (extension > text && extension[-1] != '.')
+				extension--;
+			
+			if (extension == text)
+				extension = text_end;
+			
+			const size_t extension_size = text_end - extension;
+			
+			for (auto & candidate : extensions)
+			{
+				if (candidate.size() != extension_size)
+					continue;
+				
+				size_t i = 0;
+				
+				while (i < extension_size && tolower((uint8_t)extension[i]) == (uint8_t)candidate[i])
+					i++;
+				
+				if (i == extension_size)
+					return true;
+			}
+			
+			return false;
+		}
+		
+		const size_t text_size = strlen(text);
+		
+		const char * separator = strrchr(text, '/');
+		
+		const char * name = separator == nullptr ? text : separator + 1;
+		
+		for (auto & element : elements)
+			if (match_element(element, text, text_size, name))
+				return true;
+		
+		return false;
+	}
+	
+	bool WildcardPattern::match_element(const Element & element, const char * text, const size_t text_size, const char * name) const
+	{
+		switch (element.type)
+		{
+		case kElementType_Literal:
+			return strcmp(name, element.text.c_str()) == 0;
+			
+		case kElementType_Prefix:
+			return strncmp(name, element.text.c_str(), element.text.size()) == 0;
+			
+		case kElementType_Suffix:
+			{
+				const size_t name_size = text_size - (name - text);
+				
+				return
+					name_size >= element.text.size() &&
+					memcmp(text + text_size - element.text.size(), element.text.c_str(), element.text.size()) == 0;
+			}
+			
+		case kElementType_Glob:
+			break;
+		}
+		
+		const Token * tokens = element.tokens.data();
+		const Token * tokens_end = tokens + element.tokens.size();
+		
+		if (element.match_path == false)
+			return match_tokens(tokens, tokens_end, name);
+		
+		if (element.anchored)
+			return match_tokens(tokens, tokens_end, text);
+		
+		// try to match the end of the path, starting at each of the directory boundaries
+		
+		for (const char * ptr = text; ; )
+		{
+			if (match_tokens(tokens, tokens_end, ptr))
+				return true;
+			
+			ptr = strchr(ptr, '/');
+			
+			if (ptr == nullptr)
+				return false;
+			
+			ptr++;
+		}
+	}
+	
+	bool WildcardPattern::match_tokens(const Token * token, const Token * token_end, const char * text) const
+	{
+		for (; token < token_end; ++token)
+		{
+			switch (token->type)
+			{
+			case kTokenType_Char:
+				if (text[0] != token->c)
+					return false;
+				text++;
+				break;
+				
+			case kTokenType_AnyChar:
+				if (text[0] == 0 || text[0] == '/')
+					return false;
+				text++;
+				break;
+				
+			case kTokenType_Class:
+				if (classes[token->class_index].chars[(uint8_t)text[0]] == false)
+					return false;
+				text++;
+				break;
+				
+			case kTokenType_Star:
+				// try to match the remainder of the pattern, consuming one more character each time
+				for (;;)
+				{
+					if (match_tokens(token + 1, token_end, text))
+						return true;
+					if (text[0] == 0 || text[0] == '/')
+						return false;
+					text++;
+				}
+				
+			case kTokenType_DoubleStar:
+				for (;;)
+				{
+					if (match_tokens(token + 1, token_end, text))
+						return true;
+					if (text[0] == 0)
+						return false;
+					text++;
+				}
+			}
+		}
+		
+		return text[0] == 0;
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace chibi
+{
+	/**
+	 * A wildcard pattern, compiled once and matched against many names or paths. A pattern consists of one or
+	 * more elements, separated by a separator character. A name matches the pattern when it matches any of its elements.
+	 *
+	 * Elements support the following syntax:
+	 * - '*' matches any sequence of characters, except for '/'
+	 * - '**' matches any sequence of characters, including '/'
+	 * - '?' matches a single character, except for '/'
+	 * - '[abc]', '[a-z]' and '[!abc]' match a single character from (or not from) a set of characters
+	 *
+	 * Elements without a '/' are matched against the file name part of a path. Elements containing a '/' are matched
+	 * against the end of the path, starting at a directory boundary, unless the element starts with a '/', in which
+	 * case the entire path must match.
+	 */
+	struct WildcardPattern
+	{
+		enum ElementType
+		{
+			kElementType_Literal, // the file name equals the text
+			kElementType_Prefix, // the file name begins with the text
+			kElementType_Suffix, // the file name ends with the text
+			kElementType_Glob // the tokens must be matched one by one
+		};
+		
+		enum TokenType
+		{
+			kTokenType_Char,
+			kTokenType_AnyChar,
+			kTokenType_Class,
+			kTokenType_Star,
+			kTokenType_DoubleStar
+		};
+		
+		struct Token
+		{
+			TokenType type;
+			
+			char c; // for kTokenType_Char
+			
+			int class_index; // for kTokenType_Class
+		};
+		
+		struct CharacterClass
+		{
+			bool chars[256];
+		};
+		
+		struct Element
+		{
+			ElementType type = kElementType_Literal;
+			
+			std::string text;
+			
+			std::vector<Token> tokens;
+			
+			bool match_path = false; // match against the path, instead of just the file name
+			bool anchored = false; // the entire path must match
+		};
+		
+		std::vector<Element> elements;
+		
+		std::vector<CharacterClass> classes;
+		
+		bool is_extension_set = false;
+		
+		std::vector<std::string> extensions;
+		
+		/**
+		 * Adds the elements of the given pattern.
+		 */
+		void add(const char * pattern, const char separator);
+		
+		/**
+		 * Sets up the pattern to match file extensions, as given by a list of extensions, without the leading
+		 * dot. Extensions are compared case-insensitively. This is a lot cheaper than the equivalent '*.ext' pattern.
+		 */
+		void set_extensions(const char * extensions, const char separator);
+		
+		bool match(const char * text) const;
+		
+		bool match(const std::string & text) const
+		{
+			return match(text.c_str());
+		}
+		
+		void add_element(const char * begin, const char * end);
+		
+		bool match_element(const Element & element, const char * text, const size_t text_size, const char * name) const;
+		
+		bool match_tokens(const Token * token, const Token * token_end, const char * text) const;
+	};
+}
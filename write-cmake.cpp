@@ -1,13 +1,18 @@
 #include "base64.h"
+#include "buildlog.h"
+#include "chibi.h"
 #include "chibi-internal.h"
+#include "conglomeratecheck.h"
 #include "filesystem.h"
+#include "parsecache.h"
 #include "plistgenerator.h"
 #include "stringbuilder.h"
+#include "threadpool.h"
 
 #include <algorithm>
 #include <assert.h>
-#include <deque>
 #include <limits.h> // PATH_MAX
+#include <mutex>
 #include <set>
 #include <stdarg.h>
 #include <string>
@@ -50,30 +55,90 @@ static const char * translate_toolchain_to_cmake(const std::string & name)
 	return nullptr;
 }
 
-static std::string s_platform;
-static std::string s_platform_full;
+// the default amount of source code to put into each automatically generated conglomerate, in bytes
+static const int64_t kDefaultAutoConglomerateSize = 256 * 1024;
 
-static bool is_platform(const char * platform)
+// the condition under which compact output lists files which aren't compiled, such as header files. only IDEs show them
+static const char * s_list_all_files_condition = "CMAKE_GENERATOR MATCHES \"Xcode|Visual Studio\" OR CHIBI_LIST_ALL_FILES";
+
+static bool is_header_file(const std::string & filename)
 {
-	if (match_element(s_platform.c_str(), platform, '|'))
-		return true;
-	else if (s_platform_full.empty() == false && match_element(s_platform_full.c_str(), platform, '|'))
-		return true;
-	else
-		return false;
+	const std::string extension = get_path_extension(filename, true);
+	
+	return
+		extension == "h" ||
+		extension == "hh" ||
+		extension == "hpp" ||
+		extension == "hxx" ||
+		extension == "inl";
 }
 
-static std::string always_conditional_begin;
-static std::string always_conditional_end;
-
-static std::string dont_makearchive_conditional_begin;
-static std::string dont_makearchive_conditional_end;
-
-static std::string makearchive_conditional_begin;
-static std::string makearchive_conditional_end;
-
 struct CMakeWriter
 {
+	std::string s_platform;
+	std::string s_platform_full;
+	
+	std::string always_conditional_begin;
+	std::string always_conditional_end;
+	
+	std::string dont_makearchive_conditional_begin;
+	std::string dont_makearchive_conditional_end;
+	
+	std::string makearchive_conditional_begin;
+	std::string makearchive_conditional_end;
+	
+	bool split_targets = false; // write each library and app to its own file, included from CMakeLists.txt
+	
+	bool compact = false; // batch commands per target, and list header files for IDE generators only
+	
+	std::vector<StringBuilder> target_sbs; // the output for each library and app (by library id), when split_targets is set
+	
+	std::string generated_files_path; // the directory generated files are written to
+	std::string generated_path; // the location of the generated files, as cmake refers to it
+	
+	std::vector<std::string> regenerate_command; // the command which invokes chibi to generate the output again. empty when the output shouldn't regenerate itself
+	std::string regenerate_working_directory;
+	
+	const BuildLog * build_log = nullptr; // the compile times measured during a previous build, used to balance automatically generated conglomerates. may be null
+	
+	std::mutex compile_time_reports_mutex;
+	std::map<std::string, std::string> compile_time_reports; // the estimated effect of balancing conglomerates using the build log, by library
+	
+	bool check_conglomerates = false; // report symbols and macros which collide when files are included into the same conglomerate
+	bool split_conglomerates = false; // compile the files causing collisions by themselves, rather than reporting them
+	
+	std::mutex conglomerate_check_mutex;
+	std::map<std::string, std::string> conglomerate_check_reports; // the collisions found, by library
+	int num_conglomerate_conflicts = 0; // the number of collisions which remain
+	
+	std::vector<std::string> input_paths; // the files and directories read while writing the output, besides the chibi files and scanned directories
+	
+	std::mutex output_paths_mutex;
+	std::vector<std::string> output_paths; // the files written, including the ones left untouched as their contents didn't change
+	
+	bool is_platform(const char * platform) const
+	{
+		if (match_element(s_platform.c_str(), platform, '|'))
+			return true;
+		else if (s_platform_full.empty() == false && match_element(s_platform_full.c_str(), platform, '|'))
+			return true;
+		else
+			return false;
+	}
+	
+	// writes an output file, and records it as such. may be called concurrently
+	bool write_output_file(const char * text, const char * filename)
+	{
+		if (!write_if_different(text, filename))
+			return false;
+		
+		std::lock_guard<std::mutex> lock(output_paths_mutex);
+		
+		output_paths.push_back(filename);
+		
+		return true;
+	}
+	
 	bool handle_library(const ChibiInfo & chibi_info, ChibiLibrary & library, std::set<std::string> & traversed_libraries, std::vector<ChibiLibrary*> & libraries)
 	{
 	#if 0
@@ -94,7 +159,7 @@ struct CMakeWriter
 			
 			if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
 			{
-				ChibiLibrary * found_library = chibi_info.find_library(library_dependency.name.c_str());
+				ChibiLibrary * found_library = library_dependency.library;
 				
 				if (found_library == nullptr)
 				{
@@ -132,11 +197,10 @@ struct CMakeWriter
 	}
 	
 	template <typename S>
-	static bool write_app_resource_paths(
-		const ChibiInfo & chibi_info,
+	bool write_app_resource_paths(
 		S & sb,
 		const ChibiLibrary & app,
-		const std::vector<ChibiLibraryDependency> & library_dependencies)
+		const std::vector<const ChibiLibraryDependency*> & library_dependencies)
 	{
 		// write a formatted list of all resource paths to CHIBI_RESOURCE_PATHS
 
@@ -157,11 +221,11 @@ struct CMakeWriter
 					app.resource_path.c_str());
 			}
 
-			for (auto & library_dependency : library_dependencies)
+			for (auto * library_dependency : library_dependencies)
 			{
-				if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
+				if (library_dependency->type == ChibiLibraryDependency::kType_Generated)
 				{
-					auto * library = chibi_info.find_library(library_dependency.name.c_str());
+					auto * library = library_dependency->library;
 					
 					if (library->resource_path.empty() == false)
 					{
@@ -194,11 +258,11 @@ struct CMakeWriter
 
 			resource_paths.Append("type,name,path\n");
 
-			for (auto & library_dependency : library_dependencies)
+			for (auto * library_dependency : library_dependencies)
 			{
-				if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
+				if (library_dependency->type == ChibiLibraryDependency::kType_Generated)
 				{
-					auto * library = chibi_info.find_library(library_dependency.name.c_str());
+					auto * library = library_dependency->library;
 					
 					if (library->resource_path.empty() == false)
 					{
@@ -234,7 +298,7 @@ struct CMakeWriter
 	}
 	
 	template <typename S>
-	static void write_custom_command_for_distribution(
+	void write_custom_command_for_distribution(
 		S & sb,
 		const char * target,
 		const char * depends,
@@ -257,21 +321,20 @@ struct CMakeWriter
 	}
 	
 	template <typename S>
-	static void write_custom_command_for_distribution_va(
+	void write_custom_command_for_distribution_va(
 		S & sb,
 		const char * target,
 		const char * depends,
 		const char * command_format,
 		...)
 	{
-		char command[1024];
+		StringBuilder command;
 		va_list ap;
 		va_start(ap, command_format);
-		vsprintf_s(command, sizeof(command), command_format, ap);
+		command.AppendFormatV(command_format, ap);
 		va_end(ap);
 		
-		// note : command may be quite lengthy, so we avoid AppendFormat here
-		sb.Append("set(args "); sb.Append(command); sb.Append(")\n");
+		sb.Append("set(args "); sb.Append(command.text.c_str()); sb.Append(")\n");
 		sb.AppendFormat(
 			"add_custom_command(\n" \
 				"\tTARGET %s POST_BUILD\n" \
@@ -287,7 +350,7 @@ struct CMakeWriter
 	}
 	
 	template <typename S>
-	static bool write_copy_resources_for_distribution_using_rsync(S & sb, const ChibiLibrary & app, const ChibiLibrary & library, const char * destination_path)
+	bool write_copy_resources_for_distribution_using_rsync(S & sb, const ChibiLibrary & app, const ChibiLibrary & library, const char * destination_path)
 	{
 		// use rsync to copy resources
 
@@ -310,9 +373,9 @@ struct CMakeWriter
 		{
 			for (auto & exclude : library.resource_excludes)
 			{
-				sb.Append("--exclude '");
-				sb.Append(exclude.c_str());
-				sb.Append("' ");
+				exclude_args.Append("--exclude '");
+				exclude_args.Append(exclude.c_str());
+				exclude_args.Append("' ");
 			}
 		}
 
@@ -329,7 +392,7 @@ struct CMakeWriter
 	}
 	
 	template <typename S>
-	static bool write_copy_license_files_for_distribution_using_rsync(
+	bool write_copy_license_files_for_distribution_using_rsync(
 		S & sb,
 		const ChibiLibrary & app,
 		const ChibiLibrary & library,
@@ -380,8 +443,11 @@ struct CMakeWriter
 	}
 
 	template <typename S>
-	static bool write_header_paths(S & sb, const ChibiLibrary & library)
+	bool write_header_paths(S & sb, const ChibiLibrary & library)
 	{
+		if (compact)
+			return write_header_paths_compact(sb, library);
+		
 		if (!library.header_paths.empty())
 		{
 			for (auto & header_path : library.header_paths)
@@ -404,9 +470,125 @@ struct CMakeWriter
 		return true;
 	}
 	
+	// writes all header paths using a single call. the visibility is repeated when it changes, so the order of the search paths is kept intact
+	template <typename S>
+	static bool write_header_paths_compact(S & sb, const ChibiLibrary & library)
+	{
+		if (!library.header_paths.empty())
+		{
+			sb.AppendFormat("target_include_directories(%s", library.name.c_str());
+			
+			const char * current_visibility = nullptr;
+			
+			for (auto & header_path : library.header_paths)
+			{
+				const char * visibility = header_path.expose
+					? "PUBLIC"
+					: "PRIVATE";
+				
+				if (visibility != current_visibility)
+				{
+					sb.AppendFormat("\n\t%s", visibility);
+					current_visibility = visibility;
+				}
+				
+				sb.AppendFormat("\n\t\t\"%s\"",
+					header_path.alias_through_copy_path.empty() == false
+					? header_path.alias_through_copy_path.c_str()
+					: header_path.path.c_str());
+			}
+			
+			sb.Append(")\n");
+			sb.Append("\n");
+		}
+		
+		return true;
+	}
+	
+	// writes the compile definitions using a single call per toolchain condition
+	template <typename S>
+	static bool write_compile_definitions_compact(S & sb, const ChibiLibrary & library)
+	{
+		if (!library.compile_definitions.empty())
+		{
+			std::vector<std::string> toolchains; // empty when the definitions apply to all toolchains
+			
+			for (auto & compile_definition : library.compile_definitions)
+			{
+				const char * toolchain = translate_toolchain_to_cmake(compile_definition.toolchain);
+				
+				const std::string toolchain_name = toolchain != nullptr ? toolchain : "";
+				
+				if (std::find(toolchains.begin(), toolchains.end(), toolchain_name) == toolchains.end())
+					toolchains.push_back(toolchain_name);
+			}
+			
+			for (auto & toolchain : toolchains)
+			{
+				if (toolchain.empty() == false)
+					sb.AppendFormat("if (%s)\n", toolchain.c_str());
+				
+				const char * indent = toolchain.empty() ? "" : "\t";
+				
+				sb.AppendFormat("%starget_compile_definitions(%s", indent, library.name.c_str());
+				
+				const char * current_visibility = nullptr;
+				
+				for (auto & compile_definition : library.compile_definitions)
+				{
+					const char * compile_definition_toolchain = translate_toolchain_to_cmake(compile_definition.toolchain);
+					
+					if (toolchain != (compile_definition_toolchain != nullptr ? compile_definition_toolchain : ""))
+						continue;
+					
+					const char * visibility = compile_definition.expose
+						? "PUBLIC"
+						: "PRIVATE";
+					
+					if (visibility != current_visibility)
+					{
+						sb.AppendFormat("\n%s\t%s", indent, visibility);
+						current_visibility = visibility;
+					}
+					
+					for (size_t config_index = 0; config_index == 0 || config_index < compile_definition.configs.size(); ++config_index)
+					{
+						sb.AppendFormat("\n%s\t\t", indent);
+						
+						if (compile_definition.configs.empty() == false)
+							sb.AppendFormat("$<$<CONFIG:%s>:", compile_definition.configs[config_index].c_str());
+						
+						sb.Append(compile_definition.name.c_str());
+						
+						if (compile_definition.value.empty() == false)
+						{
+							sb.Append('=');
+							sb.Append(compile_definition.value.c_str());
+						}
+						
+						if (compile_definition.configs.empty() == false)
+							sb.Append('>');
+					}
+				}
+				
+				sb.Append(")\n");
+				
+				if (toolchain.empty() == false)
+					sb.AppendFormat("endif (%s)\n", toolchain.c_str());
+			}
+			
+			sb.Append("\n");
+		}
+		
+		return true;
+	}
+	
 	template <typename S>
-	static bool write_compile_definitions(S & sb, const ChibiLibrary & library)
+	bool write_compile_definitions(S & sb, const ChibiLibrary & library)
 	{
+		if (compact)
+			return write_compile_definitions_compact(sb, library);
+		
 		if (!library.compile_definitions.empty())
 		{
 			for (auto & compile_definition : library.compile_definitions)
@@ -477,12 +659,215 @@ struct CMakeWriter
 		return true;
 	}
 	
+	// collects the compile definitions the files of the library are compiled with: its own, and the ones exposed by
+	// the libraries it depends on
+	static bool get_effective_compile_definitions(const ChibiInfo & chibi_info, const ChibiLibrary & library, std::set<std::string> & compile_definitions)
+	{
+		auto * all_library_dependencies = chibi_info.dependency_graph.get_all_library_dependencies(library);
+		if (all_library_dependencies == nullptr)
+			return false;
+		
+		auto add_compile_definition = [&](const ChibiCompileDefinition & compile_definition)
+			{
+				std::string text = compile_definition.name + "=" + compile_definition.value + " " + compile_definition.toolchain;
+				
+				for (auto & config : compile_definition.configs)
+					text += " " + config;
+				
+				compile_definitions.insert(text);
+			};
+		
+		for (auto & compile_definition : library.compile_definitions)
+			add_compile_definition(compile_definition);
+		
+		for (auto * library_dependency : *all_library_dependencies)
+		{
+			if (library_dependency->type != ChibiLibraryDependency::kType_Generated)
+				continue;
+			
+			for (auto & compile_definition : library_dependency->library->compile_definitions)
+				if (compile_definition.expose)
+					add_compile_definition(compile_definition);
+		}
+		
+		return true;
+	}
+	
+	static bool uses_precompiled_header(const ChibiLibraryFile & file)
+	{
+		// note : objective-c++ files can't use a header precompiled as c++
+		
+		return
+			file.compile &&
+			file.use_precompiled_header &&
+			get_path_extension(file.filename, true) != "mm";
+	}
+	
+	// checks whether the library can reuse the precompiled header of the other library, rather than precompiling the
+	// header itself. compilers only accept a precompiled header when the files are compiled the same way
+	static bool can_reuse_precompiled_header(const ChibiInfo & chibi_info, const ChibiLibrary & library, const ChibiLibrary & other, bool & result)
+	{
+		result = false;
+		
+		// note : apps are compiled with compile definitions of their own, such as CHIBI_RESOURCE_PATH, and executables
+		//        are compiled as position-independent executables, rather than position-independent code
+		
+		if (library.isExecutable || other.isExecutable || library.prebuilt || other.prebuilt)
+			return true;
+		
+		// note : cmake compiles the files of shared libraries with <target>_EXPORTS defined, which differs per
+		//        library. it doesn't add this definition for static libraries, so shared libraries can never reuse
+		//        or share their precompiled header
+		
+		if (library.shared || other.shared)
+			return true;
+		
+		// note : -fobjc-arc is the only compile option chibi sets differently between targets
+		
+		if (library.objc_arc != other.objc_arc)
+			return true;
+		
+		// note : packages are linked using their imported targets or libraries, which may add compile options
+		//        and definitions of their own. they are linked privately, so only the library's own packages matter
+		
+		std::set<std::string> package_names;
+		std::set<std::string> other_package_names;
+		
+		for (auto & package_dependency : library.package_dependencies)
+			package_names.insert(package_dependency.name);
+		for (auto & package_dependency : other.package_dependencies)
+			other_package_names.insert(package_dependency.name);
+		
+		if (package_names != other_package_names)
+			return true;
+		
+		// cmake only precompiles the header when the library has c++ files which use it
+		
+		bool has_cpp_files = false;
+		
+		for (auto & file : other.files)
+		{
+			const char * extension = get_conglomerate_extension(file.filename);
+			
+			if (uses_precompiled_header(file) && extension != nullptr && strcmp(extension, "cpp") == 0)
+				has_cpp_files = true;
+		}
+		
+		if (has_cpp_files == false)
+			return true;
+		
+		std::set<std::string> compile_definitions;
+		std::set<std::string> other_compile_definitions;
+		
+		if (!get_effective_compile_definitions(chibi_info, library, compile_definitions) ||
+			!get_effective_compile_definitions(chibi_info, other, other_compile_definitions))
+		{
+			return false;
+		}
+		
+		result = compile_definitions == other_compile_definitions;
+		
+		return true;
+	}
+	
+	// writes the precompiled header of the library. this is either its own, or the one exposed by the nearest library
+	// it depends on, directly or indirectly. in the latter case, the precompiled header is reused when possible
+	template <typename S>
+	bool write_precompiled_header(const ChibiInfo & chibi_info, S & sb, const ChibiLibrary & library)
+	{
+		if (library.prebuilt)
+			return true;
+		
+		std::string precompiled_header = library.precompiled_header;
+		
+		const ChibiLibrary * reuse_library = nullptr;
+		
+		if (precompiled_header.empty())
+		{
+			// note : the dependencies are listed in breadth-first order, so the nearest library exposing a
+			//        precompiled header is found first, the same as for header paths
+			
+			auto * all_library_dependencies = chibi_info.dependency_graph.get_all_library_dependencies(library);
+			if (all_library_dependencies == nullptr)
+				return false;
+			
+			for (auto * library_dependency : *all_library_dependencies)
+			{
+				if (library_dependency->type != ChibiLibraryDependency::kType_Generated)
+					continue;
+				
+				const ChibiLibrary & other = *library_dependency->library;
+				
+				if (other.precompiled_header.empty() || other.precompiled_header_expose == false)
+					continue;
+				
+				precompiled_header = other.precompiled_header;
+				
+				bool can_reuse;
+				if (!can_reuse_precompiled_header(chibi_info, library, other, can_reuse))
+					return false;
+				
+				if (can_reuse)
+					reuse_library = &other;
+				
+				break;
+			}
+		}
+		
+		if (precompiled_header.empty())
+			return true;
+		
+		// note : target_precompile_headers was added in cmake 3.16. older versions build without the precompiled
+		//        header. it's only used for c++ files, as c files can't include c++ headers. conglomerates are
+		//        compiled as a single file, so the header is included once for all of the files they include
+		
+		sb.Append("if (COMMAND target_precompile_headers)\n");
+		
+		if (reuse_library != nullptr)
+		{
+			sb.AppendFormat("\ttarget_precompile_headers(%s REUSE_FROM %s)\n",
+				library.name.c_str(),
+				reuse_library->name.c_str());
+		}
+		else
+		{
+			sb.AppendFormat("\ttarget_precompile_headers(%s PRIVATE \"$<$<COMPILE_LANGUAGE:CXX>:%s>\")\n",
+				library.name.c_str(),
+				precompiled_header.c_str());
+		}
+		
+		bool has_skipped_files = false;
+		
+		for (auto & file : library.files)
+		{
+			if (file.compile && uses_precompiled_header(file) == false)
+				has_skipped_files = true;
+		}
+		
+		if (has_skipped_files)
+		{
+			sb.Append("\tset_source_files_properties(");
+			
+			for (auto & file : library.files)
+			{
+				if (file.compile && uses_precompiled_header(file) == false)
+					sb.AppendFormat("\n\t\t\"%s\"", file.filename.c_str());
+			}
+			
+			sb.Append("\n\t\tPROPERTIES SKIP_PRECOMPILE_HEADERS ON)\n");
+		}
+		
+		sb.Append("endif ()\n");
+		sb.Append("\n");
+		
+		return true;
+	}
+	
 	template <typename S>
 	static bool write_library_dependencies(S & sb, const ChibiLibrary & library)
 	{
 		if (!library.library_dependencies.empty())
 		{
-			StringBuilder find;
 			StringBuilder link;
 			
 			link.AppendFormat("target_link_libraries(%s", library.name.c_str());
@@ -501,19 +886,10 @@ struct CMakeWriter
 				}
 				else if (library_dependency.type == ChibiLibraryDependency::kType_Find)
 				{
-					char var_name[256];
-					
-					if (!concat(var_name, sizeof(var_name), library.name.c_str(), "_", library_dependency.name.c_str()))
-					{
-						report_error(nullptr, "failed to construct variable name for 'find' library dependency");
-						return false;
-						
-					}
-					
-					find.AppendFormat("find_library(%s %s)\n", var_name, library_dependency.name.c_str());
+					// note : the library is searched for once, by write_package_and_library_lookups
 					
 					link.AppendFormat("\n\tPUBLIC ${%s}",
-						var_name);
+						get_find_library_variable_name(library_dependency.name).c_str());
 				}
 				else if (library_dependency.type == ChibiLibraryDependency::kType_Global)
 				{
@@ -527,13 +903,6 @@ struct CMakeWriter
 				}
 			}
 			
-			if (!find.text.empty())
-			{
-				find.Append("\n");
-				
-				sb.Append(find.text.c_str());
-			}
-			
 			link.Append(")\n");
 			link.Append("\n");
 			
@@ -563,132 +932,247 @@ struct CMakeWriter
 			return package_dependency.c_str();
 	}
 	
+	static std::string get_find_library_variable_name(const std::string & library_name)
+	{
+		return "CHIBI_" + library_name + "_LIBRARY";
+	}
+	
+	static std::string quote_cmake_argument(const std::string & text)
+	{
+		std::string result = "\"";
+		
+		for (auto c : text)
+		{
+			if (c == '"' || c == '\\' || c == '$')
+				result.push_back('\\');
+			result.push_back(c);
+		}
+		
+		result.push_back('"');
+		
+		return result;
+	}
+	
+	// writes the code which lets the output regenerate itself. cmake is told to configure again when one of chibi's
+	// inputs changes, and invokes chibi before anything else when configuring. chibi itself checks whether anything
+	// changed, and leaves the output untouched when it didn't. when the output did change, cmake continues using the
+	// new output instead
 	template <typename S>
-	static bool write_package_dependencies(S & sb, const ChibiLibrary & library)
+	bool write_regeneration(S & sb, const ChibiInfo & chibi_info)
 	{
-		if (!library.package_dependencies.empty())
+		sb.Append("# --- regenerate the build files when chibi files or scanned directories change ---\n");
+		sb.Append("\n");
+		
+		sb.Append("if (NOT CHIBI_REGENERATED)\n");
+		sb.Append("\tfile(SHA256 \"${CMAKE_CURRENT_LIST_FILE}\" CHIBI_LIST_FILE_HASH)\n");
+		sb.Append("\texecute_process(\n");
+		sb.Append("\t\tCOMMAND");
+		for (auto & argument : regenerate_command)
+			sb.AppendFormat(" %s", quote_cmake_argument(argument).c_str());
+		sb.Append("\n");
+		sb.AppendFormat("\t\tWORKING_DIRECTORY %s\n", quote_cmake_argument(regenerate_working_directory).c_str());
+		sb.Append("\t\tRESULT_VARIABLE CHIBI_RESULT)\n");
+		sb.Append("\tif (NOT CHIBI_RESULT EQUAL 0)\n");
+		sb.Append("\t\tmessage(FATAL_ERROR \"failed to generate build files using chibi\")\n");
+		sb.Append("\tendif ()\n");
+		sb.Append("\tfile(SHA256 \"${CMAKE_CURRENT_LIST_FILE}\" CHIBI_NEW_LIST_FILE_HASH)\n");
+		sb.Append("\tif (NOT CHIBI_LIST_FILE_HASH STREQUAL CHIBI_NEW_LIST_FILE_HASH)\n");
+		sb.Append("\t\tset(CHIBI_REGENERATED TRUE)\n");
+		sb.Append("\t\tinclude(\"${CMAKE_CURRENT_LIST_FILE}\")\n");
+		sb.Append("\t\tunset(CHIBI_REGENERATED)\n");
+		sb.Append("\t\treturn()\n");
+		sb.Append("\tendif ()\n");
+		sb.Append("endif ()\n");
+		sb.Append("\n");
+		
+		if (chibi_info.input_paths.empty() == false)
 		{
-			for (auto & package_dependency : library.package_dependencies)
+			sb.Append("set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS");
+			for (auto & input_path : chibi_info.input_paths)
+				sb.AppendFormat("\n\t%s", quote_cmake_argument(input_path).c_str());
+			sb.Append(")\n");
+			sb.Append("\n");
+		}
+		
+		return true;
+	}
+	
+	// searches for the packages and system libraries the targets depend on. each of them is searched for only once,
+	// instead of once for each target depending on it, as each search adds to the time it takes to configure
+	template <typename S>
+	bool write_package_and_library_lookups(S & sb, const std::vector<ChibiLibrary*> & libraries)
+	{
+		std::set<std::string> found_packages;
+		std::set<std::string> found_libraries;
+		
+		for (auto * library : libraries)
+		{
+			for (auto & package_dependency : library->package_dependencies)
 			{
+				if (found_packages.insert(package_dependency.name).second == false)
+					continue;
+				
 				if (package_dependency.type == ChibiPackageDependency::kType_FindPackage)
 				{
 					sb.AppendFormat("find_package(%s REQUIRED)\n", package_dependency.name.c_str());
-					sb.AppendFormat("if (NOT %s_FOUND)\n", package_dependency.name.c_str());
-					sb.AppendFormat("\tmessage(FATAL_ERROR \"%s not found\")\n", package_dependency.name.c_str());
-					sb.AppendFormat("endif ()\n");
+					
+					if (compact == false)
+					{
+						sb.AppendFormat("if (NOT %s_FOUND)\n", package_dependency.name.c_str());
+						sb.AppendFormat("\tmessage(FATAL_ERROR \"%s not found\")\n", package_dependency.name.c_str());
+						sb.AppendFormat("endif ()\n");
+					}
 				}
-			}
-			
-		#if ENABLE_PKGCONFIG
-			for (auto & package_dependency : library.package_dependencies)
-			{
-				if (package_dependency.type == ChibiPackageDependency::kType_PkgConfig)
-				{
+			#if ENABLE_PKGCONFIG
+				else if (package_dependency.type == ChibiPackageDependency::kType_PkgConfig)
+				{
 					sb.AppendFormat("pkg_check_modules(%s REQUIRED %s)\n",
 						package_dependency.variable_name.c_str(),
 						package_dependency.name.c_str());
 				}
+			#endif
 			}
-		#endif
+		}
+		
+		for (auto * library : libraries)
+		{
+			for (auto & library_dependency : library->library_dependencies)
+			{
+				if (library_dependency.type != ChibiLibraryDependency::kType_Find)
+					continue;
+				
+				if (found_libraries.insert(library_dependency.name).second == false)
+					continue;
+				
+				sb.AppendFormat("find_library(%s %s)\n",
+					get_find_library_variable_name(library_dependency.name).c_str(),
+					library_dependency.name.c_str());
+			}
+		}
 		
+		if (found_packages.empty() == false || found_libraries.empty() == false)
 			sb.Append("\n");
+		
+		return true;
+	}
+	
+	// writes the package dependencies, with a single call for the include directories and libraries of all packages
+	template <typename S>
+	static bool write_package_dependencies_compact(S & sb, const ChibiLibrary & library)
+	{
+		if (!library.package_dependencies.empty())
+		{
+			// note : packages are searched for once, by write_package_and_library_lookups
+			
+			sb.AppendFormat("target_include_directories(%s PRIVATE", library.name.c_str());
 			
 			for (auto & package_dependency : library.package_dependencies)
 			{
 				if (package_dependency.type == ChibiPackageDependency::kType_FindPackage)
 				{
-					sb.AppendFormat("target_include_directories(%s PRIVATE \"${%s_INCLUDE_DIRS}\")\n",
-						library.name.c_str(),
+					sb.AppendFormat("\n\t\"${%s_INCLUDE_DIRS}\"",
 						get_package_dependency_output_name(package_dependency.name));
 				}
 			#if ENABLE_PKGCONFIG
 				else if (package_dependency.type == ChibiPackageDependency::kType_PkgConfig)
 				{
-					sb.AppendFormat("target_include_directories(%s PRIVATE \"${%s_INCLUDE_DIRS}\")\n",
-						library.name.c_str(),
+					sb.AppendFormat("\n\t\"${%s_INCLUDE_DIRS}\"",
 						package_dependency.variable_name.c_str());
 				}
 			#endif
 			}
-			sb.Append("\n");
+			
+			sb.Append(")\n");
+			
+			sb.AppendFormat("target_link_libraries(%s PRIVATE", library.name.c_str());
 			
 			for (auto & package_dependency : library.package_dependencies)
 			{
 				if (package_dependency.type == ChibiPackageDependency::kType_FindPackage)
 				{
-					sb.AppendFormat("target_link_libraries(%s PRIVATE ${%s_LIBRARIES} ${%s_LIBRARY})\n",
-						library.name.c_str(),
+					sb.AppendFormat("\n\t${%s_LIBRARIES} ${%s_LIBRARY}",
 						get_package_dependency_output_name(package_dependency.name),
 						get_package_dependency_output_name(package_dependency.name));
 				}
 			#if ENABLE_PKGCONFIG
 				else if (package_dependency.type == ChibiPackageDependency::kType_PkgConfig)
 				{
-					sb.AppendFormat("target_link_libraries(%s PRIVATE ${%s_LIBRARIES})\n",
-						library.name.c_str(),
+					sb.AppendFormat("\n\t${%s_LIBRARIES}",
 						package_dependency.variable_name.c_str());
 				}
 			#endif
 			}
+			
+			sb.Append(")\n");
 			sb.Append("\n");
 		}
 		
 		return true;
 	}
 	
-	static bool gather_all_library_dependencies(const ChibiInfo & chibi_info, const ChibiLibrary & library, std::vector<ChibiLibraryDependency> & library_dependencies)
+	template <typename S>
+	bool write_package_dependencies(S & sb, const ChibiLibrary & library)
 	{
-		std::set<std::string> traversed_libraries;
-		std::deque<const ChibiLibrary*> stack;
+		if (compact)
+			return write_package_dependencies_compact(sb, library);
 		
-		stack.push_back(&library);
-		
-		traversed_libraries.insert(library.name);
-		
-		while (stack.empty() == false)
+		if (!library.package_dependencies.empty())
 		{
-			const ChibiLibrary * library = stack.front();
+			// note : packages are searched for once, by write_package_and_library_lookups
 			
-			for (auto & library_dependency : library->library_dependencies)
+			for (auto & package_dependency : library.package_dependencies)
 			{
-				if (traversed_libraries.count(library_dependency.name) == 0)
+				if (package_dependency.type == ChibiPackageDependency::kType_FindPackage)
 				{
-					traversed_libraries.insert(library_dependency.name);
-					
-					library_dependencies.push_back(library_dependency);
-					
-					if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
-					{
-						const ChibiLibrary * resolved_library = chibi_info.find_library(library_dependency.name.c_str());
-						
-						if (resolved_library == nullptr)
-						{
-							report_error(nullptr, "failed to resolve library dependency: %s for library %s", library_dependency.name.c_str(), library->name.c_str());
-							return false;
-						}
-
-						stack.push_back(resolved_library);
-					}
+					sb.AppendFormat("target_include_directories(%s PRIVATE \"${%s_INCLUDE_DIRS}\")\n",
+						library.name.c_str(),
+						get_package_dependency_output_name(package_dependency.name));
+				}
+			#if ENABLE_PKGCONFIG
+				else if (package_dependency.type == ChibiPackageDependency::kType_PkgConfig)
+				{
+					sb.AppendFormat("target_include_directories(%s PRIVATE \"${%s_INCLUDE_DIRS}\")\n",
+						library.name.c_str(),
+						package_dependency.variable_name.c_str());
 				}
+			#endif
 			}
+			sb.Append("\n");
 			
-			stack.pop_front();
+			for (auto & package_dependency : library.package_dependencies)
+			{
+				if (package_dependency.type == ChibiPackageDependency::kType_FindPackage)
+				{
+					sb.AppendFormat("target_link_libraries(%s PRIVATE ${%s_LIBRARIES} ${%s_LIBRARY})\n",
+						library.name.c_str(),
+						get_package_dependency_output_name(package_dependency.name),
+						get_package_dependency_output_name(package_dependency.name));
+				}
+			#if ENABLE_PKGCONFIG
+				else if (package_dependency.type == ChibiPackageDependency::kType_PkgConfig)
+				{
+					sb.AppendFormat("target_link_libraries(%s PRIVATE ${%s_LIBRARIES})\n",
+						library.name.c_str(),
+						package_dependency.variable_name.c_str());
+				}
+			#endif
+			}
+			sb.Append("\n");
 		}
 		
 		return true;
 	}
 	
-	static bool write_embedded_app_files(
-		const ChibiInfo & chibi_info,
+	bool write_embedded_app_files(
 		StringBuilder & sb,
 		const ChibiLibrary & app,
-		const std::vector<ChibiLibraryDependency> & library_dependencies)
+		const std::vector<const ChibiLibraryDependency*> & library_dependencies)
 	{
 		bool has_embed_dependency = false;
 		
-		for (auto & library_dependency : library_dependencies)
+		for (auto * library_dependency : library_dependencies)
 		{
-			if (library_dependency.embed_framework)
+			if (library_dependency->embed_framework)
 			{
 				has_embed_dependency = true;
 				
@@ -696,12 +1180,12 @@ struct CMakeWriter
 				
 				const char * filename;
 				
-				auto i = library_dependency.path.find_last_of('/');
+				auto i = library_dependency->path.find_last_of('/');
 				
 				if (i == std::string::npos)
-					filename = library_dependency.path.c_str();
+					filename = library_dependency->path.c_str();
 				else
-					filename = &library_dependency.path[i + 1];
+					filename = &library_dependency->path[i + 1];
 				
 				if (s_platform == "macos" || s_platform == "iphoneos")
 				{
@@ -721,11 +1205,11 @@ struct CMakeWriter
 							app.name.c_str(),
 							always_conditional_begin.c_str(),
 							always_conditional_end.c_str(),
-							library_dependency.path.c_str());
+							library_dependency->path.c_str());
 						
 						// rsync
 						sb.AppendFormat("set(args rsync -a \"%s\" \"${BUNDLE_PATH}/Contents/Frameworks\")\n",
-							library_dependency.path.c_str());
+							library_dependency->path.c_str());
 						sb.AppendFormat(
 							"add_custom_command(\n" \
 								"\tTARGET %s POST_BUILD\n" \
@@ -735,14 +1219,14 @@ struct CMakeWriter
 							app.name.c_str(),
 							always_conditional_begin.c_str(),
 							always_conditional_end.c_str(),
-							library_dependency.path.c_str());
+							library_dependency->path.c_str());
 					}
 					else
 					{
 						// just copy the file (if it has changed or doesn't exist)
 						
 						sb.AppendFormat("set(args ${CMAKE_COMMAND} -E copy_if_different \"%s\" \"${BUNDLE_PATH}/Contents/MacOS/%s\")\n",
-							library_dependency.path.c_str(),
+							library_dependency->path.c_str(),
 							filename);
 						sb.AppendFormat(
 							"add_custom_command(\n" \
@@ -753,7 +1237,7 @@ struct CMakeWriter
 							app.name.c_str(),
 							always_conditional_begin.c_str(),
 							always_conditional_end.c_str(),
-							library_dependency.path.c_str());
+							library_dependency->path.c_str());
 					}
 				}
 				else
@@ -764,9 +1248,9 @@ struct CMakeWriter
 							"\tCOMMAND ${CMAKE_COMMAND} -E copy_if_different \"%s\" \"${CMAKE_CURRENT_BINARY_DIR}/%s\"\n" \
 							"\tDEPENDS \"%s\")\n",
 						app.name.c_str(),
-						library_dependency.path.c_str(),
+						library_dependency->path.c_str(),
 						filename,
-						library_dependency.path.c_str());
+						library_dependency->path.c_str());
 				}
 			}
 		}
@@ -774,11 +1258,11 @@ struct CMakeWriter
 		if (has_embed_dependency)
 			sb.Append("\n");
 		
-		for (auto & library_dependency : library_dependencies)
+		for (auto * library_dependency : library_dependencies)
 		{
-			if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
+			if (library_dependency->type == ChibiLibraryDependency::kType_Generated)
 			{
-				const ChibiLibrary * library = chibi_info.find_library(library_dependency.name.c_str());
+				const ChibiLibrary * library = library_dependency->library;
 				
 				for (auto & dist_file : library->dist_files)
 				{
@@ -827,23 +1311,23 @@ struct CMakeWriter
 					{
 						write_custom_command_for_distribution_va(sb,
 							app.name.c_str(),
-							library_dependency.name.c_str(),
+							library_dependency->name.c_str(),
 							"${CMAKE_COMMAND} -E copy_if_different\n" \
 							"\t\"$<TARGET_FILE:%s>\"\n" \
 							"\t\"${BUNDLE_PATH}/Contents/MacOS/$<TARGET_FILE_NAME:%s>\"",
-							library_dependency.name.c_str(),
-							library_dependency.name.c_str());
+							library_dependency->name.c_str(),
+							library_dependency->name.c_str());
 					}
 					else if (s_platform == "iphoneos")
 					{
 						write_custom_command_for_distribution_va(sb,
 							app.name.c_str(),
-							library_dependency.name.c_str(),
+							library_dependency->name.c_str(),
 							"${CMAKE_COMMAND} -E copy_if_different\n" \
 							"\t\"$<TARGET_FILE:%s>\"\n" \
 							"\t\"${BUNDLE_PATH}/$<TARGET_FILE_NAME:%s>\"",
-							library_dependency.name.c_str(),
-							library_dependency.name.c_str());
+							library_dependency->name.c_str(),
+							library_dependency->name.c_str());
 					}
 					
 					// todo : also copy generated (dll) files on Windows (?)
@@ -854,7 +1338,7 @@ struct CMakeWriter
 		return true;
 	}
 
-	static bool write_create_windows_app_archive(const ChibiInfo & chibi_info, StringBuilder & sb, const ChibiLibrary & app, const std::vector<ChibiLibraryDependency> & library_dependencies)
+	bool write_create_windows_app_archive(StringBuilder & sb, const ChibiLibrary & app, const std::vector<const ChibiLibraryDependency*> & library_dependencies)
 	{
 		// create a directory where to copy the executable, distribution and data files
 		
@@ -873,11 +1357,11 @@ struct CMakeWriter
 			app.name.c_str(),
 			app.name.c_str());
 
-		for (auto & library_dependency : library_dependencies)
+		for (auto * library_dependency : library_dependencies)
 		{
-			if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
+			if (library_dependency->type == ChibiLibraryDependency::kType_Generated)
 			{
-				const ChibiLibrary * library = chibi_info.find_library(library_dependency.name.c_str());
+				const ChibiLibrary * library = library_dependency->library;
 				
 				// copy generated DLL files
 
@@ -887,7 +1371,7 @@ struct CMakeWriter
 						app.name.c_str(),
 						"\"$<TARGET_FILE:%s>\"",
 						"${CMAKE_COMMAND} -E copy_if_different \"$<TARGET_FILE:%s>\" \"${CMAKE_CURRENT_BINARY_DIR}/%s\"",
-						library_dependency.name.c_str(),
+						library_dependency->name.c_str(),
 						app.name.c_str());
 				}
 
@@ -927,11 +1411,11 @@ struct CMakeWriter
 
 		// copy library resources
 		
-		for (auto & library_dependency : library_dependencies)
+		for (auto * library_dependency : library_dependencies)
 		{
-			if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
+			if (library_dependency->type == ChibiLibraryDependency::kType_Generated)
 			{
-				auto * library = chibi_info.find_library(library_dependency.name.c_str());
+				auto * library = library_dependency->library;
 				
 				if (library->resource_path.empty() == false)
 				{
@@ -959,17 +1443,23 @@ struct CMakeWriter
 	}
 	
 	template <typename S>
-	static bool output(FILE * f, S & sb)
+	static bool output(StringBuilder & output_sb, S & sb)
 	{
-		if (fprintf(f, "%s", sb.text.c_str()) < 0)
-		{
-			report_error(nullptr, "failed to write to disk");
-			return false;
-		}
+		output_sb.text.append(sb.text);
 		
 		return true;
 	}
 	
+	// outputs the text belonging to a library or app, either to the main output or to the output of the target itself
+	template <typename S>
+	bool output_target(StringBuilder & output_sb, const ChibiLibrary & library, S & sb)
+	{
+		if (split_targets)
+			return output(target_sbs[library.id], sb);
+		else
+			return output(output_sb, sb);
+	}
+	
 	static void write_set_osx_bundle_path(StringBuilder & sb, const char * app_name)
 	{
 		sb.AppendFormat("set(BUNDLE_PATH \"$<TARGET_FILE_DIR:%s>/../..\")\n\n", app_name);
@@ -980,7 +1470,7 @@ struct CMakeWriter
 		sb.AppendFormat("set(BUNDLE_PATH \"\\$\\{CONFIGURATION_BUILD_DIR\\}/\\$\\{CONTENTS_FOLDER_PATH\\}\")\n\n", app_name);
 	}
 
-	static bool generate_translation_unit_linkage_files(const ChibiInfo & chibi_info, StringBuilder & sb, const char * generated_path, const std::vector<ChibiLibrary*> & libraries)
+	bool generate_translation_unit_linkage_files(const ChibiInfo & chibi_info, const std::vector<ChibiLibrary*> & libraries)
 	{
 		// generate translation unit linkage files
 
@@ -989,18 +1479,18 @@ struct CMakeWriter
 			if (app->isExecutable == false)
 				continue;
 
-			std::vector<ChibiLibraryDependency> all_library_dependencies;
-			if (!gather_all_library_dependencies(chibi_info, *app, all_library_dependencies))
+			auto * all_library_dependencies = chibi_info.dependency_graph.get_all_library_dependencies(*app);
+			if (all_library_dependencies == nullptr)
 				return false;
 
 			std::vector<std::string> link_translation_unit_using_function_calls;
 			
-			for (auto & library_dependency : all_library_dependencies)
+			for (auto * library_dependency : *all_library_dependencies)
 			{
-				if (library_dependency.type != ChibiLibraryDependency::kType_Generated)
+				if (library_dependency->type != ChibiLibraryDependency::kType_Generated)
 					continue;
 
-				auto * library = chibi_info.find_library(library_dependency.name.c_str());
+				auto * library = library_dependency->library;
 
 				link_translation_unit_using_function_calls.insert(
 					link_translation_unit_using_function_calls.end(),
@@ -1028,14 +1518,16 @@ struct CMakeWriter
 				}
 				text_sb.Append("}\n");
 
+				char filename[PATH_MAX];
 				char full_path[PATH_MAX];
-				if (!concat(full_path, sizeof(full_path), generated_path, "/translation_unit_linkage-", app->name.c_str(), ".cpp"))
+				if (!concat(filename, sizeof(filename), "translation_unit_linkage-", app->name.c_str(), ".cpp") ||
+					!concat(full_path, sizeof(full_path), generated_path.c_str(), "/", filename))
 				{
 					report_error(nullptr, "failed to create absolute path");
 					return false;
 				}
 
-				if (!write_text_to_file_if_contents_changed(sb, text_sb.text.c_str(), full_path))
+				if (!write_generated_file(filename, text_sb.text.c_str()))
 				{
 					report_error(nullptr, "failed to write translation unit linkage file. path: %s", full_path);
 					return false;
@@ -1043,8 +1535,11 @@ struct CMakeWriter
 				
 				// add the translation unit linkage file to the list of app files
 				
+				// note : the linkage file only declares and calls functions. it doesn't need the precompiled header
+				
 				ChibiLibraryFile file;
 				file.filename = full_path;
+				file.use_precompiled_header = false;
 
 				app->files.push_back(file);
 			}
@@ -1053,168 +1548,1589 @@ struct CMakeWriter
 		return true;
 	}
 
-	static bool write_text_to_file_if_contents_changed(StringBuilder & sb, const char * text, const char * filename)
+	// writes a file into the generated files directory. the file is left untouched when its contents didn't change,
+	// so its modification time is kept intact and it isn't rebuilt needlessly
+	bool write_generated_file(const char * filename, const char * text)
 	{
-		// escape the text so we can use 'file(WRITE ..)' from cmake to create the actual file inside the right directory
-		
-		std::string escaped_text;
+		char full_path[PATH_MAX];
+		char path[PATH_MAX];
+		if (!concat(full_path, sizeof(full_path), generated_files_path.c_str(), "/", filename) ||
+			!get_path_from_filename(full_path, path, sizeof(path)))
+		{
+			report_error(nullptr, "failed to create absolute path");
+			return false;
+		}
 		
-		for (int i = 0; text[i] != 0; ++i)
+		if (!create_directories(path) || !write_output_file(text, full_path))
 		{
-			const char c = text[i];
-
-			if (c == '"')
-			{
-				escaped_text.push_back('\\');
-				escaped_text.push_back('"');
-			}
-			else
-				escaped_text.push_back(c);
+			report_error(nullptr, "failed to write generated file: %s", full_path);
+			return false;
 		}
-
-		sb.AppendFormat("file(WRITE \"%s.txt\" \"%s\")\n", filename, escaped_text.c_str());
-		sb.AppendFormat("file(GENERATE OUTPUT \"%s\" INPUT \"%s.txt\")\n", filename, filename);
-		sb.Append("\n");
-
+		
 		return true;
 	}
 	
-	bool write(const ChibiInfo & chibi_info, const char * platform, const char * output_filename)
+	// mirrors the files inside a header path into copy_path. files are hard linked where possible, and copied only
+	// when their contents changed otherwise. files inside copy_path which no longer exist inside the header path are
+	// removed. the directories read, and the files which had to be copied, are added to input_paths, so the mirror
+	// is refreshed when files are added, removed, replaced or modified. the mirrored files are added to output_paths
+	static bool mirror_header_path(const std::string & header_path, const char * copy_path, std::vector<std::string> & input_paths, std::vector<std::string> & output_paths)
 	{
-		// decode platform
-		
-		const char * separator = strchr(platform, '.');
-		
-		if (separator == nullptr)
-		{
-			s_platform = platform;
-			s_platform_full.clear();
-		}
-		else
+		if (!create_directories(copy_path))
 		{
-			s_platform = std::string(platform).substr(0, separator - platform);
-			s_platform_full = platform;
+			report_error(nullptr, "failed to create directory: %s", copy_path);
+			return false;
 		}
 		
-		// gather the library targets to emit
-		
-		std::set<std::string> traversed_libraries;
-		
-		std::vector<ChibiLibrary*> libraries;
+		std::set<std::string> created_paths;
+		std::set<std::string> mirrored_files;
 		
-		for (auto & library : chibi_info.libraries)
+		for (auto & src : listFiles(header_path.c_str(), true, nullptr, &input_paths))
 		{
-			if (traversed_libraries.count(library->name) != 0)
-				continue;
+			const std::string dst = copy_path + src.substr(header_path.size());
 			
-			if (library->isExecutable && chibi_info.should_build_target(library->name.c_str()))
+			char dst_path[PATH_MAX];
+			if (!get_path_from_filename(dst.c_str(), dst_path, sizeof(dst_path)))
 			{
-				if (handle_library(chibi_info, *library, traversed_libraries, libraries) == false)
-					return false;
+				report_error(nullptr, "failed to create absolute path");
+				return false;
+			}
+			
+			if (created_paths.insert(dst_path).second && !create_directories(dst_path))
+			{
+				report_error(nullptr, "failed to create directory: %s", dst_path);
+				return false;
 			}
+			
+			bool is_linked;
+			if (!link_or_copy_file(src.c_str(), dst.c_str(), is_linked))
+			{
+				report_error(nullptr, "failed to copy aliased header file: %s", src.c_str());
+				return false;
+			}
+			
+			// note : a copy doesn't see changes made to the file in place, which leave the directory untouched
+			if (is_linked == false)
+				input_paths.push_back(src);
+			
+			mirrored_files.insert(dst);
+			
+			output_paths.push_back(dst);
 		}
 		
-		for (auto & library : chibi_info.libraries)
+		for (auto & dst : listFiles(copy_path, true))
 		{
-			if (traversed_libraries.count(library->name) != 0)
+			if (mirrored_files.count(dst) != 0)
 				continue;
 			
-			if (chibi_info.should_build_target(library->name.c_str()))
+			if (remove(dst.c_str()) != 0)
 			{
-				if (handle_library(chibi_info, *library, traversed_libraries, libraries) == false)
+				report_error(nullptr, "failed to remove aliased header file: %s", dst.c_str());
+				return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	// copies the header paths aliased through copy into the generated files directory. header paths are independent
+	// of each other, so we process them concurrently
+	bool copy_aliased_header_paths(const std::vector<ChibiLibrary*> & libraries)
+	{
+		std::vector<std::pair<const std::string*, std::string>> copies;
+		
+		for (auto * library : libraries)
+		{
+			for (auto & header_path : library->header_paths)
+			{
+				if (header_path.alias_through_copy.empty())
+					continue;
+				
+				char alias_path[PATH_MAX];
+				char library_path[PATH_MAX];
+				char copy_path[PATH_MAX];
+				if (!concat(alias_path, sizeof(alias_path), generated_path.c_str(), "/", library->name.c_str()) ||
+					!concat(library_path, sizeof(library_path), generated_files_path.c_str(), "/", library->name.c_str()) ||
+					!concat(copy_path, sizeof(copy_path), library_path, "/", header_path.alias_through_copy.c_str()))
+				{
+					report_error(nullptr, "failed to create absolute path");
 					return false;
+				}
+				
+				header_path.alias_through_copy_path = alias_path;
+				
+				copies.push_back(std::make_pair(&header_path.path, std::string(copy_path)));
 			}
 		}
 		
-		// sort files by name
+		std::vector<char> results(copies.size(), false);
+		std::vector<std::vector<std::string>> copy_input_paths(copies.size());
+		std::vector<std::vector<std::string>> copy_output_paths(copies.size());
+		
+		TaskGroup task_group;
 		
-		for (auto & library : libraries)
+		for (size_t i = 0; i < copies.size(); ++i)
 		{
-			std::sort(library->files.begin(), library->files.end(),
-				[](const ChibiLibraryFile & a, const ChibiLibraryFile & b)
+			task_group.add([&, i]()
 				{
-					return a.filename < b.filename;
+					results[i] = mirror_header_path(*copies[i].first, copies[i].second.c_str(), copy_input_paths[i], copy_output_paths[i]);
 				});
 		}
 		
-	// todo : make conglomerate generation independent of cmake writer
-
-		// generate conglomerate files
+		task_group.wait();
 		
-		for (auto * library : libraries)
+		for (auto result : results)
+			if (result == false)
+				return false;
+		
+		for (auto & paths : copy_input_paths)
+			input_paths.insert(input_paths.end(), paths.begin(), paths.end());
+		for (auto & paths : copy_output_paths)
+			output_paths.insert(output_paths.end(), paths.begin(), paths.end());
+		
+		return true;
+	}
+	
+	// removes the automatically generated conglomerates which weren't written during this run. they belong to
+	// partitions which no longer exist, or to libraries which are no longer partitioned or part of the build
+	bool remove_stale_unity_files()
+	{
+		const std::set<std::string> written_files(output_paths.begin(), output_paths.end());
+		
+		for (auto & filename : listFiles(generated_files_path.c_str(), true))
 		{
-			// build a set of conglomerate files and the files which belong to them
+			// note : unity files live directly inside the directory of their library. the files below it are
+			//        mirrored headers, which are left alone
 			
-			std::map<std::string, std::vector<ChibiLibraryFile*>> files_by_conglomerate;
+			const size_t name_begin = filename.find_last_of('/') + 1;
 			
-			for (auto & library_file : library->files)
+			if (name_begin <= generated_files_path.size() + 1 ||
+				filename.find('/', generated_files_path.size() + 1) != name_begin - 1 ||
+				filename.compare(name_begin, 6, "unity-") != 0 ||
+				written_files.count(filename) != 0)
 			{
-				if (library_file.conglomerate_filename.empty())
-					continue;
-				
-				auto & files = files_by_conglomerate[library_file.conglomerate_filename];
-				
-				files.push_back(&library_file);
+				continue;
 			}
 			
-			// generate conglomerate files
+			if (remove(filename.c_str()) != 0)
+			{
+				report_error(nullptr, "failed to remove stale conglomerate file: %s", filename.c_str());
+				return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	// checks whether the symbols and macros defined by the files collide once they're included into the same
+	// conglomerate. when splitting conglomerates, the files causing collisions are removed from the list and returned
+	// as split files. otherwise, the collisions are reported and counted
+	void check_conglomerate(const ChibiLibrary & library, const std::string & conglomerate_filename, std::vector<ChibiLibraryFile*> & library_files, std::vector<ChibiLibraryFile*> & split_files)
+	{
+		std::vector<SourceSymbols> symbols(library_files.size());
+		
+		for (size_t i = 0; i < library_files.size(); ++i)
+		{
+			// note : files which can't be read are left empty. cmake will report them as missing
+			
+			symbols[i].scan(library_files[i]->filename.c_str());
+		}
+		
+		std::vector<size_t> file_indices;
+		
+		for (size_t i = 0; i < library_files.size(); ++i)
+			file_indices.push_back(i);
+		
+		std::string report;
+		std::set<std::string> reported_conflicts;
+		
+		int num_conflicts = 0;
+		
+		for (;;)
+		{
+			std::vector<const SourceSymbols*> files;
 			
-			std::vector<ChibiLibraryFile> filesToAdd;
+			for (auto file_index : file_indices)
+				files.push_back(&symbols[file_index]);
 			
-			for (auto & files_by_conglomerate_itr : files_by_conglomerate)
-			{
-				auto & conglomerate_filename = files_by_conglomerate_itr.first;
-				auto & library_files = files_by_conglomerate_itr.second;
-				
-				StringBuilder sb;
+			std::vector<ConglomerateConflict> conflicts;
+			find_conglomerate_conflicts(files, conflicts);
 			
-				sb.Append("// auto-generated. do not hand-edit\n\n");
-
-				for (auto * library_file : library_files)
-				{
-					assert(library_file->compile == false);
-					
-					sb.AppendFormat("#include \"%s\"\n", library_file->filename.c_str());
-				}
-
-				if (!write_if_different(sb.text.c_str(), conglomerate_filename.c_str()))
-				{
-					report_error(nullptr, "failed to write conglomerate file. path: %s", conglomerate_filename.c_str());
-					return false;
-				}
+			if (conflicts.empty())
+				break;
+			
+			std::set<size_t> conflicting_files;
+			
+			for (auto & conflict : conflicts)
+			{
+				const ChibiLibraryFile * library_file = library_files[file_indices[conflict.file_index]];
+				const ChibiLibraryFile * other_library_file = library_files[file_indices[conflict.other_file_index]];
 				
-				// add the conglomerate file to the list of library files
+				char text[1024];
+				sprintf_s(text, sizeof(text), "%s:%d: conflict in conglomerate %s: %s %s:%d\n",
+					library_file->filename.c_str(), conflict.line,
+					conglomerate_filename.c_str(),
+					conflict.description.c_str(),
+					other_library_file->filename.c_str(), conflict.other_line);
 				
-				ChibiLibraryFile file;
+				// note : removing a file may reveal conflicts which were hidden by it, such as a macro it undefined.
+				//        the others have been reported already
 				
-				file.filename = conglomerate_filename;
+				if (reported_conflicts.insert(text).second)
+				{
+					report += text;
+					num_conflicts++;
+				}
 				
-				if (library->conglomerate_groups.count(conglomerate_filename) != 0)
-					file.group = library->conglomerate_groups[conglomerate_filename];
-	
-				filesToAdd.push_back(file);
+				conflicting_files.insert(conflict.file_index);
 			}
 			
-			for (auto & file : filesToAdd)
+			if (split_conglomerates == false)
+				break;
+			
+			// compile the files causing conflicts by themselves. conflicts are reported for the later file, so
+			// the files before them keep their place in the conglomerate
+			
+			std::vector<size_t> remaining_file_indices;
+			
+			for (size_t i = 0; i < file_indices.size(); ++i)
 			{
-				library->files.push_back(file);
+				if (conflicting_files.count(i) != 0)
+				{
+					ChibiLibraryFile * library_file = library_files[file_indices[i]];
+					
+					report += library_file->filename + ": compiled outside of conglomerate " + conglomerate_filename + ", to avoid its conflicts\n";
+					
+					split_files.push_back(library_file);
+				}
+				else
+					remaining_file_indices.push_back(file_indices[i]);
 			}
+			
+			file_indices = remaining_file_indices;
 		}
-
-		// turn shared libraries into non-shared for iphoneos, since I didn't manage
-		// to do code signing propertly yet, and iphoneos refuses to load our .dylibs
-		if (s_platform == "iphoneos")
+		
+		if (split_files.empty() == false)
 		{
-		// todo : run code signing on generated shared libraries for macos/iphoneos
-			for (auto & library : libraries)
-				library->shared = false;
+			std::vector<ChibiLibraryFile*> remaining_files;
+			
+			for (auto file_index : file_indices)
+				remaining_files.push_back(library_files[file_index]);
+			
+			library_files = remaining_files;
 		}
 		
-		// always build a self-contained archive for iphoneos and android,
-		// as any build type could be deployed on an actual device, and the
-		// app won't have access to the local filesystem for loading resources
-		// and libraries
-		if (s_platform == "iphoneos" || s_platform == "android")
+		if (report.empty())
+			return;
+		
+		std::lock_guard<std::mutex> lock(conglomerate_check_mutex);
+		
+		conglomerate_check_reports[library.name] += report;
+		
+		if (split_conglomerates == false)
+			num_conglomerate_conflicts += num_conflicts;
+	}
+	
+	bool generate_conglomerate_files(ChibiLibrary & library)
+	{
+		// sort files by name
+		
+		std::sort(library.files.begin(), library.files.end(),
+			[](const ChibiLibraryFile & a, const ChibiLibraryFile & b)
+			{
+				return a.filename < b.filename;
+			});
+		
+		// build a set of conglomerate files and the files which belong to them
+		
+		std::map<std::string, std::vector<ChibiLibraryFile*>> files_by_conglomerate;
+		
+		for (auto & library_file : library.files)
+		{
+			if (library_file.conglomerate_filename.empty())
+				continue;
+			
+			// note : modified files are only set in adaptive mode. they are compiled by themselves, so editing them
+			//        doesn't recompile the entire conglomerate
+			
+			if (library_file.is_modified)
+			{
+				library_file.conglomerate_filename = chibi::InternedString();
+				library_file.compile = true;
+				continue;
+			}
+			
+			auto & files = files_by_conglomerate[library_file.conglomerate_filename];
+			
+			files.push_back(&library_file);
+		}
+		
+		// generate conglomerate files
+		
+		std::vector<ChibiLibraryFile> filesToAdd;
+		
+		for (auto & files_by_conglomerate_itr : files_by_conglomerate)
+		{
+			auto & conglomerate_filename = files_by_conglomerate_itr.first;
+			auto & library_files = files_by_conglomerate_itr.second;
+			
+			if (check_conglomerates)
+			{
+				std::vector<ChibiLibraryFile*> split_files;
+				
+				check_conglomerate(library, conglomerate_filename, library_files, split_files);
+				
+				for (auto * library_file : split_files)
+				{
+					library_file->conglomerate_filename = chibi::InternedString();
+					library_file->compile = true;
+				}
+			}
+			
+			StringBuilder sb;
+		
+			sb.Append("// auto-generated. do not hand-edit\n\n");
+
+			for (auto * library_file : library_files)
+			{
+				assert(library_file->compile == false);
+				
+				sb.AppendFormat("#include \"%s\"\n", library_file->filename.c_str());
+			}
+
+			if (!write_output_file(sb.text.c_str(), conglomerate_filename.c_str()))
+			{
+				report_error(nullptr, "failed to write conglomerate file. path: %s", conglomerate_filename.c_str());
+				return false;
+			}
+			
+			// add the conglomerate file to the list of library files
+			
+			ChibiLibraryFile file;
+			
+			file.filename = conglomerate_filename;
+			
+			if (library.conglomerate_groups.count(conglomerate_filename) != 0)
+				file.group = library.conglomerate_groups[conglomerate_filename];
+
+			filesToAdd.push_back(file);
+		}
+		
+		for (auto & file : filesToAdd)
+		{
+			library.files.push_back(file);
+		}
+		
+		if (!generate_auto_conglomerate_files(library))
+			return false;
+		
+		return true;
+	}
+	
+	// returns the extension for a conglomerate including the given source file, or nullptr when the file can't be
+	// part of a conglomerate. c, c++ and objective-c files are kept apart, as they are compiled differently
+	static const char * get_conglomerate_extension(const std::string & filename)
+	{
+		const std::string extension = get_path_extension(filename, true);
+		
+		if (extension == "cpp" || extension == "cc" || extension == "cxx")
+			return "cpp";
+		else if (extension == "c")
+			return "c";
+		else if (extension == "mm")
+			return "mm";
+		else if (extension == "m")
+			return "m";
+		else
+			return nullptr;
+	}
+	
+	// hashes a path to a number in the range [0, 1)
+	static double hash_path(const std::string & path)
+	{
+		// note : the low bits of FNV-1a are poorly distributed for similar inputs. mix them first
+		
+		uint64_t hash = compute_content_hash(path.c_str(), path.size());
+		
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ull;
+		hash ^= hash >> 33;
+		
+		return (hash >> 11) * (1.0 / 9007199254740992.0);
+	}
+	
+	struct CompileTimeEstimate
+	{
+		double longest = 0.0; // the compile time of the slowest translation unit, in milliseconds
+		double total = 0.0;
+	};
+	
+	// fits a line through the given points using least squares. the intercept and slope are zero, rather than
+	// negative, when the points suggest so
+	static void fit_line(const std::vector<std::pair<double, double>> & points, double & intercept, double & slope)
+	{
+		double sum_x = 0.0;
+		double sum_y = 0.0;
+		double sum_xx = 0.0;
+		double sum_xy = 0.0;
+		
+		for (auto & point : points)
+		{
+			sum_x += point.first;
+			sum_y += point.second;
+			sum_xx += point.first * point.first;
+			sum_xy += point.first * point.second;
+		}
+		
+		const double n = double(points.size());
+		const double denominator = n * sum_xx - sum_x * sum_x;
+		
+		if (denominator > 0.0)
+		{
+			intercept = std::max(0.0, (sum_y * sum_xx - sum_x * sum_xy) / denominator);
+			slope = std::max(0.0, (n * sum_xy - sum_x * sum_y) / denominator);
+		}
+		else
+		{
+			intercept = 0.0;
+			slope = 0.0;
+		}
+	}
+	
+	// replaces the sizes of the given files with their compile times, as measured during the previous build, and
+	// the target size with the equivalent compile time. the fixed cost of compiling a translation unit is left out,
+	// and stored in overhead. returns false when none of the files was measured
+	bool estimate_compile_times(const ChibiLibrary & library, std::map<const ChibiLibraryFile*, double> & costs, double & target_cost, double & overhead, CompileTimeEstimate & measured) const
+	{
+		std::map<std::string, const ChibiLibraryFile*> files_by_filename;
+		std::map<std::string, std::vector<const ChibiLibraryFile*>> files_by_name;
+		
+		for (auto & cost_itr : costs)
+		{
+			auto & filename = cost_itr.first->filename;
+			
+			files_by_filename[filename] = cost_itr.first;
+			files_by_name[filename.substr(filename.find_last_of('/') + 1)].push_back(cost_itr.first);
+		}
+		
+		// look up the files compiled by each log entry. entries are ordered by the time they were built, so when
+		// a file was compiled more than once, by itself or as part of different conglomerates, the last one wins
+		
+		std::map<const ChibiLibraryFile*, std::pair<double, size_t>> measurements; // share of the compile time and log entry index by file
+		
+		std::map<size_t, double> entry_sizes; // the size of the translation unit by log entry index
+		
+		for (size_t entry_index = 0; entry_index < build_log->entries.size(); ++entry_index)
+		{
+			auto & entry = build_log->entries[entry_index];
+			
+			if (entry.target != library.name)
+				continue;
+			
+			const std::string name = entry.source.substr(entry.source.find_last_of('/') + 1);
+			
+			if (string_starts_with(name, "unity-"))
+			{
+				// an automatically generated conglomerate. its compile time is divided between the files it
+				// included, proportional to their size. this can't tell which of the files is slow to compile, so
+				// the estimates are more accurate when the files were compiled by themselves. note : the
+				// conglomerate is read from disk, as it still has the contents it was compiled with at this point
+				
+				const std::string conglomerate_filename = generated_files_path + "/" + library.name + "/" + name;
+				
+				if (BuildLog::source_matches(conglomerate_filename, entry.source) == false)
+					continue;
+				
+				std::vector<char> contents;
+				
+				if (!read_file(conglomerate_filename.c_str(), contents))
+					continue;
+				
+				contents.push_back(0);
+				
+				std::vector<std::pair<std::string, int64_t>> included_files;
+				
+				int64_t included_size = 0;
+				
+				for (const char * line = contents.data(); line != nullptr; )
+				{
+					const char * end = strchr(line, '\n');
+					
+					if (strncmp(line, "#include \"", 10) == 0)
+					{
+						const char * filename_begin = line + 10;
+						const char * filename_end = strchr(filename_begin, '"');
+						
+						if (filename_end != nullptr && (end == nullptr || filename_end < end))
+						{
+							const std::string filename(filename_begin, filename_end);
+							
+							int64_t mtime;
+							int64_t size;
+							if (!get_file_info(filename.c_str(), mtime, size))
+								size = 0;
+							
+							included_files.push_back(std::make_pair(filename, size));
+							included_size += size;
+						}
+					}
+					
+					line = end != nullptr ? end + 1 : nullptr;
+				}
+				
+				for (auto & included_file : included_files)
+				{
+					auto file_itr = files_by_filename.find(included_file.first);
+					
+					if (file_itr != files_by_filename.end())
+					{
+						const double share = included_size != 0 ? included_file.second / double(included_size) : 1.0 / included_files.size();
+						
+						measurements[file_itr->second] = std::make_pair(share, entry_index);
+					}
+				}
+				
+				entry_sizes[entry_index] = double(included_size);
+			}
+			else
+			{
+				auto files_itr = files_by_name.find(name);
+				
+				if (files_itr == files_by_name.end())
+					continue;
+				
+				for (auto * library_file : files_itr->second)
+				{
+					if (BuildLog::source_matches(library_file->filename, entry.source))
+					{
+						measurements[library_file] = std::make_pair(1.0, entry_index);
+						
+						entry_sizes[entry_index] = costs[library_file];
+					}
+				}
+			}
+		}
+		
+		if (measurements.empty())
+			return false;
+		
+		// each translation unit has a fixed cost, mostly spent parsing headers, on top of the cost of the code it
+		// contains. fit a line through the compile times of the translation units against their sizes, to tell
+		// the two apart. only the latter grows as files are added to a conglomerate
+		
+		std::set<size_t> entry_indices;
+		
+		for (auto & measurement_itr : measurements)
+			entry_indices.insert(measurement_itr.second.second);
+		
+		std::vector<std::pair<double, double>> samples; // size and compile time by translation unit
+		
+		for (auto entry_index : entry_indices)
+		{
+			const double duration = double(build_log->entries[entry_index].duration);
+			
+			samples.push_back(std::make_pair(entry_sizes[entry_index], duration));
+			
+			measured.longest = std::max(measured.longest, duration);
+			measured.total += duration;
+		}
+		
+		double slope;
+		fit_line(samples, overhead, slope);
+		
+		// note : translation units which take a lot longer than the line predicts skew it, so the line is fit
+		//        again without them. these are exactly the files which need balancing
+		
+		std::vector<std::pair<double, double>> typical_samples;
+		
+		for (auto & sample : samples)
+			if (sample.second <= (overhead + slope * sample.first) * 2.0)
+				typical_samples.push_back(sample);
+		
+		fit_line(typical_samples, overhead, slope);
+		
+		// note : the line describes a typical file. files which compiled faster than it predicts are assumed to be
+		//        typical still, as their cost can't be less than that of the code they contain. this keeps runs of
+		//        small files from adding up to nothing
+		
+		// files which weren't measured, because they were added since, are estimated from their size, using the
+		// average compile time per byte of the files which were
+		
+		std::map<const ChibiLibraryFile*, double> measured_costs;
+		
+		double measured_cost = 0.0;
+		double measured_size = 0.0;
+		
+		for (auto & measurement_itr : measurements)
+		{
+			auto & entry = build_log->entries[measurement_itr.second.second];
+			
+			const double size = costs[measurement_itr.first];
+			const double cost = std::max((entry.duration - overhead) * measurement_itr.second.first, slope * size);
+			
+			measured_costs[measurement_itr.first] = cost;
+			
+			measured_cost += cost;
+			measured_size += size;
+		}
+		
+		if (measured_cost <= 0.0 || measured_size <= 0.0)
+			return false;
+		
+		const double time_per_byte = measured_cost / measured_size;
+		
+		for (auto & cost_itr : costs)
+		{
+			auto measured_cost_itr = measured_costs.find(cost_itr.first);
+			
+			if (measured_cost_itr != measured_costs.end())
+				cost_itr.second = measured_cost_itr->second;
+			else
+				cost_itr.second *= time_per_byte;
+		}
+		
+		target_cost *= time_per_byte;
+		
+		return true;
+	}
+	
+	// partitions the files marked for automatic conglomeration into conglomerates of roughly equal size. when a
+	// build log is set, the compile times measured during the previous build are balanced instead
+	bool generate_auto_conglomerate_files(ChibiLibrary & library)
+	{
+		const int64_t target_size =
+			library.auto_conglomerate_size != 0
+			? library.auto_conglomerate_size
+			: kDefaultAutoConglomerateSize;
+		
+		// gather the files by the type of conglomerate they may be part of. files are sorted by name at this point
+		
+		std::map<std::string, std::vector<ChibiLibraryFile*>> files_by_extension;
+		
+		std::map<const ChibiLibraryFile*, double> costs;
+		
+		for (auto & library_file : library.files)
+		{
+			if (library_file.compile == false || library_file.conglomerate_filename.empty() == false)
+				continue;
+			
+			if (library_file.auto_conglomerate == false && library.auto_conglomerate == false)
+				continue;
+			
+			const char * extension = get_conglomerate_extension(library_file.filename);
+			
+			if (extension == nullptr)
+				continue;
+			
+			int64_t mtime;
+			int64_t size;
+			if (!get_file_info(library_file.filename.c_str(), mtime, size))
+				size = 0;
+			
+			files_by_extension[extension].push_back(&library_file);
+			costs[&library_file] = double(size);
+		}
+		
+		if (costs.empty())
+			return true;
+		
+		double target_cost = double(target_size);
+		
+		double overhead = 0.0;
+		
+		CompileTimeEstimate measured;
+		CompileTimeEstimate estimated;
+		
+		bool use_compile_times = false;
+		
+		if (build_log != nullptr)
+		{
+			use_compile_times = estimate_compile_times(library, costs, target_cost, overhead, measured);
+			
+			if (use_compile_times == false)
+			{
+				std::lock_guard<std::mutex> lock(compile_time_reports_mutex);
+				
+				compile_time_reports[library.name] = "auto_conglomerate: " + library.name + ": no compile times found in the build log. partitioning by file size\n";
+			}
+		}
+		
+		double slowest_cost = 0.0;
+		
+		for (auto & cost_itr : costs)
+			slowest_cost = std::max(slowest_cost, cost_itr.second);
+		
+		std::vector<ChibiLibraryFile> files_to_add;
+		
+		for (auto & files_by_extension_itr : files_by_extension)
+		{
+			auto & extension = files_by_extension_itr.first;
+			auto & library_files = files_by_extension_itr.second;
+			
+			// decide where each partition ends. a partition ends after a file depending only on the file itself: its
+			// path hash is compared against its share of the target size. this makes the partitions stable. adding or
+			// removing a file only affects the partition it's part of and the one after it, so the other conglomerates keep
+			// their contents, and don't need to be compiled again
+			
+			std::vector<std::vector<ChibiLibraryFile*>> partitions(1);
+			
+			double partition_cost = 0.0;
+			
+			const double max_cost =
+				use_compile_times
+				? std::min(target_cost * 1.5, std::max(target_cost, slowest_cost))
+				: target_cost * 2.0;
+			
+			for (auto * library_file : library_files)
+			{
+				const double cost = costs[library_file];
+				
+				// note : a partition never grows beyond twice the target size, unless a single file is larger than
+				//        that. when balancing compile times, the limit is tighter: conglomerates shouldn't take longer
+				//        to compile than the slowest file, which can't be split up. partitions end at a fixed size
+				//        more often then, which makes them less stable
+				
+				if (partitions.back().empty() == false && partition_cost + cost > max_cost)
+				{
+					partitions.emplace_back();
+					partition_cost = 0.0;
+				}
+				
+				partitions.back().push_back(library_file);
+				partition_cost += cost;
+				
+				// note : boundaries are only considered once the partition is half the target size. the chance of a
+				//        boundary is set up so the remaining half is reached on average
+				
+				const bool is_boundary = hash_path(library_file->filename) < cost / (target_cost / 2.0);
+				
+				if (is_boundary && partition_cost >= target_cost / 2.0)
+				{
+					partitions.emplace_back();
+					partition_cost = 0.0;
+				}
+			}
+			
+			// generate a conglomerate file for each partition. conglomerates are named after their first file, so
+			// their names remain the same when files are added or removed elsewhere
+			
+			for (auto & partition : partitions)
+			{
+				if (partition.empty())
+					continue;
+				
+				double compile_time = overhead;
+				
+				for (auto * library_file : partition)
+					compile_time += costs[library_file];
+				
+				estimated.longest = std::max(estimated.longest, compile_time);
+				estimated.total += compile_time;
+				
+				// leave out modified files (in adaptive mode). the partitions are decided on beforehand, so the
+				// other conglomerates stay the same as modified files come and go
+				
+				const std::string & first_filename = partition.front()->filename;
+				
+				partition.erase(
+					std::remove_if(partition.begin(), partition.end(),
+						[](const ChibiLibraryFile * library_file) { return library_file->is_modified; }),
+					partition.end());
+				
+				const size_t name_begin = first_filename.find_last_of('/') + 1;
+				const size_t name_end = first_filename.find_last_of('.');
+				
+				char filename[PATH_MAX];
+				if (!concat(filename, sizeof(filename), library.name.c_str(), "/unity-", first_filename.substr(name_begin, name_end - name_begin).c_str()))
+				{
+					report_error(nullptr, "failed to create conglomerate filename");
+					return false;
+				}
+				
+				const size_t length = strlen(filename);
+				snprintf(filename + length, sizeof(filename) - length, "-%08x.%s",
+					(uint32_t)(hash_path(first_filename) * 4294967296.0),
+					extension.c_str());
+				
+				if (check_conglomerates && partition.size() >= 2)
+				{
+					std::vector<ChibiLibraryFile*> split_files;
+					
+					check_conglomerate(library, filename, partition, split_files);
+				}
+				
+				// note : files which end up by themselves are compiled as usual
+				
+				if (partition.size() < 2)
+					continue;
+				
+				StringBuilder sb;
+				
+				sb.Append("// auto-generated. do not hand-edit\n\n");
+				
+				for (auto * library_file : partition)
+					sb.AppendFormat("#include \"%s\"\n", library_file->filename.c_str());
+				
+				if (!write_generated_file(filename, sb.text.c_str()))
+					return false;
+				
+				// add the conglomerate file to the list of library files
+				
+				ChibiLibraryFile file;
+				file.filename = generated_path + "/" + filename;
+				
+				const chibi::InternedString conglomerate_filename(file.filename);
+				
+				for (auto * library_file : partition)
+				{
+					library_file->conglomerate_filename = conglomerate_filename;
+					library_file->compile = false;
+				}
+				
+				files_to_add.push_back(file);
+			}
+		}
+		
+		for (auto & file : files_to_add)
+			library.files.push_back(file);
+		
+		if (use_compile_times)
+		{
+			char text[1024];
+			sprintf_s(text, sizeof(text),
+				"auto_conglomerate: %s: longest translation unit %.1fs -> %.1fs, total compile time %.1fs -> %.1fs (estimated from the build log)\n",
+				library.name.c_str(),
+				measured.longest / 1000.0, estimated.longest / 1000.0,
+				measured.total / 1000.0, estimated.total / 1000.0);
+			
+			std::lock_guard<std::mutex> lock(compile_time_reports_mutex);
+			
+			compile_time_reports[library.name] = text;
+		}
+		
+		return true;
+	}
+	
+	bool write_library(const ChibiInfo & chibi_info, const ChibiLibrary & library, StringBuilder & sb)
+	{
+		sb.AppendFormat("# --- library %s ---\n", library.name.c_str());
+		sb.Append("\n");
+		
+		bool has_compile_disabled_files = false;
+		
+		// in compact mode, files which aren't compiled are listed separately, for IDE generators only
+		
+		const bool list_all_files = compact == false || library.prebuilt;
+		
+		bool has_ide_only_files = false;
+		
+		sb.Append("add_library(");
+		sb.Append(library.name.c_str());
+		
+		if (library.shared)
+			sb.Append("\n\tSHARED");
+		else
+			sb.Append("\n\tSTATIC");
+		
+		if (library.prebuilt)
+			sb.Append(" IMPORTED");
+		
+		for (auto & file : library.files)
+		{
+			if (file.compile == false)
+				has_compile_disabled_files = true;
+			
+			if (list_all_files == false && (file.compile == false || is_header_file(file.filename)))
+			{
+				has_ide_only_files = true;
+				continue;
+			}
+			
+			sb.Append("\n\t");
+			sb.AppendFormat("\"%s\"", file.filename.c_str());
+		}
+
+		if (true)
+		{
+			// add chibi file to target
+
+			sb.Append("\n\t");
+			sb.AppendFormat("\"%s\"", library.chibi_file.c_str());
+		}
+		
+		sb.Append(")\n");
+		sb.Append("\n");
+		
+		if (library.prebuilt)
+		{
+			// special case: set imported library location
+			sb.Append("# (this library import is auto-generated from a embed_framework local library dependency)\n");
+			sb.Append("set_target_properties("); sb.Append(library.name.c_str());
+			sb.Append("\n\tPROPERTIES IMPORTED_LOCATION");
+			sb.Append("\n\t"); sb.Append(library.path.c_str());
+			sb.Append(")\n");
+			sb.Append("\n");
+		}
+		
+		if (library.group_name.empty() == false)
+		{
+			sb.AppendFormat("set_target_properties(%s PROPERTIES FOLDER %s)\n\n",
+				library.name.c_str(),
+				library.group_name.c_str());
+		}
+		
+		if (has_ide_only_files)
+		{
+			sb.AppendFormat("if (%s)\n", s_list_all_files_condition);
+			sb.AppendFormat("\ttarget_sources(%s PRIVATE", library.name.c_str());
+			
+			for (auto & file : library.files)
+			{
+				if (file.compile == false || is_header_file(file.filename))
+					sb.AppendFormat("\n\t\t\"%s\"", file.filename.c_str());
+			}
+			
+			sb.Append(")\n");
+			
+			if (has_compile_disabled_files)
+			{
+				sb.Append("\tset_source_files_properties(");
+				
+				for (auto & file : library.files)
+				{
+					if (file.compile == false)
+						sb.AppendFormat("\n\t\t\"%s\"", file.filename.c_str());
+				}
+				
+				sb.Append("\n\t\tPROPERTIES HEADER_FILE_ONLY 1)\n");
+			}
+			
+			sb.Append("endif ()\n");
+			sb.Append("\n");
+		}
+		else if (has_compile_disabled_files)
+		{
+			sb.Append("set_source_files_properties(");
+			
+			for (auto & file : library.files)
+			{
+				if (file.compile == false)
+				{
+					sb.Append("\n\t");
+					sb.AppendFormat("\"%s\"", file.filename.c_str());
+				}
+			}
+			
+			sb.Append("\n\tPROPERTIES HEADER_FILE_ONLY 1");
+			
+			sb.Append(")\n");
+			sb.Append("\n");
+		}
+		
+		if (!write_header_paths(sb, library))
+			return false;
+		
+		if (!write_compile_definitions(sb, library))
+			return false;
+		
+		if (!write_precompiled_header(chibi_info, sb, library))
+			return false;
+		
+		if (!write_library_dependencies(sb, library))
+			return false;
+		
+		if (!write_package_dependencies(sb, library))
+			return false;
+		
+		if (s_platform == "windows")
+		{
+			sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY LINK_FLAGS \" /SAFESEH:NO\")\n", library.name.c_str());
+			sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4244\")\n", library.name.c_str()); // disable 'conversion from type A to B, possible loss of data' warning
+			sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4018\")\n", library.name.c_str()); // disable 'signed/unsigned mismatch' warning
+			
+			sb.Append("\n");
+		}
+		
+		if (library.objc_arc)
+		{
+			// note : we only support enabling ARC for Apple platforms right now
+			if (s_platform == "macos" || s_platform == "iphoneos")
+			{
+				sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" -fobjc-arc\")", library.name.c_str());
+			}
+		}
+		
+		return true;
+	}
+	
+	bool write_app(const ChibiInfo & chibi_info, const ChibiLibrary & app, StringBuilder & sb)
+	{
+		sb.AppendFormat("# --- app %s ---\n", app.name.c_str());
+		sb.Append("\n");
+		
+		if (is_platform("android"))
+		{
+			// note : on android there are no real standalone executables,
+			//        only shared libraries, loaded by a Java-defined activity
+			sb.Append("add_library(");
+			sb.Append(app.name.c_str());
+			sb.Append("\n\tSHARED");
+		}
+		else
+		{
+			sb.Append("add_executable(");
+			sb.Append(app.name.c_str());
+			sb.Append("\n\tMACOSX_BUNDLE");
+		}
+		
+		// in compact mode, header files are listed separately, for IDE generators only
+		
+		bool has_ide_only_files = false;
+		
+		for (auto & file : app.files)
+		{
+			if (compact && is_header_file(file.filename))
+			{
+				has_ide_only_files = true;
+				continue;
+			}
+			
+			sb.Append("\n\t");
+			sb.AppendFormat("\"%s\"", file.filename.c_str());
+		}
+
+		if (true)
+		{
+			// add chibi file to target
+			
+			sb.Append("\n\t");
+			sb.AppendFormat("\"%s\"", app.chibi_file.c_str());
+		}
+		
+		sb.Append(")\n");
+		sb.Append("\n");
+		
+		if (has_ide_only_files)
+		{
+			sb.AppendFormat("if (%s)\n", s_list_all_files_condition);
+			sb.AppendFormat("\ttarget_sources(%s PRIVATE", app.name.c_str());
+			
+			for (auto & file : app.files)
+			{
+				if (is_header_file(file.filename))
+					sb.AppendFormat("\n\t\t\"%s\"", file.filename.c_str());
+			}
+			
+			sb.Append(")\n");
+			sb.Append("endif ()\n");
+			sb.Append("\n");
+		}
+		
+		if (app.group_name.empty() == false)
+		{
+			sb.AppendFormat("set_target_properties(%s PROPERTIES FOLDER %s)\n",
+				app.name.c_str(),
+				app.group_name.c_str());
+			sb.Append("\n");
+		}
+
+		// copy app resources
+		
+		if (s_platform == "macos")
+		{
+			write_set_osx_bundle_path(sb, app.name.c_str());
+		}
+		else if (s_platform == "iphoneos")
+		{
+			write_set_ios_bundle_path(sb, app.name.c_str());
+		}
+		
+		if (!app.resource_path.empty())
+		{
+			if (s_platform == "macos")
+			{
+				const char * resource_path = "${BUNDLE_PATH}/Contents/Resources";
+				
+				if (!write_copy_resources_for_distribution_using_rsync(sb, app, app, resource_path))
+					return false;
+				
+				sb.AppendFormat("target_compile_definitions(%s PRIVATE %sCHIBI_RESOURCE_PATH=\"%s\"%s)\n",
+					app.name.c_str(),
+					dont_makearchive_conditional_begin.c_str(),
+					app.resource_path.c_str(),
+					dont_makearchive_conditional_end.c_str());
+				sb.Append("\n");
+			}
+			else if (s_platform == "iphoneos")
+			{
+				const char * resource_path = "${BUNDLE_PATH}";
+				
+				if (!write_copy_resources_for_distribution_using_rsync(sb, app, app, resource_path))
+					return false;
+				
+				// note : for iphoneos we always copy resources (so a build can always be run and debugged on
+				//        a device). this means the main resource path will just be '.'
+				sb.AppendFormat("target_compile_definitions(%s PRIVATE CHIBI_RESOURCE_PATH=\".\")\n",
+					app.name.c_str());
+				sb.Append("\n");
+			}
+			else
+			{
+				sb.AppendFormat("target_compile_definitions(%s PRIVATE %sCHIBI_RESOURCE_PATH=\"%s\"%s)\n",
+					app.name.c_str(),
+					dont_makearchive_conditional_begin.c_str(),
+					app.resource_path.c_str(),
+					dont_makearchive_conditional_end.c_str());
+				sb.Append("\n");
+			}
+		}
+		
+		// copy library resources
+		
+		auto * all_library_dependencies = chibi_info.dependency_graph.get_all_library_dependencies(app);
+		if (all_library_dependencies == nullptr)
+			return false;
+		
+		for (auto * library_dependency : *all_library_dependencies)
+		{
+			if (library_dependency->type == ChibiLibraryDependency::kType_Generated)
+			{
+				auto * library = library_dependency->library;
+				
+				if (library->resource_path.empty() == false)
+				{
+					const char * resource_path = nullptr;
+					
+					if (s_platform == "macos")
+						resource_path = "${BUNDLE_PATH}/Contents/Resources/libs";
+					else if (s_platform == "iphoneos")
+						resource_path = "${BUNDLE_PATH}/libs";
+					else if (s_platform == "windows")
+						continue; // note : windows is handled separately in write_create_windows_app_archive
+					else if (s_platform == "android")
+						continue; // note : android assets are copied through gradle sync tasks
+					else
+						continue; // todo : add linux here
+					
+					assert(resource_path != nullptr);
+					if (resource_path != nullptr)
+					{
+						char destination_path[PATH_MAX];
+						concat(destination_path, sizeof(destination_path), resource_path, "/", library->name.c_str());
+						if (!write_copy_resources_for_distribution_using_rsync(sb, app, *library, destination_path))
+							return false;
+					}
+				}
+			}
+		}
+		
+		// copy library license files
+		
+		for (auto * library_dependency : *all_library_dependencies)
+		{
+			if (library_dependency->type == ChibiLibraryDependency::kType_Generated)
+			{
+				auto * library = library_dependency->library;
+			
+				if (library->license_files.empty() == false)
+				{
+					const char * license_path = nullptr;
+					
+					if (s_platform == "macos")
+						license_path = "${BUNDLE_PATH}/Contents/license";
+					else if (s_platform == "iphoneos")
+						license_path = "${BUNDLE_PATH}/license";
+					else
+						continue; // todo : add windows and linux here
+					
+					assert(license_path != nullptr);
+					if (license_path != nullptr)
+					{
+						char destination_path[PATH_MAX];
+						concat(destination_path, sizeof(destination_path), license_path, "/", library->name.c_str());
+						
+						if (!write_copy_license_files_for_distribution_using_rsync(sb, app, *library, destination_path))
+							return false;
+					}
+				}
+			}
+		}
+		
+		if (!write_app_resource_paths(sb, app, *all_library_dependencies))
+			return false;
+		
+		if (!write_header_paths(sb, app))
+			return false;
+		
+		if (!write_compile_definitions(sb, app))
+			return false;
+		
+		if (!write_precompiled_header(chibi_info, sb, app))
+			return false;
+		
+		if (!write_library_dependencies(sb, app))
+			return false;
+		
+		if (!write_package_dependencies(sb, app))
+			return false;
+		
+		if (!write_embedded_app_files(sb, app, *all_library_dependencies))
+			return false;
+		
+		if (s_platform == "windows")
+		{
+			sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY LINK_FLAGS \" /SAFESEH:NO\")\n", app.name.c_str());
+			sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4244\")\n", app.name.c_str()); // disable 'conversion from type A to B, possible loss of data' warning
+			sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4018\")\n", app.name.c_str()); // disable 'signed/unsigned mismatch' warning
+			
+			sb.Append("\n");
+		}
+		
+		if (app.objc_arc)
+		{
+			// note : we only support enabling ARC for Apple platforms right now
+			if (s_platform == "macos" || s_platform == "iphoneos")
+			{
+				sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" -fobjc-arc\")", app.name.c_str());
+			}
+		}
+		
+		if (s_platform == "macos" || s_platform == "iphoneos")
+		{
+			// generate plist text
+			
+			std::string text;
+			
+		// todo : let these plist flags originate from apps/libraries that need them
+		// todo : add opportunity to merge with custom plist files, for advanced plist settings
+			if (!generate_plist(nullptr, app.name.c_str(),
+				kPlistFlag_HighDpi |
+				kPlistFlag_AccessWebcam |
+				kPlistFlag_AccessMicrophone,
+				text))
+			{
+				report_error(nullptr, "failed to generate plist file");
+				return false;
+			}
+			
+			// fill in the app identifier. the other variables are left for cmake to fill in, when it configures the plist
+			// todo : imagine a clean way to set the identifier
+			
+			const std::string identifier_variable = "${APPLE_GUI_IDENTIFIER}";
+			
+			for (size_t pos = text.find(identifier_variable); pos != std::string::npos; pos = text.find(identifier_variable, pos))
+			{
+				const std::string identifier = "com.chibi." + app.name;
+				
+				text.replace(pos, identifier_variable.size(), identifier);
+				pos += identifier.size();
+			}
+			
+			// write the plist file to disk
+			
+			char plist_filename[PATH_MAX];
+			char plist_path[PATH_MAX];
+			if (!concat(plist_filename, sizeof(plist_filename), app.name.c_str(), ".plist") ||
+				!concat(plist_path, sizeof(plist_path), generated_path.c_str(), "/", plist_filename))
+			{
+				report_error(nullptr, "failed to create plist path");
+				return false;
+			}
+
+			if (!write_generated_file(plist_filename, text.c_str()))
+				return false;
+
+			// tell cmake to use our generated plist file
+			
+			sb.AppendFormat("set_target_properties(%s PROPERTIES MACOSX_BUNDLE_INFO_PLIST \"%s\")\n",
+				app.name.c_str(),
+				plist_path);
+			sb.Append("\n");
+		}
+
+		if (s_platform == "macos")
+		{
+			// add rpath to the generated executable so that it can find dylibs inside the location of the executable itself. this is needed when copying generated shared libraries into the app bundle
+			
+			// note : we use a conditional to check if we're building a distribution app bundle
+			//        ideally CMake would have build config dependent custom commands,
+			//        but since it doesn't, we prepend 'echo' to the command, depending on
+			//        whether this is a distribution build or not
+		
+		// fixme : cmake is broken and always runs the custom command, regardless of whether the DEPENDS target is dirty or not. this causes install_name_tool to fail, as the rpath has already been set. I've appended "|| true" at the end of the command, to effectively ignore the return code from install_name_tool. a nasty side effect of this is we don't know whether the command succeeded or actually failed for some valid reason.. so ideally this hack is removed once cmake's behavior is fixed
+		
+			write_custom_command_for_distribution_va(sb,
+				app.name.c_str(),
+				app.name.c_str(),
+				"install_name_tool -add_rpath \"@executable_path\" \"${BUNDLE_PATH}/Contents/MacOS/%s\" || true",
+				app.name.c_str());
+		}
+		
+		if (s_platform == "windows")
+		{
+			write_create_windows_app_archive(sb, app, *all_library_dependencies);
+		}
+	
+		if (s_platform == "macos" || s_platform == "iphoneos")
+		{
+			// unset bundle path when we're done processing this app
+			sb.Append("unset(BUNDLE_PATH)\n\n");
+		}
+
+		return true;
+	}
+	
+	bool write_source_groups(const ChibiLibrary & library, StringBuilder & sb)
+	{
+		bool empty = true;
+		
+		// source groups only affect IDE generators. in compact mode we skip them for other generators
+		
+		if (compact)
+			sb.AppendFormat("if (%s)\n", s_list_all_files_condition);
+		
+		sb.AppendFormat("# --- source group memberships for %s ---\n", library.name.c_str());
+		sb.Append("\n");
+		
+		std::map<std::string, std::vector<const ChibiLibraryFile*>> files_by_group;
+
+		for (auto & file : library.files)
+		{
+			auto & group_files = files_by_group[file.group];
+			
+			group_files.push_back(&file);
+		}
+		
+		for (auto & group_files_itr : files_by_group)
+		{
+			auto & group = group_files_itr.first;
+			auto & files = group_files_itr.second;
+		
+		#if 0
+			printf("group: %s\n", group.c_str());
+		#endif
+			
+			sb.AppendFormat("source_group(\"%s\" FILES", group.c_str());
+			
+			for (auto & file : files)
+				sb.AppendFormat("\n\t\"%s\"", file->filename.c_str());
+			
+			sb.Append(")\n");
+			sb.Append("\n");
+		
+			empty = false;
+		}
+		
+		if (compact)
+			sb.Append("endif ()\n\n");
+		
+		if (empty)
+			sb.Reset();
+		
+		return true;
+	}
+	
+	bool write_target_files(StringBuilder & output_sb, const std::vector<ChibiLibrary*> & libraries, const char * output_filename)
+	{
+		// write the output for each library and app to its own file, and include these files from the main output
+		
+		char output_path[PATH_MAX];
+		char targets_path[PATH_MAX];
+		if (!get_path_from_filename(output_filename, output_path, sizeof(output_path)) ||
+			!concat(targets_path, sizeof(targets_path), output_path, "/chibi-targets"))
+		{
+			report_error(nullptr, "failed to create absolute path");
+			return false;
+		}
+		
+		if (!create_directory(targets_path))
+		{
+			report_error(nullptr, "failed to create directory: %s", targets_path);
+			return false;
+		}
+		
+		// note : libraries are included before apps, as this is the order in which they appear in the non-split output
+		
+		std::vector<const ChibiLibrary*> targets;
+		
+		for (auto * library : libraries)
+			if (library->isExecutable == false)
+				targets.push_back(library);
+		
+		for (auto * app : libraries)
+			if (app->isExecutable)
+				targets.push_back(app);
+		
+		output_sb.Append("# --- targets ---\n");
+		output_sb.Append("\n");
+		
+		std::set<std::string> target_filenames;
+		
+		for (auto * target : targets)
+		{
+			const std::string target_filename = std::string(targets_path) + "/" + target->name + ".cmake";
+			
+			StringBuilder sb;
+			
+			sb.Append("# auto-generated. do not hand-edit\n\n");
+			sb.Append(target_sbs[target->id].text.c_str());
+			
+			if (!write_output_file(sb.text.c_str(), target_filename.c_str()))
+			{
+				report_error(nullptr, "failed to write output file: %s", target_filename.c_str());
+				return false;
+			}
+			
+			output_sb.AppendFormat("include(\"${CMAKE_CURRENT_LIST_DIR}/chibi-targets/%s.cmake\")\n", target->name.c_str());
+			
+			target_filenames.insert(target_filename);
+		}
+		
+		output_sb.Append("\n");
+		
+		// remove the files for targets which are no longer part of the build
+		
+		for (auto & filename : listFiles(targets_path, false))
+		{
+			if (string_ends_with(filename, ".cmake") && target_filenames.count(filename) == 0)
+				remove(filename.c_str());
+		}
+		
+		return true;
+	}
+	
+	bool write(const ChibiInfo & chibi_info, const char * platform, const char * output_filename)
+	{
+		// decode platform
+		
+		const char * separator = strchr(platform, '.');
+		
+		if (separator == nullptr)
+		{
+			s_platform = platform;
+			s_platform_full.clear();
+		}
+		else
+		{
+			s_platform = std::string(platform).substr(0, separator - platform);
+			s_platform_full = platform;
+		}
+		
+		// note : generated files are written by us directly, next to the output file, rather than by cmake at
+		//        configure time. cmake refers to them relative to the output file's location
+		
+		char output_path[PATH_MAX];
+		if (!get_path_from_filename(output_filename, output_path, sizeof(output_path)))
+		{
+			report_error(nullptr, "failed to create abolsute path");
+			return false;
+		}
+		
+		generated_files_path = std::string(output_path) + "/generated";
+		generated_path = "${CMAKE_CURRENT_SOURCE_DIR}/generated";
+		
+		// gather the library targets to emit
+		
+		std::set<std::string> traversed_libraries;
+		
+		std::vector<ChibiLibrary*> libraries;
+		
+		for (auto & library : chibi_info.libraries)
+		{
+			if (traversed_libraries.count(library->name) != 0)
+				continue;
+			
+			if (library->isExecutable && chibi_info.should_build_target(library->name.c_str()))
+			{
+				if (handle_library(chibi_info, *library, traversed_libraries, libraries) == false)
+					return false;
+			}
+		}
+		
+		for (auto & library : chibi_info.libraries)
+		{
+			if (traversed_libraries.count(library->name) != 0)
+				continue;
+			
+			if (chibi_info.should_build_target(library->name.c_str()))
+			{
+				if (handle_library(chibi_info, *library, traversed_libraries, libraries) == false)
+					return false;
+			}
+		}
+		
+	// todo : make conglomerate generation independent of cmake writer
+
+		// sort files by name and generate conglomerate files. libraries are independent here, so we process them concurrently
+		
+		{
+			std::vector<char> results(libraries.size(), false);
+			
+			TaskGroup task_group;
+			
+			for (size_t i = 0; i < libraries.size(); ++i)
+			{
+				task_group.add([&, i]()
+					{
+						results[i] = generate_conglomerate_files(*libraries[i]);
+					});
+			}
+			
+			task_group.wait();
+			
+			for (auto result : results)
+				if (result == false)
+					return false;
+			
+			if (!remove_stale_unity_files())
+				return false;
+			
+			for (auto * library : libraries)
+			{
+				auto report_itr = compile_time_reports.find(library->name);
+				
+				if (report_itr != compile_time_reports.end())
+					printf("%s", report_itr->second.c_str());
+			}
+			
+			for (auto * library : libraries)
+			{
+				auto report_itr = conglomerate_check_reports.find(library->name);
+				
+				if (report_itr != conglomerate_check_reports.end())
+					printf("%s", report_itr->second.c_str());
+			}
+			
+			// note : unity builds fail to compile, or worse, behave differently when files in the same conglomerate
+			//        conflict. the build files aren't written in this case
+			
+			if (num_conglomerate_conflicts != 0)
+			{
+				report_error(nullptr, "found %d conflicts between files in the same conglomerate. use -split-conglomerates to compile the files causing them by themselves", num_conglomerate_conflicts);
+				return false;
+			}
+			else if (check_conglomerates && conglomerate_check_reports.empty())
+			{
+				printf("check_conglomerates: no conflicts found\n");
+			}
+		}
+
+		// turn shared libraries into non-shared for iphoneos, since I didn't manage
+		// to do code signing propertly yet, and iphoneos refuses to load our .dylibs
+		if (s_platform == "iphoneos")
+		{
+		// todo : run code signing on generated shared libraries for macos/iphoneos
+			for (auto & library : libraries)
+				library->shared = false;
+		}
+		
+		// always build a self-contained archive for iphoneos and android,
+		// as any build type could be deployed on an actual device, and the
+		// app won't have access to the local filesystem for loading resources
+		// and libraries
+		if (s_platform == "iphoneos" || s_platform == "android")
 		{
 			dont_makearchive_conditional_begin = "$<$<BOOL:false>:";
 			dont_makearchive_conditional_end = ">";
@@ -1234,24 +3150,15 @@ struct CMakeWriter
 		always_conditional_begin = "$<$<BOOL:false>:";
 		always_conditional_end = ">";
 		
-		// write CMake output
+		// generate CMake output. we write the file only when its contents changed, as touching it triggers a
+		// reconfigure of every build directory which uses it
 		
-		FileHandle f(output_filename, "wt");
+		StringBuilder output_sb;
+		
+		if (split_targets)
+			target_sbs.resize(chibi_info.libraries.size());
 		
-		if (f == nullptr)
-		{
-			report_error(nullptr, "failed to open output file: %s", output_filename);
-			return false;
-		}
-		else
 		{
-			char generated_path[PATH_MAX];
-			if (!concat(generated_path, sizeof(generated_path), "${CMAKE_CURRENT_BINARY_DIR}/generated"))
-			{
-				report_error(nullptr, "failed to create abolsute path");
-				return false;
-			}
-			
 			{
 				StringBuilder sb;
 				
@@ -1270,6 +3177,12 @@ struct CMakeWriter
 					sb.Append("\n");
 				}
 				
+				if (regenerate_command.empty() == false)
+				{
+					if (!write_regeneration(sb, chibi_info))
+						return false;
+				}
+				
 				sb.Append("project(Project)\n");
 				sb.Append("\n");
 
@@ -1333,592 +3246,180 @@ struct CMakeWriter
 				sb.Append("endif ()\n");
 				sb.Append("\n");
 				sb.Append("if ((CMAKE_CXX_COMPILER_ID MATCHES \"MSVC\") AND CMAKE_CL_64)\n");
-				sb.Append("\tadd_definitions(-D__SSE2__)\n");
-				sb.Append("\tadd_definitions(-D__SSSE3__)\n");
-				sb.Append("endif ()\n");
-				sb.Append("\n");
-
-			// fixme : this should be defined through the user's workspace
-				if (s_platform == "macos")
-				{
-					//sb.Append("add_compile_options(-mavx2)\n");
-				}
-				
-				if (s_platform == "windows")
-				{
-					// Windows.h defines min and max macros, which are always causing issues in portable code
-					// we can get rid of them by defining NOMINMAX before including Windows.h
-					sb.Append("add_definitions(-DNOMINMAX)\n");
-					sb.Append("\n");
-				}
-
-				// let CMake generate export definitions for all symbols it finds inside the generated object files, to normalize the behavior
-				// across Windows and Linux/OSX; which, Windows being the odd one out, both do by default
-			// todo : is this still needed ? we already have shared library support and the translation unit linkage feature to help us out
-				sb.Append("set(CMAKE_WINDOWS_EXPORT_ALL_SYMBOLS TRUE)\n");
-				sb.Append("\n");
-				
-				// normalize the group delimiter to be '/'
-				sb.Append("set(SOURCE_GROUP_DELIMITER \"/\")\n");
-				sb.Append("\n");
-				
-				// add a 'Distribution' build type. this build type is used for making
-				// 'final' builds of an app. on Macos for instance, it creates a self-
-				// contained app bundle, including all of the dylibs, frameworks and
-				// resources referenced by the app
-				sb.Append("list(APPEND CMAKE_CONFIGURATION_TYPES Distribution)\n");
-				sb.Append("set(CMAKE_CXX_FLAGS_DISTRIBUTION \"${CMAKE_CXX_FLAGS_RELEASE} -DCHIBI_BUILD_DISTRIBUTION=1\")\n");
-				sb.Append("set(CMAKE_C_FLAGS_DISTRIBUTION \"${CMAKE_C_FLAGS_RELEASE} -DCHIBI_BUILD_DISTRIBUTION=1\")\n");
-				sb.Append("set(CMAKE_EXE_LINKER_FLAGS_DISTRIBUTION \"${CMAKE_EXE_LINKER_FLAGS_RELEASE}\")\n");
-				sb.Append("set(CMAKE_SHARED_LINKER_FLAGS_DISTRIBUTION \"${CMAKE_SHARED_LINKER_FLAGS_RELEASE}\")\n");
-				sb.Append("\n");
-
-			// todo : global compile options should be user-defined
-				if (is_platform("linux.raspberry-pi"))
-				{
-					sb.Append("add_compile_options(-mcpu=cortex-a53)\n");
-					sb.Append("add_compile_options(-mfpu=neon-fp-armv8)\n");
-					sb.Append("add_compile_options(-mfloat-abi=hard)\n");
-					sb.Append("add_compile_options(-funsafe-math-optimizations)\n");
-					sb.Append("\n");
-				}
-				
-				if (!output(f, sb))
-					return false;
-			}
-			
-		#if 0
-			{
-				// CMake has a nice ability where it shows you which include directories and compile-time definitions
-				// are used for the targets being processed. we don't enable this by default, since it generates a lot
-				// of messages, so it must be enabled here
-				
-				StringBuilder sb;
-				
-				sb.Append("set(CMAKE_DEBUG_TARGET_PROPERTIES\n");
-				sb.Append("\tINCLUDE_DIRECTORIES\n");
-				sb.Append("\tCOMPILE_DEFINITIONS\n");
-				sb.Append(")\n");
-				
-				if (!output(f, sb))
-					return false;
-			}
-		#endif
-		
-			{
-				// copy header files aliased through copy
-				
-				StringBuilder sb;
-				
-				sb.AppendFormat("# --- aliased header paths ---\n");
-				sb.Append("\n");
-				
-				for (auto & library : libraries)
-				{
-					for (auto & header_path : library->header_paths)
-					{
-						if (header_path.alias_through_copy.empty() == false)
-						{
-							char alias_path[PATH_MAX];
-							if (!concat(alias_path, sizeof(alias_path), generated_path, "/",
-							 	library->name.c_str()))
-							{
-								report_error(nullptr, "failed to create absolute path");
-								return false;
-							}
-							
-							char copy_path[PATH_MAX];
-							if (!concat(copy_path, sizeof(copy_path), alias_path, "/", header_path.alias_through_copy.c_str()))
-							{
-								report_error(nullptr, "failed to create absolute path");
-								return false;
-							}
-							
-							sb.AppendFormat("file(MAKE_DIRECTORY \"%s\")\n", copy_path);
-							
-							header_path.alias_through_copy_path = alias_path;
-							
-							// note : file(COPY.. ) will check timestamps and avoid the copy if source and destination have matching timestamps
-							sb.AppendFormat("file(COPY \"%s/\" DESTINATION \"%s\")\n",
-								header_path.path.c_str(),
-								copy_path);
-							sb.Append("\n");
-						}
-					}
-				}
-				
-				if (!output(f, sb))
-					return false;
-			}
-
-			{
-				// generate translation unit linkage files
-
-				StringBuilder sb;
-				
-				sb.AppendFormat("# --- translation unit linkage files ---\n");
-				sb.Append("\n");
-
-				if (generate_translation_unit_linkage_files(chibi_info, sb, generated_path, libraries) == false)
-					return false;
-
-				if (!output(f, sb))
-					return false;
-			}
-			
-			for (auto & library : libraries)
-			{
-				if (library->isExecutable)
-					continue;
-				
-				StringBuilder sb;
-				
-				sb.AppendFormat("# --- library %s ---\n", library->name.c_str());
-				sb.Append("\n");
-				
-				bool has_compile_disabled_files = false;
-				
-				sb.Append("add_library(");
-				sb.Append(library->name.c_str());
-				
-				if (library->shared)
-					sb.Append("\n\tSHARED");
-				else
-					sb.Append("\n\tSTATIC");
-				
-				if (library->prebuilt)
-					sb.Append(" IMPORTED");
-				
-				for (auto & file : library->files)
-				{
-					sb.Append("\n\t");
-					sb.AppendFormat("\"%s\"", file.filename.c_str());
-					
-					if (file.compile == false)
-						has_compile_disabled_files = true;
-				}
-
-				if (true)
-				{
-					// add chibi file to target
-
-					sb.Append("\n\t");
-					sb.AppendFormat("\"%s\"", library->chibi_file.c_str());
-				}
-				
-				sb.Append(")\n");
-				sb.Append("\n");
-				
-				if (library->prebuilt)
-				{
-					// special case: set imported library location
-					sb.Append("# (this library import is auto-generated from a embed_framework local library dependency)\n");
-					sb.Append("set_target_properties("); sb.Append(library->name.c_str());
-					sb.Append("\n\tPROPERTIES IMPORTED_LOCATION");
-					sb.Append("\n\t"); sb.Append(library->path.c_str());
-					sb.Append(")\n");
-					sb.Append("\n");
-				}
-				
-				if (library->group_name.empty() == false)
+				sb.Append("\tadd_definitions(-D__SSE2__)\n");
+				sb.Append("\tadd_definitions(-D__SSSE3__)\n");
+				sb.Append("endif ()\n");
+				sb.Append("\n");
+
+			// fixme : this should be defined through the user's workspace
+				if (s_platform == "macos")
 				{
-					sb.AppendFormat("set_target_properties(%s PROPERTIES FOLDER %s)\n\n",
-						library->name.c_str(),
-						library->group_name.c_str());
+					//sb.Append("add_compile_options(-mavx2)\n");
 				}
 				
-				if (has_compile_disabled_files)
+				if (s_platform == "windows")
 				{
-					sb.Append("set_source_files_properties(");
-					
-					for (auto & file : library->files)
-					{
-						if (file.compile == false)
-						{
-							sb.Append("\n\t");
-							sb.AppendFormat("\"%s\"", file.filename.c_str());
-						}
-					}
-					
-					sb.Append("\n\tPROPERTIES HEADER_FILE_ONLY 1");
-					
-					sb.Append(")\n");
+					// Windows.h defines min and max macros, which are always causing issues in portable code
+					// we can get rid of them by defining NOMINMAX before including Windows.h
+					sb.Append("add_definitions(-DNOMINMAX)\n");
 					sb.Append("\n");
 				}
+
+				// let CMake generate export definitions for all symbols it finds inside the generated object files, to normalize the behavior
+				// across Windows and Linux/OSX; which, Windows being the odd one out, both do by default
+			// todo : is this still needed ? we already have shared library support and the translation unit linkage feature to help us out
+				sb.Append("set(CMAKE_WINDOWS_EXPORT_ALL_SYMBOLS TRUE)\n");
+				sb.Append("\n");
 				
-				if (!write_header_paths(sb, *library))
-					return false;
-				
-				if (!write_compile_definitions(sb, *library))
-					return false;
-				
-				if (!write_library_dependencies(sb, *library))
-					return false;
-				
-				if (!write_package_dependencies(sb, *library))
-					return false;
+				// normalize the group delimiter to be '/'
+				sb.Append("set(SOURCE_GROUP_DELIMITER \"/\")\n");
+				sb.Append("\n");
 				
-				if (s_platform == "windows")
+				// add a 'Distribution' build type. this build type is used for making
+				// 'final' builds of an app. on Macos for instance, it creates a self-
+				// contained app bundle, including all of the dylibs, frameworks and
+				// resources referenced by the app
+				sb.Append("list(APPEND CMAKE_CONFIGURATION_TYPES Distribution)\n");
+				sb.Append("set(CMAKE_CXX_FLAGS_DISTRIBUTION \"${CMAKE_CXX_FLAGS_RELEASE} -DCHIBI_BUILD_DISTRIBUTION=1\")\n");
+				sb.Append("set(CMAKE_C_FLAGS_DISTRIBUTION \"${CMAKE_C_FLAGS_RELEASE} -DCHIBI_BUILD_DISTRIBUTION=1\")\n");
+				sb.Append("set(CMAKE_EXE_LINKER_FLAGS_DISTRIBUTION \"${CMAKE_EXE_LINKER_FLAGS_RELEASE}\")\n");
+				sb.Append("set(CMAKE_SHARED_LINKER_FLAGS_DISTRIBUTION \"${CMAKE_SHARED_LINKER_FLAGS_RELEASE}\")\n");
+				sb.Append("\n");
+
+			// todo : global compile options should be user-defined
+				if (is_platform("linux.raspberry-pi"))
 				{
-					sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY LINK_FLAGS \" /SAFESEH:NO\")\n", library->name.c_str());
-					sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4244\")\n", library->name.c_str()); // disable 'conversion from type A to B, possible loss of data' warning
-					sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4018\")\n", library->name.c_str()); // disable 'signed/unsigned mismatch' warning
-					
+					sb.Append("add_compile_options(-mcpu=cortex-a53)\n");
+					sb.Append("add_compile_options(-mfpu=neon-fp-armv8)\n");
+					sb.Append("add_compile_options(-mfloat-abi=hard)\n");
+					sb.Append("add_compile_options(-funsafe-math-optimizations)\n");
 					sb.Append("\n");
 				}
 				
-				if (library->objc_arc)
-				{
-					// note : we only support enabling ARC for Apple platforms right now
-					if (s_platform == "macos" || s_platform == "iphoneos")
-					{
-						sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" -fobjc-arc\")", library->name.c_str());
-					}
-				}
-				
-				if (!output(f, sb))
+				if (!output(output_sb, sb))
 					return false;
 			}
 			
-			for (auto & app : libraries)
+		#if 0
 			{
-				if (app->isExecutable == false)
-					continue;
+				// CMake has a nice ability where it shows you which include directories and compile-time definitions
+				// are used for the targets being processed. we don't enable this by default, since it generates a lot
+				// of messages, so it must be enabled here
 				
 				StringBuilder sb;
 				
-				sb.AppendFormat("# --- app %s ---\n", app->name.c_str());
-				sb.Append("\n");
-				
-				if (is_platform("android"))
-				{
-					// note : on android there are no real standalone executables,
-					//        only shared libraries, loaded by a Java-defined activity
-					sb.Append("add_library(");
-					sb.Append(app->name.c_str());
-					sb.Append("\n\tSHARED");
-				}
-				else
-				{
-					sb.Append("add_executable(");
-					sb.Append(app->name.c_str());
-					sb.Append("\n\tMACOSX_BUNDLE");
-				}
-				
-				for (auto & file : app->files)
-				{
-					sb.Append("\n\t");
-					sb.AppendFormat("\"%s\"", file.filename.c_str());
-				}
-
-				if (true)
-				{
-					// add chibi file to target
-					
-					sb.Append("\n\t");
-					sb.AppendFormat("\"%s\"", app->chibi_file.c_str());
-				}
-				
+				sb.Append("set(CMAKE_DEBUG_TARGET_PROPERTIES\n");
+				sb.Append("\tINCLUDE_DIRECTORIES\n");
+				sb.Append("\tCOMPILE_DEFINITIONS\n");
 				sb.Append(")\n");
-				sb.Append("\n");
-				
-				if (app->group_name.empty() == false)
-				{
-					sb.AppendFormat("set_target_properties(%s PROPERTIES FOLDER %s)\n",
-						app->name.c_str(),
-						app->group_name.c_str());
-					sb.Append("\n");
-				}
-
-				// copy app resources
 				
-				if (s_platform == "macos")
-				{
-					write_set_osx_bundle_path(sb, app->name.c_str());
-				}
-				else if (s_platform == "iphoneos")
-				{
-					write_set_ios_bundle_path(sb, app->name.c_str());
-				}
+				if (!output(output_sb, sb))
+					return false;
+			}
+		#endif
+		
+			if (!copy_aliased_header_paths(libraries))
+				return false;
+			
+			if (!generate_translation_unit_linkage_files(chibi_info, libraries))
+				return false;
+			
+			{
+				// search for packages and system libraries
 				
-				if (!app->resource_path.empty())
-				{
-					if (s_platform == "macos")
-					{
-						const char * resource_path = "${BUNDLE_PATH}/Contents/Resources";
-						
-						if (!write_copy_resources_for_distribution_using_rsync(sb, *app, *app, resource_path))
-							return false;
-						
-						sb.AppendFormat("target_compile_definitions(%s PRIVATE %sCHIBI_RESOURCE_PATH=\"%s\"%s)\n",
-							app->name.c_str(),
-							dont_makearchive_conditional_begin.c_str(),
-							app->resource_path.c_str(),
-							dont_makearchive_conditional_end.c_str());
-						sb.Append("\n");
-					}
-					else if (s_platform == "iphoneos")
-					{
-						const char * resource_path = "${BUNDLE_PATH}";
-						
-						if (!write_copy_resources_for_distribution_using_rsync(sb, *app, *app, resource_path))
-							return false;
-						
-						// note : for iphoneos we always copy resources (so a build can always be run and debugged on
-						//        a device). this means the main resource path will just be '.'
-						sb.AppendFormat("target_compile_definitions(%s PRIVATE CHIBI_RESOURCE_PATH=\".\")\n",
-							app->name.c_str());
-						sb.Append("\n");
-					}
-					else
-					{
-						sb.AppendFormat("target_compile_definitions(%s PRIVATE %sCHIBI_RESOURCE_PATH=\"%s\"%s)\n",
-							app->name.c_str(),
-							dont_makearchive_conditional_begin.c_str(),
-							app->resource_path.c_str(),
-							dont_makearchive_conditional_end.c_str());
-						sb.Append("\n");
-					}
-				}
+				StringBuilder sb;
 				
-				// copy library resources
+				sb.Append("# --- packages and system libraries ---\n");
+				sb.Append("\n");
 				
-				std::vector<ChibiLibraryDependency> all_library_dependencies;
-				if (!gather_all_library_dependencies(chibi_info, *app, all_library_dependencies))
+				if (!write_package_and_library_lookups(sb, libraries))
 					return false;
 				
-				for (auto & library_dependency : all_library_dependencies)
-				{
-					if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
-					{
-						auto * library = chibi_info.find_library(library_dependency.name.c_str());
-						
-						if (library->resource_path.empty() == false)
-						{
-							const char * resource_path = nullptr;
-							
-							if (s_platform == "macos")
-								resource_path = "${BUNDLE_PATH}/Contents/Resources/libs";
-							else if (s_platform == "iphoneos")
-								resource_path = "${BUNDLE_PATH}/libs";
-							else if (s_platform == "windows")
-								continue; // note : windows is handled separately in write_create_windows_app_archive
-							else if (s_platform == "android")
-								continue; // note : android assets are copied through gradle sync tasks
-							else
-								continue; // todo : add linux here
-							
-							assert(resource_path != nullptr);
-							if (resource_path != nullptr)
-							{
-								char destination_path[PATH_MAX];
-								concat(destination_path, sizeof(destination_path), resource_path, "/", library->name.c_str());
-								if (!write_copy_resources_for_distribution_using_rsync(sb, *app, *library, destination_path))
-									return false;
-							}
-						}
-					}
-				}
+				if (!output(output_sb, sb))
+					return false;
+			}
+			
+			// generate the output for each library and app concurrently. the results are output in a fixed order
+			// afterwards, so the generated file doesn't depend on the order in which the tasks finish
+			
+			struct TargetOutput
+			{
+				StringBuilder sb;
+				StringBuilder source_groups_sb;
 				
-				// copy library license files
+				bool result = false;
+			};
+			
+			std::vector<TargetOutput> target_outputs(libraries.size());
+			
+			{
+				TaskGroup task_group;
 				
-				for (auto & library_dependency : all_library_dependencies)
+				for (size_t i = 0; i < libraries.size(); ++i)
 				{
-					if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
-					{
-						auto * library = chibi_info.find_library(library_dependency.name.c_str());
-					
-						if (library->license_files.empty() == false)
+					task_group.add([&, i]()
 						{
-							const char * license_path = nullptr;
+							const ChibiLibrary & library = *libraries[i];
+							
+							TargetOutput & target_output = target_outputs[i];
 							
-							if (s_platform == "macos")
-								license_path = "${BUNDLE_PATH}/Contents/license";
-							else if (s_platform == "iphoneos")
-								license_path = "${BUNDLE_PATH}/license";
+							if (library.isExecutable)
+								target_output.result = write_app(chibi_info, library, target_output.sb);
 							else
-								continue; // todo : add windows and linux here
+								target_output.result = write_library(chibi_info, library, target_output.sb);
 							
-							assert(license_path != nullptr);
-							if (license_path != nullptr)
-							{
-								char destination_path[PATH_MAX];
-								concat(destination_path, sizeof(destination_path), license_path, "/", library->name.c_str());
-								
-								if (!write_copy_license_files_for_distribution_using_rsync(sb, *app, *library, destination_path))
-									return false;
-							}
-						}
-					}
+							if (target_output.result)
+								target_output.result = write_source_groups(library, target_output.source_groups_sb);
+						});
 				}
 				
-				if (!write_app_resource_paths(chibi_info, sb, *app, all_library_dependencies))
-					return false;
-				
-				if (!write_header_paths(sb, *app))
-					return false;
-				
-				if (!write_compile_definitions(sb, *app))
-					return false;
-				
-				if (!write_library_dependencies(sb, *app))
-					return false;
-				
-				if (!write_package_dependencies(sb, *app))
-					return false;
-				
-				if (!write_embedded_app_files(chibi_info, sb, *app, all_library_dependencies))
+				task_group.wait();
+			}
+			
+			for (auto & target_output : target_outputs)
+				if (target_output.result == false)
 					return false;
-				
-				if (s_platform == "windows")
-				{
-					sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY LINK_FLAGS \" /SAFESEH:NO\")\n", app->name.c_str());
-					sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4244\")\n", app->name.c_str()); // disable 'conversion from type A to B, possible loss of data' warning
-					sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" /wd4018\")\n", app->name.c_str()); // disable 'signed/unsigned mismatch' warning
-					
-					sb.Append("\n");
-				}
-				
-				if (app->objc_arc)
-				{
-					// note : we only support enabling ARC for Apple platforms right now
-					if (s_platform == "macos" || s_platform == "iphoneos")
-					{
-						sb.AppendFormat("set_property(TARGET %s APPEND_STRING PROPERTY COMPILE_FLAGS \" -fobjc-arc\")", app->name.c_str());
-					}
-				}
-				
-				if (s_platform == "macos" || s_platform == "iphoneos")
-				{
-					// note : APPLE_GUI_IDENTIFIER must be set before generate_plist
-					// todo : imagine a clean way to set the identifier
-					sb.AppendFormat("set(APPLE_GUI_IDENTIFIER \"com.chibi.%s\")\n",
-						app->name.c_str());
-				}
-				
-				if (s_platform == "macos" || s_platform == "iphoneos")
+			
+			for (size_t i = 0; i < libraries.size(); ++i)
+			{
+				if (libraries[i]->isExecutable == false)
 				{
-					// generate plist text
-					
-					std::string text;
-					
-				// todo : let these plist flags originate from apps/libraries that need them
-				// todo : add opportunity to merge with custom plist files, for advanced plist settings
-					if (!generate_plist(nullptr, app->name.c_str(),
-						kPlistFlag_HighDpi |
-						kPlistFlag_AccessWebcam |
-						kPlistFlag_AccessMicrophone,
-						text))
-					{
-						report_error(nullptr, "failed to generate plist file");
-						return false;
-					}
-					
-					// write the plist file to disk
-					
-					char plist_path[PATH_MAX];
-					if (!concat(plist_path, sizeof(plist_path), generated_path, "/", app->name.c_str(), ".plist"))
-					{
-						report_error(nullptr, "failed to create plist path");
-						return false;
-					}
-
-					if (!write_text_to_file_if_contents_changed(sb, text.c_str(), plist_path))
+					if (!output_target(output_sb, *libraries[i], target_outputs[i].sb))
 						return false;
-
-					// tell cmake to use our generated plist file
-					
-					sb.AppendFormat("set_target_properties(%s PROPERTIES MACOSX_BUNDLE_INFO_PLIST \"%s\")\n",
-						app->name.c_str(),
-						plist_path);
-					sb.Append("\n");
-				}
-
-				if (s_platform == "macos")
-				{
-					// add rpath to the generated executable so that it can find dylibs inside the location of the executable itself. this is needed when copying generated shared libraries into the app bundle
-					
-					// note : we use a conditional to check if we're building a distribution app bundle
-					//        ideally CMake would have build config dependent custom commands,
-					//        but since it doesn't, we prepend 'echo' to the command, depending on
-					//        whether this is a distribution build or not
-				
-				// fixme : cmake is broken and always runs the custom command, regardless of whether the DEPENDS target is dirty or not. this causes install_name_tool to fail, as the rpath has already been set. I've appended "|| true" at the end of the command, to effectively ignore the return code from install_name_tool. a nasty side effect of this is we don't know whether the command succeeded or actually failed for some valid reason.. so ideally this hack is removed once cmake's behavior is fixed
-				
-					write_custom_command_for_distribution_va(sb,
-						app->name.c_str(),
-						app->name.c_str(),
-						"install_name_tool -add_rpath \"@executable_path\" \"${BUNDLE_PATH}/Contents/MacOS/%s\" || true",
-						app->name.c_str());
-				}
-				
-				if (s_platform == "windows")
-				{
-					write_create_windows_app_archive(chibi_info, sb, *app, all_library_dependencies);
 				}
+			}
 			
-				if (s_platform == "macos" || s_platform == "iphoneos")
-				{
-					// unset bundle path when we're done processing this app
-					sb.Append("unset(BUNDLE_PATH)\n\n");
-				}
-				
-				if (s_platform == "macos" || s_platform == "iphoneos")
+			for (size_t i = 0; i < libraries.size(); ++i)
+			{
+				if (libraries[i]->isExecutable)
 				{
-					// unset apple app identifier when we're done processing this app
-					sb.Append("unset(APPLE_GUI_IDENTIFIER)");
+					if (!output_target(output_sb, *libraries[i], target_outputs[i].sb))
+						return false;
 				}
-
-				if (!output(f, sb))
-					return false;
 			}
 			
-			for (auto & library : libraries)
+			for (size_t i = 0; i < libraries.size(); ++i)
 			{
-				bool empty = true;
-				
-				StringBuilder sb;
-				
-				sb.AppendFormat("# --- source group memberships for %s ---\n", library->name.c_str());
-				sb.Append("\n");
-				
-				std::map<std::string, std::vector<ChibiLibraryFile*>> files_by_group;
-
-				for (auto & file : library->files)
-				{
-					auto & group_files = files_by_group[file.group];
-					
-					group_files.push_back(&file);
-				}
-				
-				for (auto & group_files_itr : files_by_group)
-				{
-					auto & group = group_files_itr.first;
-					auto & files = group_files_itr.second;
-				
-				#if 0
-					printf("group: %s\n", group.c_str());
-				#endif
-					
-					sb.AppendFormat("source_group(\"%s\" FILES", group.c_str());
-					
-					for (auto & file : files)
-						sb.AppendFormat("\n\t\"%s\"", file->filename.c_str());
-					
-					sb.Append(")\n");
-					sb.Append("\n");
-				
-					empty = false;
-				}
-				
-				if (empty == false)
+				if (target_outputs[i].source_groups_sb.text.empty() == false)
 				{
-					if (!output(f, sb))
+					if (!output_target(output_sb, *libraries[i], target_outputs[i].source_groups_sb))
 						return false;
 				}
 			}
 			
-			f.close();
+			
+		}
+		
+		if (split_targets)
+		{
+			if (!write_target_files(output_sb, libraries, output_filename))
+				return false;
+		}
+		
+		if (!write_output_file(output_sb.text.c_str(), output_filename))
+		{
+			report_error(nullptr, "failed to write output file: %s", output_filename);
+			return false;
 		}
 		
 		return true;
@@ -1927,10 +3428,35 @@ struct CMakeWriter
 
 namespace chibi
 {
-	bool write_cmake_file(const ChibiInfo & chibi_info, const char * platform, const char * output_filename)
+	bool write_cmake_file(const ChibiInfo & chibi_info, const char * platform, const char * output_filename, const ChibiOptions & options, const std::vector<std::string> & regenerate_command, const char * regenerate_working_directory, std::vector<std::string> & input_paths, std::vector<std::string> & output_paths)
 	{
 		CMakeWriter writer;
+		writer.split_targets = options.split_targets;
+		writer.compact = options.compact;
+		writer.regenerate_command = regenerate_command;
+		writer.regenerate_working_directory = regenerate_working_directory;
+		writer.check_conglomerates = options.check_conglomerates || options.split_conglomerates;
+		writer.split_conglomerates = options.split_conglomerates;
+		
+		BuildLog build_log;
+		
+		if (options.build_log.empty() == false)
+		{
+			if (!build_log.load(options.build_log.c_str()))
+			{
+				report_error(nullptr, "failed to read build log: %s. note that compile times are only recorded by the Ninja generator", options.build_log.c_str());
+				return false;
+			}
+			
+			writer.build_log = &build_log;
+		}
 		
-		return writer.write(chibi_info, platform, output_filename);
+		if (!writer.write(chibi_info, platform, output_filename))
+			return false;
+		
+		input_paths.insert(input_paths.end(), writer.input_paths.begin(), writer.input_paths.end());
+		output_paths.insert(output_paths.end(), writer.output_paths.begin(), writer.output_paths.end());
+		
+		return true;
 	}
 }
@@ -70,6 +70,10 @@ static S s;
 
 static std::string fn;
 
+static std::vector<std::string> s_dirs; // the directories entered using push_dir, relative to the working directory chibi was invoked from
+
+static std::vector<std::string> s_output_paths; // the files written, including the ones left untouched as their contents didn't change
+
 static void beginFile(const char * filename)
 {
 	fn = filename;
@@ -84,6 +88,15 @@ static bool endFile()
 		report_error(nullptr, "failed to write file contents");
 		result = false;
 	}
+	else
+	{
+		std::string path;
+		
+		for (auto & dir : s_dirs)
+			path += dir + "/";
+		
+		s_output_paths.push_back(path + fn);
+	}
 	
 	s.text.clear();
 	
@@ -113,6 +126,8 @@ static bool push_dir(const char * path)
 		report_error(nullptr, "failed to change directory");
 		return false;
 	}
+	
+	s_dirs.push_back(path);
 
 	return true;
 }
@@ -124,6 +139,8 @@ static bool pop_dir()
 		report_error(nullptr, "failed to change directory");
 		return false;
 	}
+	
+	s_dirs.pop_back();
 
 	return true;
 }
@@ -248,48 +265,6 @@ static const char * libstrip_name(const char * name)
 namespace chibi
 {
 #if NATIVE_BUILD_TYPE != NB_CMAKE
-	static bool gather_all_library_dependencies(const ChibiInfo & chibi_info, const ChibiLibrary & library, std::vector<ChibiLibraryDependency> & library_dependencies)
-	{
-		std::set<std::string> traversed_libraries;
-		std::deque<const ChibiLibrary*> stack;
-		
-		stack.push_back(&library);
-		
-		traversed_libraries.insert(library.name);
-		
-		while (stack.empty() == false)
-		{
-			const ChibiLibrary * library = stack.front();
-			
-			for (auto & library_dependency : library->library_dependencies)
-			{
-				if (traversed_libraries.count(library_dependency.name) == 0)
-				{
-					traversed_libraries.insert(library_dependency.name);
-					
-					library_dependencies.push_back(library_dependency);
-					
-					if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
-					{
-						const ChibiLibrary * resolved_library = chibi_info.find_library(library_dependency.name.c_str());
-						
-						if (resolved_library == nullptr)
-						{
-							report_error(nullptr, "failed to resolve library dependency: %s for library %s", library_dependency.name.c_str(), library->name.c_str());
-							return false;
-						}
-
-						stack.push_back(resolved_library);
-					}
-				}
-			}
-			
-			stack.pop_front();
-		}
-		
-		return true;
-	}
-	
 	static bool generate_translation_unit_linkage_files(const ChibiInfo & chibi_info, const char * generated_path, const std::vector<ChibiLibrary*> & libraries)
 	{
 		// generate translation unit linkage files
@@ -299,18 +274,18 @@ namespace chibi
 			if (app->isExecutable == false)
 				continue;
 
-			std::vector<ChibiLibraryDependency> all_library_dependencies;
-			if (!gather_all_library_dependencies(chibi_info, *app, all_library_dependencies))
+			auto * all_library_dependencies = chibi_info.dependency_graph.get_all_library_dependencies(*app);
+			if (all_library_dependencies == nullptr)
 				return false;
 
 			std::vector<std::string> link_translation_unit_using_function_calls;
 			
-			for (auto & library_dependency : all_library_dependencies)
+			for (auto * library_dependency : *all_library_dependencies)
 			{
-				if (library_dependency.type != ChibiLibraryDependency::kType_Generated)
+				if (library_dependency->type != ChibiLibraryDependency::kType_Generated)
 					continue;
 
-				auto * library = chibi_info.find_library(library_dependency.name.c_str());
+				auto * library = library_dependency->library;
 
 				link_translation_unit_using_function_calls.insert(
 					link_translation_unit_using_function_calls.end(),
@@ -351,6 +326,8 @@ namespace chibi
 					return false;
 				}
 				
+				s_output_paths.push_back(full_path);
+				
 				// add the translation unit linkage file to the list of app files
 				
 				ChibiLibraryFile file;
@@ -384,7 +361,7 @@ namespace chibi
 			
 			if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
 			{
-				ChibiLibrary * found_library = chibi_info.find_library(library_dependency.name.c_str());
+				ChibiLibrary * found_library = library_dependency.library;
 				
 				if (found_library == nullptr)
 				{
@@ -421,8 +398,10 @@ namespace chibi
 		return true;
 	}
 
-	bool write_gradle_files(const ChibiInfo & chibi_info, const char * output_path)
+	bool write_gradle_files(const ChibiInfo & chibi_info, const char * output_path, std::vector<std::string> & output_paths)
 	{
+		s_output_paths.clear();
+		
 		// gather the library targets to emit
 		
 		std::set<std::string> traversed_libraries;
@@ -621,7 +600,7 @@ namespace chibi
 						{
 							if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
 							{
-								auto * library = chibi_info.find_library(library_dependency.name.c_str());
+								auto * library = library_dependency.library;
 								
 								if (library->resource_path.empty() == false)
 								{
@@ -642,7 +621,7 @@ namespace chibi
 						{
 							if (library_dependency.type == ChibiLibraryDependency::kType_Generated)
 							{
-								auto * library = chibi_info.find_library(library_dependency.name.c_str());
+								auto * library = library_dependency.library;
 								
 								if (library->resource_path.empty() == false)
 								{
@@ -1022,6 +1001,8 @@ namespace chibi
 		
 		if (!pop_dir())
 			return false;
+		
+		output_paths.insert(output_paths.end(), s_output_paths.begin(), s_output_paths.end());
 
 		return true;
 	}